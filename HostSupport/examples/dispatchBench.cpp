@@ -0,0 +1,195 @@
+/*
+Software License :
+
+Copyright (c) 2007, The Open Effects Association Ltd. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+   * Neither the name The Open Effects Association Ltd, nor the names of its 
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+   
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+   ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+////////////////////////////////////////////////////////////////////////////////
+/// This example times how long a plugin takes to dispatch an action.
+///
+/// It loads a plugin, makes a filter instance of it, and then calls a few
+/// cheap actions many times, printing the mean time per call. The actions
+/// are either handed straight to the plugin's main entry, which measures
+/// the plugin side dispatch alone, or go through the host's action calls,
+/// which also build the in and out argument property sets.
+///
+/// The action strings are copied first, so a plugin can't match them on
+/// their address, just as with a host that is not built with the same
+/// headers.
+///
+/// Usage is
+///
+///     dispatchBench [pluginId [iterations]]
+///
+/// which defaults to the example invert plugin and 200000 iterations. Set
+/// OFX_PLUGIN_PATH so that the plugin can be found. To compare two versions
+/// of the C++ support library, build the plugin against each in turn and
+/// run this against both.
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <cassert>
+#include <string>
+#include <map>
+
+// ofx
+#include "ofxCore.h"
+#include "ofxImageEffect.h"
+
+// ofx host
+#include "ofxhUtilities.h"
+#include "ofxhPluginCache.h"
+#include "ofxhImageEffect.h"
+#include "ofxhImageEffectAPI.h"
+
+// my host
+#include "hostDemoHostDescriptor.h"
+
+/// print the mean time of a timed loop
+static void report(const char *name, double start, int nIterations)
+{
+  double nsPerCall = (OFX::GetTimeInSeconds() - start) * 1e9 / nIterations;
+  std::cout << "  " << std::left << std::setw(44) << name
+            << std::right << std::setw(10) << std::fixed << std::setprecision(1) << nsPerCall << " ns" << std::endl;
+}
+
+/// call an action straight through the plugin's main entry, with no arguments
+static void timeMainEntry(OfxPlugin *ofxPlugin, OfxImageEffectHandle handle, const char *action, int nIterations)
+{
+  // a host side copy of the action string
+  std::string actionCopy(action);
+
+  double start = OFX::GetTimeInSeconds();
+  for(int i = 0; i < nIterations; ++i) {
+    ofxPlugin->mainEntry(actionCopy.c_str(), handle, NULL, NULL);
+  }
+  report(action, start, nIterations);
+}
+
+int main(int argc, char **argv) 
+{
+  std::string pluginId = argc > 1 ? argv[1] : "net.sf.openfx.invertPlugin";
+  int nIterations = argc > 2 ? std::atoi(argv[2]) : 200000;
+  if(nIterations <= 0)
+    nIterations = 1;
+
+  OFX::Host::PluginCache::getPluginCache()->setCacheVersion("dispatchBenchV1");
+
+  MyHost::Host myHost;
+  OFX::Host::ImageEffect::PluginCache imageEffectPluginCache(&myHost);
+  imageEffectPluginCache.registerInCache(*OFX::Host::PluginCache::getPluginCache());
+  OFX::Host::PluginCache::getPluginCache()->scanPluginFiles();
+
+  OFX::Host::ImageEffect::ImageEffectPlugin* plugin = imageEffectPluginCache.getPluginById(pluginId);
+  if(!plugin) {
+    std::cerr << "could not find plugin " << pluginId << ", is OFX_PLUGIN_PATH set?" << std::endl;
+    return 1;
+  }
+
+  OFX::Host::auto_ptr<OFX::Host::ImageEffect::Instance> instance(plugin->createInstance(kOfxImageEffectContextFilter, NULL));
+  if(!instance.get()) {
+    std::cerr << "could not make a filter instance of " << pluginId << std::endl;
+    return 1;
+  }
+
+  OfxStatus stat = instance->createInstanceAction();
+  if(stat != kOfxStatOK && stat != kOfxStatReplyDefault) {
+    std::cerr << "create instance failed on " << pluginId << std::endl;
+    return 1;
+  }
+  bool ok = instance->getClipPreferences();
+  assert(ok);
+  (void)ok;
+
+  OfxPlugin *ofxPlugin = plugin->getPluginHandle()->getOfxPlugin();
+  OfxImageEffectHandle handle = instance->getHandle();
+
+  std::cout << pluginId << ", " << nIterations << " calls each" << std::endl;
+
+  std::cout << "main entry" << std::endl;
+  timeMainEntry(ofxPlugin, handle, kOfxActionPurgeCaches, nIterations);
+  timeMainEntry(ofxPlugin, handle, kOfxActionSyncPrivateData, nIterations);
+  timeMainEntry(ofxPlugin, handle, kOfxActionEndInstanceEdit, nIterations);
+  // not an action any plugin knows, so it walks the whole dispatch
+  timeMainEntry(ofxPlugin, handle, "net.sf.openfx.dispatchBench.unknown", nIterations);
+
+  OfxPointD renderScale;
+  renderScale.x = renderScale.y = 1.0;
+
+  OfxRectI renderWindow;
+  renderWindow.x1 = renderWindow.y1 = 0;
+  renderWindow.x2 = 720;
+  renderWindow.y2 = 576;
+
+  OfxRectD regionOfInterest;
+  regionOfInterest.x1 = regionOfInterest.y1 = 0;
+  regionOfInterest.x2 = 720;
+  regionOfInterest.y2 = 576;
+
+  std::cout << "host actions" << std::endl;
+
+  double start = OFX::GetTimeInSeconds();
+  for(int i = 0; i < nIterations; ++i) {
+    OfxTime identityTime = 0;
+#ifdef OFX_EXTENSIONS_NUKE
+    int identityView = 0;
+    std::string identityPlane;
+#endif
+    std::string identityClip;
+    instance->isIdentityAction(identityTime, kOfxImageFieldNone, renderWindow, renderScale,
+#ifdef OFX_EXTENSIONS_NUKE
+                               identityView, identityPlane,
+#endif
+                               identityClip);
+  }
+  report(kOfxImageEffectActionIsIdentity, start, nIterations);
+
+  start = OFX::GetTimeInSeconds();
+  for(int i = 0; i < nIterations; ++i) {
+    OfxRectD rod;
+    instance->getRegionOfDefinitionAction(0, renderScale,
+#ifdef OFX_EXTENSIONS_NUKE
+                                          0,
+#endif
+                                          rod);
+  }
+  report(kOfxImageEffectActionGetRegionOfDefinition, start, nIterations);
+
+  start = OFX::GetTimeInSeconds();
+  for(int i = 0; i < nIterations; ++i) {
+    std::map<OFX::Host::ImageEffect::ClipInstance *, OfxRectD> rois;
+    instance->getRegionOfInterestAction(0, renderScale,
+#ifdef OFX_EXTENSIONS_NUKE
+                                        0,
+#endif
+                                        regionOfInterest, rois);
+  }
+  report(kOfxImageEffectActionGetRegionsOfInterest, start, nIterations);
+
+  instance->destroyInstanceAction();
+  return 0;
+}
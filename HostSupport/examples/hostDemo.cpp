@@ -42,6 +42,7 @@ modification, are permitted provided that the following conditions are met:
 // ofx host
 #include "ofxhBinary.h"
 #include "ofxhPropertySuite.h"
+#include "ofxhPropertyProfiler.h"
 #include "ofxhClip.h"
 #include "ofxhParam.h"
 #include "ofxhMemory.h"
@@ -116,26 +117,39 @@ int main(int argc, char **argv)
   // register the image effect cache with the global plugin cache
   imageEffectPluginCache.registerInCache(*OFX::Host::PluginCache::getPluginCache());
 
-  // try to read an old cache
-  std::ifstream ifs("hostDemoPluginCache.xml");
-  try {
-    OFX::Host::PluginCache::getPluginCache()->readCache(ifs);
-  } catch (const std::exception &e) {
-    std::cerr << "Error while reading XML cache: " << e.what() << std::endl;
+  // if the cache started us to describe a plugin binary, do that and nothing else
+  int workerStatus;
+  if(OFX::Host::PluginCache::getPluginCache()->runDescribeWorker(argc, argv, workerStatus))
+    return workerStatus;
+
+  // try to read an old cache, the binary one is quicker, the XML one is there to be looked at
+  if(!OFX::Host::PluginCache::getPluginCache()->readBinaryCache("hostDemoPluginCache.bin")) {
+    std::ifstream ifs("hostDemoPluginCache.xml");
+    try {
+      OFX::Host::PluginCache::getPluginCache()->readCache(ifs);
+    } catch (const std::exception &e) {
+      std::cerr << "Error while reading XML cache: " << e.what() << std::endl;
+    }
+    ifs.close();
   }
   OFX::Host::PluginCache::getPluginCache()->scanPluginFiles();
-  ifs.close();
 
   /// flush out the current cache
   std::ofstream of("hostDemoPluginCache.xml");
   OFX::Host::PluginCache::getPluginCache()->writePluginCache(of);
   of.close();
+  std::ofstream bof("hostDemoPluginCache.bin", std::ios::out | std::ios::binary);
+  OFX::Host::PluginCache::getPluginCache()->writeBinaryCache(bof);
+  bof.close();
 
   // get the invert example plugin which uses the OFX C++ support code
   OFX::Host::ImageEffect::ImageEffectPlugin* plugin = imageEffectPluginCache.getPluginById("net.sf.openfx:invertPlugin");
 
   imageEffectPluginCache.dumpToStdOut();
 
+  // show which bundles made us slow to start, if anything had to be loaded
+  OFX::Host::PluginCache::getPluginCache()->dumpLoadTimingsToStdOut();
+
   if(plugin) {
     // create an instance of it as a filter
     // the first arg is the context, the second is client data we are allowed to pass down the call chain
@@ -325,6 +339,10 @@ int main(int argc, char **argv)
                                 , 0 /* view*/
 #                               endif
                                 );
+
+      // if OFX_PROPERTY_PROFILE is set, show how the plugin used the property suite
+      if(OFX::Host::Property::Profiler::isEnabled())
+        OFX::Host::Property::Profiler::dump(std::cout);
     }
   }
   OFX::Host::PluginCache::clearPluginCache();
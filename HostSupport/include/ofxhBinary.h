@@ -69,6 +69,7 @@ namespace OFX
     time_t _time;
     off_t _size;
     int _users;
+    double _loadTime;
   public :
 
     /// create object representing the binary.  will stat() it, 
@@ -80,6 +81,11 @@ namespace OFX
     // calls stat, returns true if successfull, false otherwise
     static bool getFileModTimeAndSize(const std::string &binaryPath, time_t& modificationTime, off_t& fileSize);
 
+    /// Hash the contents of a file (64 bit FNV-1a, as hex), so a binary that has only been
+    /// touched or copied over with the same bytes can be told apart from a changed one.
+    /// Returns false if the file couldn't be read.
+    static bool getFileContentHash(const std::string &binaryPath, std::string &hash);
+
     bool isLoaded() const { return _dlHandle != 0; }
 
     /// is this binary invalid? (did the a stat() or load() on the file fail,
@@ -104,6 +110,9 @@ namespace OFX
     /// open the binary.
     void load();
 
+    /// wall clock seconds the last call to load() took, 0 if it has never been loaded
+    double getLoadTime() const { return _loadTime; }
+
     /// close the binary
     void unload();
 
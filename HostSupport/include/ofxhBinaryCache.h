@@ -0,0 +1,220 @@
+
+/*
+Software License :
+
+Copyright (c) 2007-2009, The Open Effects Association Ltd. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+* Neither the name The Open Effects Association Ltd, nor the names of its 
+contributors may be used to endorse or promote products derived from this
+software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OFX_BINARY_CACHE_H
+#define OFX_BINARY_CACHE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <iosfwd>
+
+#include "ofxhPropertySuite.h"
+
+namespace OFX {
+
+  namespace Host {
+
+    /// A binary alternative to the XML plugin cache.
+    ///
+    /// The file is a header, a string table and flat arrays of fixed layout records for the
+    /// binaries, the plugins in them and the property sets each plugin API handler wants
+    /// kept. Records refer to each other by index and to strings by byte offset into the
+    /// string table, so the file is used where it is memory mapped, with no parsing. A
+    /// property set is only decoded into a Property::Set when someone asks for it.
+    ///
+    /// The layout is that of the machine writing it. A file from a different format
+    /// version, byte order or cache version is rejected, as is one that fails its checks.
+    namespace BinaryCache {
+
+      typedef unsigned int UInt32;
+      typedef long long    Int64;
+
+      /// bumped whenever the layout below changes
+      const UInt32 kFormatVersion = 2;
+
+      /// where a table is in the file
+      struct Section {
+        UInt32 offset; ///< in bytes from the start of the file, a multiple of 8
+        UInt32 count;  ///< number of records, or bytes for the string table
+      };
+
+      struct Header {
+        char    magic[8];      ///< "OFXHBCF" and a nul
+        UInt32  formatVersion; ///< kFormatVersion
+        UInt32  byteOrder;     ///< 0x01020304 as written
+        UInt32  cacheVersion;  ///< string, see PluginCache::setCacheVersion()
+        UInt32  pad;
+        Section strings;       ///< nul terminated strings, one after the other
+        Section binaries;      ///< BinaryRecords
+        Section plugins;       ///< PluginRecords
+        Section sets;          ///< SetRecords
+        Section properties;    ///< PropertyRecords
+        Section values;        ///< Values
+      };
+
+      struct BinaryRecord {
+        Int64  mtime;
+        Int64  size;
+        UInt32 path;           ///< string
+        UInt32 bundlePath;     ///< string
+        UInt32 isStatic;       ///< the statically linked plugins of the host
+        UInt32 firstPlugin;
+        UInt32 nPlugins;
+        UInt32 hash;           ///< string, the hash of the binary's contents, empty if not taken
+      };
+
+      struct PluginRecord {
+        UInt32 identifier;     ///< string, the raw identifier
+        UInt32 api;            ///< string
+        int    index;
+        int    apiVersion;
+        int    versionMajor;
+        int    versionMinor;
+        UInt32 firstSet;
+        UInt32 nSets;
+      };
+
+      /// a property set, tagged so the API handler knows what it is for
+      struct SetRecord {
+        UInt32 tag;            ///< string, eg: "descriptor"
+        UInt32 name;           ///< string, eg: the name of a param, may be ""
+        UInt32 type;           ///< string, eg: the type of a param, may be ""
+        UInt32 firstProperty;
+        UInt32 nProperties;
+        UInt32 pad;
+      };
+
+      struct PropertyRecord {
+        UInt32 name;           ///< string
+        UInt32 type;           ///< a Property::TypeEnum, pointers are never written
+        int    fixedDimension; ///< 0 for a variable dimension
+        UInt32 dimension;
+        UInt32 firstValue;
+        UInt32 pad;
+      };
+
+      union Value {
+        Int64  i;              ///< an int
+        double d;              ///< a double
+        UInt32 s;              ///< a string
+      };
+
+      /// builds a binary cache in memory, then writes it out
+      class Writer {
+        std::string                    _strings;
+        std::map<std::string, UInt32>  _stringOffsets;
+        UInt32                         _cacheVersion;
+        std::vector<BinaryRecord>      _binaries;
+        std::vector<PluginRecord>      _plugins;
+        std::vector<SetRecord>         _sets;
+        std::vector<PropertyRecord>    _properties;
+        std::vector<Value>             _values;
+
+      public :
+        explicit Writer(const std::string &cacheVersion);
+
+        /// the offset of a string in the string table, adding it if need be
+        UInt32 addString(const std::string &s);
+
+        /// start a binary, the plugins added after go in it
+        void addBinary(const std::string &path, const std::string &bundlePath, Int64 mtime, Int64 size, bool isStatic,
+                       const std::string &hash);
+
+        /// start a plugin in the last binary, the sets added after go in it
+        void addPlugin(const std::string &identifier, const std::string &api, int index,
+                       int apiVersion, int versionMajor, int versionMinor);
+
+        /// add a property set to the last plugin, pointer properties are skipped
+        void addSet(const std::string &tag, const std::string &name, const std::string &type, const Property::Set &set);
+
+        /// write the file
+        void write(std::ostream &os) const;
+      };
+
+      /// a memory mapped binary cache
+      class Reader {
+        class MappedFile;
+        MappedFile          *_file;
+        std::vector<Int64>   _buffer;   ///< what read() was given, as 64 bit words so the records are aligned
+        const char          *_data;
+        size_t               _size;
+        const Header        *_header;
+
+        Reader(const Reader &);
+        Reader &operator=(const Reader &);
+
+        /// are count records of the given size at offset inside the file
+        bool inFile(UInt32 offset, UInt32 count, size_t recordSize) const;
+
+        /// check everything refers to things which exist, so nothing needs checking later
+        bool validate(const std::string &cacheVersion, std::string &why) const;
+
+        /// use the cache in data, which we hold on to, emptying the reader if it can't be used
+        bool use(const char *data, size_t size, const std::string &cacheVersion, std::string &why);
+
+        /// let go of the cache
+        void reset();
+
+      public :
+        Reader();
+        ~Reader();
+
+        /// Map a cache file. Returns false, with the reason in why, if the file is missing or
+        /// can't be used, in which case the reader is left empty.
+        bool open(const std::string &path, const std::string &cacheVersion, std::string &why);
+
+        /// As open(), but the cache is in memory, eg sent down a pipe. The data is copied.
+        bool read(const std::string &data, const std::string &cacheVersion, std::string &why);
+
+        UInt32 getNBinaries() const { return _header ? _header->binaries.count : 0; }
+
+        const char *getString(UInt32 offset) const { return _data + _header->strings.offset + offset; }
+        const BinaryRecord &getBinary(UInt32 i) const { return records<BinaryRecord>(_header->binaries)[i]; }
+        const PluginRecord &getPlugin(UInt32 i) const { return records<PluginRecord>(_header->plugins)[i]; }
+        const SetRecord &getSet(UInt32 i) const { return records<SetRecord>(_header->sets)[i]; }
+
+        /// decode a set into a property set, adding any properties it does not have
+        void readSet(const SetRecord &record, Property::Set &set) const;
+
+      private :
+        template<class T> const T *records(const Section &section) const
+        {
+          return reinterpret_cast<const T *>(_data + section.offset);
+        }
+      };
+
+    }
+
+  }
+
+}
+
+#endif
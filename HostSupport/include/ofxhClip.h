@@ -34,6 +34,10 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "ofxImageEffect.h"
 #include "ofxhUtilities.h"
 
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1900)
+#include <atomic>
+#endif
+
 namespace OFX {
 
   namespace Host {
@@ -385,7 +389,11 @@ namespace OFX {
       protected :
         /// called during ctors to get bits from the clip props into ours
         void getClipBits(ClipInstance& instance);
+#     if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1900)
+        std::atomic<int> _referenceCount; ///< reference count on this image, which may be shared between render threads
+#     else
         int _referenceCount; ///< reference count on this image
+#     endif
 
       public:
         // default constructor
@@ -457,6 +465,9 @@ namespace OFX {
 
         /// add a reference to this image
         void addReference() {_referenceCount++;}
+
+        /// the current number of references to this image
+        int getReferenceCount() const {return _referenceCount;}
       };
 
       /// instance of an image inside an image effect
@@ -0,0 +1,154 @@
+
+/*
+Software License :
+
+Copyright (c) 2007-2009, The Open Effects Association Ltd. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+* Neither the name The Open Effects Association Ltd, nor the names of its 
+contributors may be used to endorse or promote products derived from this
+software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OFX_GRAPH_H
+#define OFX_GRAPH_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "ofxCore.h"
+
+#include "ofxhRenderScheduler.h"
+
+namespace OFX {
+
+  namespace Host {
+
+    namespace ImageEffect {
+
+      // forward declare
+      class ClipInstance;
+      class Instance;
+
+      /// A graph of effect instances, where the output of one instance feeds input clips of others.
+      ///
+      /// To render a region of a node at a frame the graph makes three passes over the nodes
+      /// upstream of it,
+      ///   - a frames needed pass, downstream first, finding which frames of each node are read,
+      ///   - a region of definition pass, upstream first, at each of those frames,
+      ///   - a region of interest pass, downstream first, finding the union of the regions asked
+      ///     of each node at each frame, clipped to its region of definition,
+      /// then renders each node at each frame, upstream first, over just the region asked of it.
+      /// Frames and nodes that nothing reads are not rendered at all.
+      ///
+      /// The graph does not hold images. A host's input clips find the node feeding them with
+      /// getInput(), answer getRegionOfDefinition() with Graph::getRegionOfDefinition(), and the
+      /// host overrides renderNode() to keep the images its clips go on to hand out.
+      ///
+      /// Graphs are not thread safe, though renderNode may render a node on several threads.
+      class Graph {
+      public:
+        /// regions by frame, in canonical coordinates
+        typedef std::map<OfxTime, OfxRectD> RegionMap;
+
+        Graph();
+        virtual ~Graph();
+
+        /// add a node to the graph, the graph does not own the instance
+        void addNode(Instance *node);
+
+        /// remove a node and all its connections from the graph
+        void removeNode(Instance *node);
+
+        /// the nodes in the order they were added
+        const std::vector<Instance *> &getNodes() const { return _nodes; }
+
+        /// Connect the output of upstream to the named input clip of downstream, replacing any
+        /// existing connection to that clip. Returns false if either node is not in the graph,
+        /// the clip does not exist or is an output, or the connection would make a cycle.
+        bool connect(Instance *upstream, Instance *downstream, const std::string &clipName);
+
+        /// disconnect the named input clip of downstream
+        void disconnect(Instance *downstream, const std::string &clipName);
+
+        /// the node connected to the given input clip, NULL if none
+        Instance *getInput(ClipInstance *clip) const;
+
+        /// the node connected to the named input clip of downstream, NULL if none
+        Instance *getInput(Instance *downstream, const std::string &clipName) const;
+
+        /// Forget all regions of definition and requested regions, call this when any param,
+        /// clip preference or connection upstream of a rendered node changes.
+        void invalidate();
+
+        /// Get the region of definition of a node at a frame, calling the region of definition
+        /// action on it if the graph doesn't already know it.
+        OfxStatus getRegionOfDefinition(Instance *node, OfxTime time, OfxRectD &rod);
+
+        /// Work out what each node needs to render for the given region of output at the given
+        /// frame. The render scale and view come from args.
+        OfxStatus evaluate(Instance *output, OfxTime time, const OfxRectD &roi, const RenderArgs &args);
+
+        /// the regions of a node that the last evaluate found were needed, NULL if none
+        const RegionMap *getRegionsNeeded(Instance *node) const;
+
+        /// Evaluate then render the given region of output at the given frame, rendering every
+        /// node upstream of it that is needed. Returns the first failing status.
+        OfxStatus render(Instance *output, OfxTime time, const OfxRectD &roi, const RenderArgs &args);
+
+        /// the pixel window covering a canonical region of a node at the given render scale
+        static OfxRectI toPixels(Instance &node, const OfxRectD &region, const OfxPointD &renderScale);
+
+      protected:
+        /// Render a node at a frame over the given window, upstream nodes will have been rendered
+        /// first. The default calls the begin sequence, render and end sequence render actions,
+        /// with the rest of the arguments from args. Override this to keep the rendered image.
+        virtual OfxStatus renderNode(Instance &node, OfxTime time, const OfxRectI &renderWindow, const RenderArgs &args);
+
+      private:
+        Graph(const Graph &);
+        Graph &operator=(const Graph &);
+
+        /// is node upstream of, or the same as, of
+        bool isUpstream(Instance *node, Instance *of) const;
+
+        /// the nodes that output depends on, including itself, upstream first
+        void sortNodes(Instance *output, std::vector<Instance *> &order) const;
+        void sortNodes(Instance *node, std::vector<Instance *> &order, std::map<Instance *, bool> &visited) const;
+
+        std::vector<Instance *>                 _nodes;
+        std::map<ClipInstance *, Instance *>    _inputs;   ///< what feeds each connected input clip
+        std::map<Instance *, RegionMap>         _rods;     ///< known regions of definition
+        std::map<Instance *, RegionMap>         _needed;   ///< regions needed by the last evaluate
+        OfxPointD                               _renderScale;
+#     ifdef OFX_EXTENSIONS_NUKE
+        int                                     _view;
+#     endif
+      };
+
+    } // namespace ImageEffect
+
+  } // namespace Host
+
+} // namespace OFX
+
+#endif // OFX_GRAPH_H
@@ -0,0 +1,167 @@
+
+/*
+Software License :
+
+Copyright (c) 2007-2009, The Open Effects Association Ltd. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+* Neither the name The Open Effects Association Ltd, nor the names of its 
+contributors may be used to endorse or promote products derived from this
+software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OFX_IMAGE_CACHE_H
+#define OFX_IMAGE_CACHE_H
+
+#include <map>
+#include <string>
+
+#include "ofxCore.h"
+
+#include "ofxhMultiThread.h"
+
+namespace OFX {
+
+  namespace Host {
+
+    namespace ImageEffect {
+
+      // forward declare
+      class ImageBase;
+      class Instance;
+
+      /// what identifies a cached image
+      struct ImageCacheKey {
+        Instance           *instance;     ///< instance whose output the image is
+        unsigned long long  renderHash;   ///< host's hash of everything the render depends on, eg: params and inputs
+        OfxTime             time;
+        int                 view;
+        OfxPointD           renderScale;
+        std::string         plane;
+        OfxRectI            bounds;       ///< bounds of the image, in pixel coordinates
+
+        ImageCacheKey();
+
+        /// are the keys the same in everything but their bounds
+        bool sameImagePlane(const ImageCacheKey &other) const;
+
+        bool operator<(const ImageCacheKey &other) const;
+      };
+
+      /// A cache of rendered images within a byte budget, shared by any number of clips.
+      ///
+      /// A clip's getImage looks in the cache before rendering, and inserts what it renders.
+      /// The cache keeps its own reference on each image, an image is pinned and won't be
+      /// evicted while anything else holds a reference on it.
+      ///
+      /// Eviction is cost aware least recently used, the GreedyDual-Size scheme. Each image has
+      /// a priority of cost/bytes above a floor, that is reset when the image is used, and the
+      /// image with the lowest priority goes first, raising the floor to its priority. Images
+      /// inserted with the default cost are evicted in least recently used order.
+      ///
+      /// The cache is thread safe.
+      class ImageCache {
+      public:
+        /// make a cache that holds up to maxBytes of images, 0 means no limit
+        explicit ImageCache(size_t maxBytes = 0);
+
+        /// releases the cache's reference on every image
+        ~ImageCache();
+
+        /// the byte budget
+        size_t getMaxBytes() const { return _maxBytes; }
+
+        /// change the byte budget, evicting images if need be
+        void setMaxBytes(size_t maxBytes);
+
+        /// the number of bytes of images in the cache
+        size_t getBytes() const { return _bytes; }
+
+        /// the number of images in the cache
+        size_t getNImages() const { return _entries.size(); }
+
+        /// Get an image matching the key whose bounds contain the key's bounds. Returns NULL if
+        /// there is none, otherwise the image with a reference added that the caller must release.
+        ImageBase *get(const ImageCacheKey &key);
+
+        /// Add an image to the cache, which takes its own reference on it, replacing any image with
+        /// the same key. nBytes is the memory it uses, 0 means work it out from the row bytes and
+        /// bounds. cost is what it would take to make it again, in any unit used consistently, 0
+        /// means its size. Images bigger than the budget are not cached.
+        void insert(const ImageCacheKey &key, ImageBase *image, size_t nBytes = 0, double cost = 0.);
+
+        /// drop every image rendered by the given instance, eg: when it is destroyed
+        void erase(Instance *instance);
+
+        /// drop every image that isn't pinned
+        void clear();
+
+        /// evict images until no more than nBytes are cached or only pinned images are left, returns the bytes freed
+        size_t purge(size_t nBytes);
+
+        /// the number of get() calls that found and did not find an image
+        size_t getNHits() const { return _nHits; }
+        size_t getNMisses() const { return _nMisses; }
+
+        /// the memory used by an image, from its row bytes and bounds
+        static size_t getImageBytes(const ImageBase &image);
+
+      private:
+        ImageCache(const ImageCache &);
+        ImageCache &operator=(const ImageCache &);
+
+        /// keys by priority, lowest first, least recently used first amongst equals
+        typedef std::multimap<double, ImageCacheKey> PriorityMap;
+
+        struct Entry {
+          ImageBase             *image;
+          size_t                 nBytes;
+          double                 cost;
+          PriorityMap::iterator  priority;
+        };
+        typedef std::map<ImageCacheKey, Entry> EntryMap;
+
+        /// give the entry a fresh priority, as it has just been used
+        void touch(EntryMap::iterator entry);
+
+        /// drop the entry and release the image
+        void remove(EntryMap::iterator entry);
+
+        /// evict unpinned entries, lowest priority first, until no more than nBytes are cached
+        size_t evict(size_t nBytes);
+
+        mutable MultiThread::Mutex  _lock;
+        EntryMap                    _entries;
+        PriorityMap                 _priorities;
+        size_t                      _maxBytes;
+        size_t                      _bytes;
+        double                      _floor;    ///< priority of the last image evicted
+        size_t                      _nHits;
+        size_t                      _nMisses;
+      };
+
+    } // namespace ImageEffect
+
+  } // namespace Host
+
+} // namespace OFX
+
+#endif // OFX_IMAGE_CACHE_H
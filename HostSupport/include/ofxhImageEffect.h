@@ -40,6 +40,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "ofxhTimeLine.h"
 #include "ofxhParam.h"
 #include "ofxhMemory.h"
+#include "ofxhMultiThread.h"
+#include "ofxhMemoryBudget.h"
 #include "ofxhInteract.h"
 #ifdef OFX_EXTENSIONS_NATRON
 #include "ofxNatron.h"
@@ -120,38 +122,43 @@ namespace OFX {
         /// created.
         virtual void initDescriptor(Descriptor* desc);
 
-#ifdef OFX_SUPPORTS_MULTITHREAD
-        // these functions must be implemented if the host supports OfxMultiThreadSuiteV1
-        // all the following functions are described in ofxMultiThread.h
+        // the multithread suite, all the following functions are described in ofxMultiThread.h
         //
+        // The default implementations run on the host's thread pool, override them
+        // to use the host application's own threading.
 
         /// @see OfxMultiThreadSuiteV1.multiThread()
-        virtual OfxStatus multiThread(OfxThreadFunctionV1 func,unsigned int nThreads, void *customArg) = 0;
+        virtual OfxStatus multiThread(OfxThreadFunctionV1 func,unsigned int nThreads, void *customArg);
           
         /// @see OfxMultiThreadSuiteV1.multiThreadNumCPUS()
-        virtual OfxStatus multiThreadNumCPUS(unsigned int *nCPUs) const = 0;
+        virtual OfxStatus multiThreadNumCPUS(unsigned int *nCPUs) const;
 
         /// @see OfxMultiThreadSuiteV1.multiThreadIndex()
-        virtual OfxStatus multiThreadIndex(unsigned int *threadIndex) const = 0;
+        virtual OfxStatus multiThreadIndex(unsigned int *threadIndex) const;
           
         /// @see OfxMultiThreadSuiteV1.multiThreadIsSpawnedThread()
-        virtual int multiThreadIsSpawnedThread() const = 0;
+        virtual int multiThreadIsSpawnedThread() const;
           
         /// @see OfxMultiThreadSuiteV1.mutexCreate()
-        virtual OfxStatus mutexCreate(OfxMutexHandle *mutex, int lockCount) = 0;
+        virtual OfxStatus mutexCreate(OfxMutexHandle *mutex, int lockCount);
           
         /// @see OfxMultiThreadSuiteV1.mutexDestroy()
-        virtual OfxStatus mutexDestroy(const OfxMutexHandle mutex) = 0;
+        virtual OfxStatus mutexDestroy(const OfxMutexHandle mutex);
 
         /// @see OfxMultiThreadSuiteV1.mutexLock()
-        virtual OfxStatus mutexLock(const OfxMutexHandle mutex) = 0;
+        virtual OfxStatus mutexLock(const OfxMutexHandle mutex);
           
         /// @see OfxMultiThreadSuiteV1.mutexUnLock()
-        virtual OfxStatus mutexUnLock(const OfxMutexHandle mutex) = 0;
+        virtual OfxStatus mutexUnLock(const OfxMutexHandle mutex);
           
         /// @see OfxMultiThreadSuiteV1.mutexTryLock()
-        virtual OfxStatus mutexTryLock(const OfxMutexHandle mutex) = 0;
-#endif // OFX_SUPPORTS_MULTITHREAD
+        virtual OfxStatus mutexTryLock(const OfxMutexHandle mutex);
+
+        /// the pool of threads used by the default multithread suite
+        MultiThread::ThreadPool &getThreadPool() { return _threadPool; }
+
+        /// the budget that image memory is allocated against
+        MemoryBudget &getMemoryBudget() { return _memoryBudget; }
 
 #ifdef OFX_SUPPORTS_DIALOG
         // dialog suite
@@ -175,6 +182,10 @@ namespace OFX {
 
         // return an memory::instance calls makeMemoryInstance that can be overriden
         Memory::Instance* imageMemoryAlloc(size_t nBytes);
+
+      protected :
+        MultiThread::ThreadPool _threadPool;
+        MemoryBudget            _memoryBudget;
       };
 
       /// our global host object, set when the plugin cache is created
@@ -436,6 +447,15 @@ namespace OFX {
         std::string                                   _outputFielding;  ///< set by clip prefs
         double                                        _outputFrameRate; ///< set by clip prefs
 
+        /// the argument sets of the actions called while rendering, made by the constructors
+        /// and made again by populate() once the clips exist, never made lazily, as actions
+        /// may be called on several threads at once
+        struct ActionArgs;
+        ActionArgs                                   *_actionArgs;
+
+        /// get our action argument sets
+        ActionArgs &getActionArgs();
+
       public:        
         /// constructor based on effect descriptor
         Instance(ImageEffectPlugin* plugin,
@@ -39,6 +39,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "ofxCore.h"
 #include "ofxImageEffect.h"
 #include "ofxhImageEffect.h"
+#include "ofxhBinaryCache.h"
 #include "ofxhHost.h"
 
 namespace OFX {
@@ -62,13 +63,30 @@ namespace OFX {
         /// map to store contexts in
         std::map<std::string, Descriptor *> _contexts;
 
+        /// the contexts the plugin has described this session, the others in _contexts came from the cache
+        std::set<std::string> _liveContexts;
+
+        /// context descriptors from the cache replaced by ones the plugin described, kept as they may be pointed at
+        std::vector<Descriptor *> _staleContexts;
+
         mutable std::set<std::string> _knownContexts;
         mutable bool _madeKnownContexts;
 
         auto_ptr<PluginHandle> _pluginHandle;
 
+        /// the binary cache our properties are still to be decoded from, NULL once they have been
+        mutable const BinaryCache::Reader *_binaryCache;
+        mutable BinaryCache::UInt32 _binaryCacheFirstSet, _binaryCacheNSets;
+        mutable bool _decodingBinaryCache;
+
         void addContextInternal(const std::string &context) const;
 
+        /// decode our properties from the binary cache, if they came from one and have not been already
+        void decodeBinaryCache() const;
+
+        /// have the plugin describe itself in a context, replacing any descriptor from the cache
+        Descriptor *describeInContext(const std::string &context);
+
       public:
 		ImageEffectPlugin(PluginCache &pc, PluginBinary *pb, int pi, OfxPlugin *pl);
 
@@ -94,14 +112,28 @@ namespace OFX {
         /// get the base image effect descriptor, const version
         const Descriptor &getDescriptor() const;
 
-        /// get the image effect descriptor for the context
+        /// Get the image effect descriptor for the context. If the plugin cache had it, that is
+        /// returned without loading the plugin, otherwise the plugin describes the context.
         Descriptor *getContext(const std::string &context);
 
+        /// Have an already loaded plugin describe itself in a context, replacing any descriptor
+        /// we had for it. Used when scanning for plugins, so contexts can go in the cache.
+        Descriptor *describeInContext(const std::string &context, OfxPlugin *ofxPlugin);
+
+        /// make all the contexts the descriptor says are supported known
+        void addSupportedContexts();
+
         void addContext(const std::string &context);
         void addContext(const std::string &context, Descriptor *ied);
 
         virtual void saveXML(std::ostream &os);
 
+        /// add our property sets to a binary cache
+        virtual void saveBinary(BinaryCache::Writer &writer);
+
+        /// say where in a binary cache to decode our property sets from when they are first needed
+        void setBinaryCache(const BinaryCache::Reader &reader, BinaryCache::UInt32 firstSet, BinaryCache::UInt32 nSets);
+
         const std::set<std::string>& getContexts() const;
 
         PluginHandle *getPluginHandle();
@@ -220,8 +252,14 @@ namespace OFX {
         
         virtual void saveXML(Plugin *ip, std::ostream &os) const;
 
+        virtual void saveBinary(Plugin *ip, BinaryCache::Writer &writer) const;
+
+        virtual void loadBinary(Plugin *ip, const BinaryCache::Reader &reader, BinaryCache::UInt32 firstSet, BinaryCache::UInt32 nSets);
+
         void confirmPlugin(Plugin *p, const std::list<std::string>& pluginPath);
 
+        virtual void forgetPlugin(Plugin *p, const std::list<std::string>& pluginPath);
+
         virtual bool pluginSupported(Plugin *p, std::string &reason) const;
 
         Plugin *newPlugin(PluginBinary *pb,
@@ -45,6 +45,60 @@ namespace OFX {
 
     namespace Memory {
 
+      /// A pool of memory blocks in size classes, so that a steady state render loop reuses the
+      /// same blocks, already faulted in, rather than going to the system for each buffer.
+      ///
+      /// Sizes are rounded up to one of four classes per power of two, blocks are 64 byte aligned,
+      /// or page aligned from a page upwards. Freed blocks are kept for reuse up to a bounded
+      /// number of bytes, beyond which they go back to the system. The pool is split into arenas,
+      /// each with its own lock, and each thread uses the arena its id hashes to, so that threads
+      /// rarely contend. With C++11, threads using the default pool also keep a few freed blocks
+      /// of each size class to themselves and reuse them without any lock. trim() cannot reach
+      /// the blocks other threads keep, they are handed back when those threads exit.
+      class Pool {
+      public:
+        /// make a pool that keeps up to maxRetainedBytes of freed blocks
+        explicit Pool(size_t maxRetainedBytes = 256 * 1024 * 1024);
+
+        /// gives all the retained blocks back to the system, blocks still allocated must not
+        /// be freed after this
+        ~Pool();
+
+        /// the pool used by Memory::Instance and the memory suite
+        static Pool &getDefault();
+
+        /// allocate a block of at least nBytes, NULL on failure
+        void *allocate(size_t nBytes);
+
+        /// give back a block from allocate(), NULL is ignored
+        void deallocate(void *ptr);
+
+        /// the limit on retained bytes
+        size_t getMaxRetainedBytes() const;
+
+        /// change the limit on retained bytes, trimming if need be
+        void setMaxRetainedBytes(size_t nBytes);
+
+        /// give retained blocks back to the system until no more than nBytes are retained
+        void trim(size_t nBytes);
+
+        /// the number of bytes in freed blocks kept for reuse
+        size_t getRetainedBytes() const;
+
+        /// the number of bytes in blocks currently allocated, rounded up to their size class
+        size_t getAllocatedBytes() const;
+
+        /// the size class a request for nBytes is rounded up to
+        static size_t getSizeClass(size_t nBytes);
+
+      private:
+        Pool(const Pool &);
+        Pool &operator=(const Pool &);
+
+        class Implementation;
+        Implementation *_imp;
+      };
+
       class Instance {
       public:
         Instance();
@@ -62,6 +116,7 @@ namespace OFX {
       protected:
         char*   _ptr;
         int     _locked;
+        bool    _pooled; ///< was _ptr allocated from the pool, rather than by a derived class
       };
 
     } // Memory
@@ -0,0 +1,169 @@
+
+/*
+Software License :
+
+Copyright (c) 2007-2009, The Open Effects Association Ltd. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+* Neither the name The Open Effects Association Ltd, nor the names of its 
+contributors may be used to endorse or promote products derived from this
+software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OFX_MEMORY_BUDGET_H
+#define OFX_MEMORY_BUDGET_H
+
+#include <map>
+#include <vector>
+
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1900)
+#define OFX_MEMORY_BUDGET_HAS_THREADS
+#include <condition_variable>
+#endif
+
+#include "ofxhMultiThread.h"
+
+namespace OFX {
+
+  namespace Host {
+
+    namespace Memory {
+      class Instance;
+    }
+
+    namespace ImageEffect {
+
+      // forward declare
+      class ImageCache;
+      class Instance;
+
+      /// Accounts for the memory held by effect instances and host caches against a ceiling.
+      ///
+      /// Image memory from imageMemoryAlloc is counted automatically against the instance
+      /// that asked for it. Hosts count their own images with reserve() and release(), and
+      /// register their image caches with addCache().
+      ///
+      /// When counting more memory would take the total over the ceiling, room is made by,
+      ///   - trimming the free blocks retained by the default Memory::Pool,
+      ///   - evicting unpinned images from the registered caches,
+      ///   - calling purgeCachesAction on instances that are not rendering, least recently
+      ///     rendered first,
+      /// and if there still isn't room the allocation fails, so that imageMemoryAlloc returns
+      /// kOfxStatErrMemory rather than the process running out of memory.
+      ///
+      /// Purging usually happens on another instance's render thread. An instance is pinned
+      /// while it purges, renderStarted() and removeInstance() on it wait until it is done, so a
+      /// purge never overlaps a render of the same instance or outlives it.
+      class MemoryBudget {
+      public:
+        /// make a budget with the given ceiling in bytes, 0 means no ceiling
+        explicit MemoryBudget(size_t maxBytes = 0);
+        ~MemoryBudget();
+
+        /// the ceiling, 0 means none
+        size_t getMaxBytes() const { return _maxBytes; }
+
+        /// change the ceiling, making room if need be
+        void setMaxBytes(size_t maxBytes);
+
+        /// count the cache's bytes in the total and evict from it when making room
+        void addCache(ImageCache *cache);
+        void removeCache(ImageCache *cache);
+
+        /// Count nBytes as held for the given instance, NULL for the host itself, making room
+        /// first if need be. Returns false, counting nothing, if room could not be made.
+        bool reserve(Instance *instance, size_t nBytes);
+
+        /// stop counting nBytes held for the given instance
+        void release(Instance *instance, size_t nBytes);
+
+        /// note that the reserved bytes are held in the given memory, for releaseMemory to release
+        void trackMemory(Memory::Instance *memory, Instance *instance, size_t nBytes);
+
+        /// release the bytes held by a tracked memory instance, call before it is deleted
+        void releaseMemory(Memory::Instance *memory);
+
+        /// an instance starts or finishes rendering, instances are not purged while rendering,
+        /// renderStarted waits for a purge of the instance already under way
+        void renderStarted(Instance *instance);
+        void renderFinished(Instance *instance);
+
+        /// forget everything counted for an instance, call before it is destroyed, waits for a
+        /// purge of the instance already under way
+        void removeInstance(Instance *instance);
+
+        /// the bytes counted for an instance
+        size_t getInstanceBytes(Instance *instance) const;
+
+        /// the total bytes counted, including caches and the free blocks retained by the default pool
+        size_t getBytes() const;
+
+        /// free memory until the total is no more than nBytes, returns whether that was managed
+        bool purge(size_t nBytes);
+
+      private:
+        MemoryBudget(const MemoryBudget &);
+        MemoryBudget &operator=(const MemoryBudget &);
+
+        /// what we know of an instance
+        struct InstanceRecord {
+          size_t        nBytes;     ///< bytes held
+          unsigned long lastRender; ///< value of _clock when it last started rendering
+          int           rendering;  ///< number of renders in progress
+          bool          purging;    ///< is purgeCachesAction being called on it
+
+          InstanceRecord() : nBytes(0), lastRender(0), rendering(0), purging(false) {}
+        };
+
+        /// a tracked memory instance
+        struct MemoryRecord {
+          Instance *instance;
+          size_t    nBytes;
+        };
+
+        /// total bytes, _lock must be held
+        size_t getBytesLocked() const;
+
+        /// wait until the instance is not being purged, _lock must be held exactly once
+        void waitForPurge(Instance *instance);
+
+        /// call purgeCachesAction on an instance if it is still there and not rendering
+        void purgeInstance(Instance *instance);
+
+        mutable MultiThread::Mutex                _lock;
+        size_t                                    _maxBytes;
+        size_t                                    _countedBytes; ///< bytes reserved over all instances
+        unsigned long                             _clock;
+        std::map<Instance *, InstanceRecord>      _instances; ///< by instance, NULL for the host
+        std::map<Memory::Instance *, MemoryRecord> _memory;
+        std::vector<ImageCache *>                 _caches;
+#     ifdef OFX_MEMORY_BUDGET_HAS_THREADS
+        std::condition_variable_any               _purged; ///< signalled when an instance has purged
+#     endif
+      };
+
+    } // namespace ImageEffect
+
+  } // namespace Host
+
+} // namespace OFX
+
+#endif // OFX_MEMORY_BUDGET_H
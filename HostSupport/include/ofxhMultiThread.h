@@ -0,0 +1,134 @@
+
+/*
+Software License :
+
+Copyright (c) 2007-2009, The Open Effects Association Ltd. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+* Neither the name The Open Effects Association Ltd, nor the names of its 
+contributors may be used to endorse or promote products derived from this
+software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OFX_MULTITHREAD_H
+#define OFX_MULTITHREAD_H
+
+#include "ofxCore.h"
+#include "ofxMultiThread.h"
+
+namespace OFX {
+
+  namespace Host {
+
+    namespace MultiThread {
+
+      /// the number of hardware threads on this machine, never less than 1
+      unsigned int getNumHardwareThreads();
+
+      /// A persistent pool of worker threads, used to implement OfxMultiThreadSuiteV1.
+      ///
+      /// The worker threads are started on the first call to run() and live until the pool is
+      /// destroyed. Each worker owns a queue of work, which it pops from one end while idle
+      /// workers steal from the other end. The thread calling run() takes part in the work
+      /// itself, so a pool of N threads only ever spawns N-1 workers.
+      class ThreadPool {
+      public:
+        /// make a pool that runs up to nThreads functions at once, 0 means one per hardware thread
+        explicit ThreadPool(unsigned int nThreads = 0);
+
+        /// stops and joins the worker threads
+        ~ThreadPool();
+
+        /// the number of functions the pool can run at once, including the caller of run()
+        unsigned int getNumThreads() const;
+
+        /// Calls func(i, nThreads, customArg) for each i in [0, nThreads) and returns once all
+        /// of them have returned. If nThreads is 0, getNumThreads() is used.
+        ///
+        /// Calls may be nested, eg: a function run by the pool may itself call run(). The
+        /// nested calls are shared out over the same workers rather than spawning more threads,
+        /// and a worker waiting for a nested call to finish runs other pending work meanwhile.
+        ///
+        /// Returns kOfxStatOK, or kOfxStatFailed if func is null or any call of it threw.
+        OfxStatus run(OfxThreadFunctionV1 func, unsigned int nThreads, void *customArg);
+
+        /// is the calling thread currently running a function launched by run()
+        static bool isSpawnedThread();
+
+        /// the index passed to the function the calling thread is running, 0 if it is not a spawned thread
+        static unsigned int getThreadIndex();
+
+      private:
+        ThreadPool(const ThreadPool &);
+        ThreadPool &operator=(const ThreadPool &);
+
+        class Implementation;
+        Implementation *_imp;
+      };
+
+      /// A recursive mutex with the semantics of OfxMultiThreadSuiteV1::mutexCreate and friends.
+      class Mutex {
+      public:
+        /// make a mutex on which the calling thread already holds lockCount locks
+        explicit Mutex(int lockCount = 0);
+        ~Mutex();
+
+        /// blocks until the calling thread holds the mutex, then adds one to the lock count
+        void lock();
+
+        /// removes one from the lock count, returns false if the calling thread does not hold the mutex
+        bool unlock();
+
+        /// as lock(), but returns false rather than blocking
+        bool tryLock();
+
+        /// obtain a handle on this for passing to the C api
+        OfxMutexHandle getHandle() { return (OfxMutexHandle) this; }
+
+      private:
+        Mutex(const Mutex &);
+        Mutex &operator=(const Mutex &);
+
+        class Implementation;
+        Implementation *_imp;
+      };
+
+      /// holds a lock on a mutex for the life of a scope, a null mutex is not locked
+      class ScopedLock {
+      public:
+        explicit ScopedLock(Mutex *mutex) : _mutex(mutex) { if(_mutex) _mutex->lock(); }
+        explicit ScopedLock(Mutex &mutex) : _mutex(&mutex) { _mutex->lock(); }
+        ~ScopedLock() { if(_mutex) _mutex->unlock(); }
+
+      private:
+        ScopedLock(const ScopedLock &);
+        ScopedLock &operator=(const ScopedLock &);
+
+        Mutex *_mutex;
+      };
+
+    } // MultiThread
+
+  } // Host
+
+} // OFX
+
+#endif // OFX_MULTITHREAD_H
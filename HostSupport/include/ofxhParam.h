@@ -34,6 +34,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <string>
 #include <map>
 #include <list>
+#include <vector>
 #include <cstdarg>
 
 //ofx
@@ -41,6 +42,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 //ofxh
 #include "ofxhPropertySuite.h"
+#include "ofxhMultiThread.h"
 
 
 namespace OFX {
@@ -52,6 +54,9 @@ namespace OFX {
       /// fetch the param suite
       const void *GetSuite(int version);
 
+      /// return the OFX function suite that gets many parameter values in one call, see ofxParameterBatch.h
+      const void *GetBatchSuite(int version);
+
       bool isColourParam(const std::string &paramType);
 
       bool isIntParam(const std::string &paramType);
@@ -263,6 +268,9 @@ namespace OFX {
         /// get a value, implemented by instances to deconstruct var args
         virtual OfxStatus getV(OfxTime time, va_list arg);
 
+        /// get the values as doubles, implemented by numeric instances for the parameter batch suite
+        virtual OfxStatus getValuesAtTime(OfxTime time, double *values, int count);
+
         /// set a value, implemented by instances to deconstruct var args
         virtual OfxStatus setV(va_list arg);
 
@@ -335,6 +343,9 @@ namespace OFX {
         /// implementation of var args function
         virtual OfxStatus getV(OfxTime time, va_list arg);
 
+        /// implementation of the parameter batch suite
+        virtual OfxStatus getValuesAtTime(OfxTime time, double *values, int count);
+
         /// implementation of var args function
         virtual OfxStatus setV(va_list arg);
 
@@ -367,6 +378,9 @@ namespace OFX {
         /// implementation of var args function
         virtual OfxStatus getV(OfxTime time, va_list arg);
 
+        /// implementation of the parameter batch suite
+        virtual OfxStatus getValuesAtTime(OfxTime time, double *values, int count);
+
         /// implementation of var args function
         virtual OfxStatus setV(va_list arg);
 
@@ -395,6 +409,9 @@ namespace OFX {
         /// implementation of var args function
         virtual OfxStatus getV(OfxTime time, va_list arg);
 
+        /// implementation of the parameter batch suite
+        virtual OfxStatus getValuesAtTime(OfxTime time, double *values, int count);
+
         /// implementation of var args function
         virtual OfxStatus setV(va_list arg);
 
@@ -424,6 +441,9 @@ namespace OFX {
         /// implementation of var args function
         virtual OfxStatus getV(OfxTime time, va_list arg);
 
+        /// implementation of the parameter batch suite
+        virtual OfxStatus getValuesAtTime(OfxTime time, double *values, int count);
+
         /// implementation of var args function
         virtual OfxStatus setV(va_list arg);
 
@@ -451,6 +471,9 @@ namespace OFX {
         /// implementation of var args function
         virtual OfxStatus getV(OfxTime time, va_list arg);
 
+        /// implementation of the parameter batch suite
+        virtual OfxStatus getValuesAtTime(OfxTime time, double *values, int count);
+
         /// implementation of var args function
         virtual OfxStatus setV(va_list arg);
 
@@ -484,6 +507,9 @@ namespace OFX {
         /// implementation of var args function
         virtual OfxStatus getV(OfxTime time, va_list arg);
 
+        /// implementation of the parameter batch suite
+        virtual OfxStatus getValuesAtTime(OfxTime time, double *values, int count);
+
         /// implementation of var args function
         virtual OfxStatus setV(va_list arg);
 
@@ -517,6 +543,9 @@ namespace OFX {
         /// implementation of var args function
         virtual OfxStatus getV(OfxTime time, va_list arg);
 
+        /// implementation of the parameter batch suite
+        virtual OfxStatus getValuesAtTime(OfxTime time, double *values, int count);
+
         /// implementation of var args function
         virtual OfxStatus setV(va_list arg);
 
@@ -550,6 +579,9 @@ namespace OFX {
         /// implementation of var args function
         virtual OfxStatus getV(OfxTime time, va_list arg);
 
+        /// implementation of the parameter batch suite
+        virtual OfxStatus getValuesAtTime(OfxTime time, double *values, int count);
+
         /// implementation of var args function
         virtual OfxStatus setV(va_list arg);
 
@@ -583,6 +615,9 @@ namespace OFX {
         /// implementation of var args function
         virtual OfxStatus getV(OfxTime time, va_list arg);
 
+        /// implementation of the parameter batch suite
+        virtual OfxStatus getValuesAtTime(OfxTime time, double *values, int count);
+
         /// implementation of var args function
         virtual OfxStatus setV(va_list arg);
 
@@ -615,6 +650,9 @@ namespace OFX {
         /// implementation of var args function
         virtual OfxStatus getV(OfxTime time, va_list arg);
 
+        /// implementation of the parameter batch suite
+        virtual OfxStatus getValuesAtTime(OfxTime time, double *values, int count);
+
         /// implementation of var args function
         virtual OfxStatus setV(va_list arg);
 
@@ -675,6 +713,30 @@ namespace OFX {
         std::map<std::string, Instance*> _params;        ///< params by name
         std::list<Instance *>            _paramList;     ///< params list
         bool _ownsParams; // false if this instance was created from another one
+
+        /// what we know of the hash of a param's value
+        struct ParamHash {
+          unsigned long long hash;        ///< hash of the value, if not time varying
+          bool               valid;       ///< has hash been computed since the last change
+          bool               timeVarying; ///< is the param animated, so that it needs hashing at each time
+          unsigned int       serial;      ///< number of changes, hashed for params whose value can't be read
+
+          ParamHash() : hash(0), valid(false), timeVarying(false), serial(0) {}
+        };
+
+        std::map<Instance*, ParamHash>   _paramHashes;       ///< hashes by param
+        std::vector<Instance*>           _timeVaryingParams; ///< params whose hash depends on time
+        unsigned long long               _staticHash;        ///< combined hash of the params that aren't time varying
+        bool                             _hashValid;         ///< are _staticHash and _timeVaryingParams up to date
+        MultiThread::Mutex               _hashLock;          ///< guards all the hash bits
+
+        /// get the hash entry of a param, bringing it up to date, _hashLock must be held
+        ParamHash &getParamHashEntry(Instance *param, OfxTime time);
+
+        /// Hash the value of a param at the given time, and say whether it varies with time.
+        /// Returns false if the param's value can't be read, in which case the number of times
+        /// it has changed is hashed instead. Override this to hash host specific param types.
+        virtual bool computeParamHash(Instance *param, OfxTime time, unsigned long long &hash, bool &timeVarying);
       public :
         /// ctor
         ///
@@ -730,6 +792,18 @@ namespace OFX {
         /// Client host code needs to implement this
         virtual OfxStatus editEnd() = 0;
 
+        /// Mark a param's value as changed, so that its hash is recomputed. This is called for
+        /// changes made by the plug-in through the param suite and from paramInstanceChangedAction,
+        /// hosts must call it themselves for any other change, including changes to keyframes.
+        void paramValueChanged(Instance *param);
+
+        /// the hash of a param's value at the given time
+        unsigned long long getParamHash(Instance *param, OfxTime time);
+
+        /// The combined hash of all the param values at the given time, for keying render caches.
+        /// Only animated params are re-read at each time, the rest are hashed once per change.
+        unsigned long long getHash(OfxTime time);
+
       };
     }
   }
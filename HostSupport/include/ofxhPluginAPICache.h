@@ -37,6 +37,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <list>
 
 #include "ofxhPropertySuite.h"
+#include "ofxhBinaryCache.h"
 
 namespace OFX
 {
@@ -92,8 +93,19 @@ namespace OFX
         
         virtual void saveXML(Plugin *, std::ostream &) const = 0;
 
+        /// add the property sets for a plugin to a binary cache, by default there are none
+        virtual void saveBinary(Plugin *, BinaryCache::Writer &) const {}
+
+        /// Restore a plugin from the property sets saveBinary() wrote. The reader outlives
+        /// the plugin, so the sets may be kept and decoded later, when first needed.
+        virtual void loadBinary(Plugin *, const BinaryCache::Reader &, BinaryCache::UInt32 /*firstSet*/, BinaryCache::UInt32 /*nSets*/) {}
+
         virtual void confirmPlugin(Plugin *, const std::list<std::string>& pluginPath) = 0;
 
+        /// The binary of a confirmed plugin has changed or gone, stop handing the plugin out.
+        /// It is not deleted until the plugin cache is.
+        virtual void forgetPlugin(Plugin *, const std::list<std::string>& /*pluginPath*/) {}
+
         virtual bool pluginSupported(Plugin *, std::string &reason) const = 0;
 
         void registerInCache(OFX::Host::PluginCache &pluginCache);
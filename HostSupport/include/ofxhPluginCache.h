@@ -44,6 +44,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "ofxhPropertySuite.h"
 #include "ofxhPluginAPICache.h"
 #include "ofxhBinary.h"
+#include "ofxhMultiThread.h"
 
 #ifdef WINDOWS
 #include "tchar.h"
@@ -243,6 +244,8 @@ namespace OFX {
       off_t _fileSize;                ///< file size last time we check, used for caching
       bool _binaryChanged;            ///< whether the timestamp/filesize in this cache is different from that in the actual binary
       bool _binaryInvalid;            ///< whether we could open and stat the binary or not
+      bool _holdsBinary;              ///< whether loadPluginInfo() took the reference on the binary we let go of when done
+      std::string _contentHash;       ///< hash of the binary's contents, if the cache is set to take them, else empty
 
     public :
 
@@ -258,6 +261,7 @@ namespace OFX {
         , _fileSize(size)
         , _binaryChanged(false)
         , _binaryInvalid(false)
+        , _holdsBinary(false)
       {
         if (isInvalid()) {
           _binaryInvalid = true;
@@ -279,6 +283,7 @@ namespace OFX {
         , _bundlePath(bundlePath)
         , _binaryChanged(false)
         , _binaryInvalid(false)
+        , _holdsBinary(false)
       {
         if (_binary->isInvalid()) {
           _binaryInvalid = true;
@@ -304,6 +309,7 @@ namespace OFX {
       , _fileSize()
       , _binaryChanged(true)
       , _binaryInvalid(false)
+      , _holdsBinary(false)
       {
         _binaryInvalid = !Binary::getFileModTimeAndSize(hostAppBinFilePath, _fileModificationTime, _fileSize);
         if (cachedHostAppBinFilePath && cachedFileModificationTime && cachedFileSize) {
@@ -346,6 +352,23 @@ namespace OFX {
         return _binaryChanged;
       }
 
+      /// Stat the binary again and see if it differs from the time stamp and size we have.
+      /// If it does, but useContentHash is set and its contents hash the same as they did,
+      /// take the new time stamp and count it as unchanged. Sets and returns hasBinaryChanged().
+      bool checkForChanges(bool useContentHash);
+
+      const std::string &getContentHash() const {
+        return _contentHash;
+      }
+
+      void setContentHash(const std::string &hash) {
+        _contentHash = hash;
+      }
+
+      /// Let go of the binary loadPluginInfo() kept loaded. Done when it has been replaced on
+      /// disk, so once nothing else has it loaded the system loader will give us the new one.
+      void releaseBinary();
+
       bool isLoaded() const {
         return _binary ? _binary->isLoaded() : true;
       }
@@ -411,6 +434,22 @@ namespace OFX {
 
     /// Where we keep our plugins.    
     class PluginCache {
+    public :
+      /// a bundle found by scanDirectory()
+      struct FoundBundle {
+        std::string binPath;          ///< the binary for our architecture
+        std::string universalBinPath; ///< the universal binary to fall back on, Mac OS X only
+        std::string bundlePath;       ///< the .bundle directory
+      };
+
+      /// how long one step of loading a binary or a plugin in it took, see getLoadTimings()
+      struct LoadTiming {
+        std::string bundlePath; ///< the bundle the binary is in
+        std::string pluginId;   ///< the plugin, empty for steps done on the whole binary
+        std::string step;       ///< "binaryLoad", "loadPluginInfo", "describeWorker" or the action called, with the context for describe in context
+        double seconds;         ///< wall clock time taken
+      };
+
     protected :
       OFX::Host::Property::PropSpec* _hostSpec;
 
@@ -430,9 +469,47 @@ namespace OFX {
       PluginBinary *_xmlCurrentBinary;
       Plugin *_xmlCurrentPlugin;
 
+      std::list<BinaryCache::Reader *> _binaryCaches; ///< binary caches read, kept mapped as plugins may decode from them lazily
+
+      std::list<PluginBinary *> _retiredBinaries; ///< binaries changed or removed since the scan, kept as their plugins may still be pointed at
+
       std::list<PluginCacheSupportedApi> _apiHandlers;
 
-      void scanDirectory(std::set<std::string> &foundBinFiles, const std::string &dir, bool recurse);
+      /// walk a directory, adding the bundles in it to bundles and the directories looked
+      /// in to dirs, in the order readdir gives them. Touches nothing else, so several
+      /// directories can be walked at once.
+      void scanDirectory(std::vector<FoundBundle> &bundles, std::list<std::string> &dirs, const std::string &dir, bool recurse) const;
+
+      /// walk all the directories on the plugin path at once, returning what was found in the order of the path
+      void scanPluginPath(MultiThread::ThreadPool &pool, std::vector<FoundBundle> &bundles, std::list<std::string> &dirs);
+
+      /// functions run by the discovery thread pool in scanPluginFiles()
+      static void scanDirectoryThread(unsigned int threadIndex, unsigned int threadMax, void *arg);
+      static void loadBinaryThread(unsigned int threadIndex, unsigned int threadMax, void *arg);
+
+      /// take a binary out of use after the scan, its plugins are forgotten but kept until we go
+      void retireBinary(PluginBinary *pb);
+
+      /// add the plugins a binary cache has for one of its binaries to pb
+      void readCachedPlugins(PluginBinary *pb, const BinaryCache::Reader &reader, const BinaryCache::BinaryRecord &record);
+
+      /// make a binary and its plugins from the binary cache a describe worker sent back, NULL if it is no good
+      PluginBinary *readDescribedBinary(const std::string &cache);
+
+      /// watch any directories on the plugin path we aren't watching yet, if we are watching
+      void watchPluginPath();
+
+      unsigned int _discoveryThreads; ///< how many threads scanPluginFiles() uses, 1 by default, 0 for one per core
+      unsigned int _describeWorkers;  ///< how many processes describe binaries at once, 0 to describe them in this one
+      std::string _describeWorkerExecutable; ///< what the describe workers are started from, empty for this binary
+
+      std::vector<LoadTiming> _loadTimings; ///< in the order they were recorded
+      double _scanTime;                     ///< how long the last scanPluginFiles() took
+      mutable MultiThread::Mutex _loadTimingsLock;
+
+      bool _contentHashing;   ///< hash the contents of binaries, so ones only touched are not described again
+      int _watchHandle;       ///< the inotify instance watching the plugin path, -1 if not watching
+      std::set<std::string> _watchedDirs;
 
       bool _ignoreCache;
       std::string _cacheVersion;
@@ -505,9 +582,23 @@ namespace OFX {
         _cacheVersion = cacheVersion;
       }
 
+      /// Hash the contents of binaries as they are loaded and keep the hashes in the cache.
+      /// A cached binary whose time stamp changed but whose contents still hash the same, as
+      /// happens when a deployment copies the same files over again, is then not loaded and
+      /// described again. Off by default, set it before reading the cache.
+      void setContentHashing(bool enabled) { _contentHashing = enabled; }
+
+      bool getContentHashing() const { return _contentHashing; }
+
       // populate the cache.  must call scanPluginFiles() after to check for changes.
       void readCache(std::istream &is);
 
+      /// Populate the cache from a binary cache file, as written by writeBinaryCache(), instead
+      /// of readCache(). The file is memory mapped and the plugins' properties decoded from it
+      /// when first asked for. Returns false if the file is missing or unusable, in which
+      /// case nothing was read. Must call scanPluginFiles() after to check for changes.
+      bool readBinaryCache(const std::string &fileName);
+
       // seek a particular file on the OFX plugin path
       std::string seekPluginFile(const std::string &baseName) const;
       
@@ -515,11 +606,93 @@ namespace OFX {
       /// Enable (the default): normal operation; disable: returns an empty string instead
       void setPluginSeekEnabled(bool enabled) { _enablePluginSeek = enabled; }
 
-      /// scan for plugins
+      /// Set how many threads scanPluginFiles() walks directories, loads binaries and
+      /// describes plugins on, 1 (the default) does it all on the calling thread, 0 means one
+      /// per hardware thread. Each binary is only ever touched by one thread, but with more
+      /// than one thread different binaries are loaded and described at the same time, so
+      /// plugins' load and describe actions, Host::loadingStatus() and the descriptor
+      /// factories of the host are called from several threads. Only ask for more than one
+      /// if the host can cope with that, and trusts its plugins to.
+      void setDiscoveryThreads(unsigned int nThreads) { _discoveryThreads = nThreads; }
+
+      /// Describe binaries which aren't in the cache, or have changed, in up to nWorkers
+      /// worker processes, 0 (the default) to describe them in this one. Each binary gets its
+      /// own process, which loads and describes it and sends the result back in the binary
+      /// cache format, so a plugin that crashes, or whose load action isn't thread safe, takes
+      /// nothing else down with it; one that crashes is left out of the cache and tried again
+      /// next time. The workers are started afresh from workerExecutable, or the running host
+      /// binary if that is empty (Linux only), with a command line that runDescribeWorker()
+      /// picks up, so that program must call runDescribeWorker() at the top of main(). Only on
+      /// unix like systems, elsewhere the binaries are described in this process as usual.
+      void setDescribeWorkers(unsigned int nWorkers, const std::string &workerExecutable = std::string()) {
+        _describeWorkers = nWorkers;
+        _describeWorkerExecutable = workerExecutable;
+      }
+
+      /// If this process was started as a describe worker by setDescribeWorkers(), load and
+      /// describe the binary named on the command line, send it back, set exitStatus and
+      /// return true, in which case the program should exit with exitStatus straight away.
+      /// Otherwise do nothing and return false. Call it after setting the cache version and
+      /// registering the API caches, as for scanning, but before starting anything else.
+      bool runDescribeWorker(int argc, char **argv, int &exitStatus);
+
+      /// scan for plugins, the resulting order of the binaries and plugins does not depend
+      /// on the number of discovery threads
       void scanPluginFiles();
 
+      /// Start watching the directories on the plugin path for bundles being added, changed
+      /// or removed, call after scanPluginFiles(). Uses inotify, so only on Linux, returns
+      /// false elsewhere or if the directories couldn't be watched.
+      bool startWatching();
+
+      /// stop watching the plugin path
+      void stopWatching();
+
+      /// A file descriptor that becomes readable when something on the plugin path has
+      /// changed, for hosts to poll() or select() on in their event loop. -1 if not watching.
+      int getWatchHandle() const { return _watchHandle; }
+
+      /// Bring the plugins up to date with the plugin path after scanPluginFiles(). Bundles
+      /// that have appeared are loaded and described, and those that have changed described
+      /// again, the others are left alone. Plugins of changed or removed bundles are no longer
+      /// handed out by the API caches, but are kept until the cache is destroyed, so instances
+      /// of them carry on working. Until those are gone the system loader may carry on giving
+      /// the old library for a changed binary. When watching, this does nothing unless the
+      /// watcher has seen something happen, so it is cheap to call often; when not watching
+      /// it always looks. Returns whether any plugins came or went.
+      bool updatePluginFiles();
+
+      /// Note how long a step of loading a binary or plugin took. Called by the support
+      /// library as binaries are loaded and plugins described, from any thread.
+      void recordLoadTiming(const std::string &bundlePath, const std::string &pluginId, const std::string &step, double seconds);
+
+      /// Get what recordLoadTiming() has been told since the cache was made or
+      /// clearLoadTimings() was last called. Steps taken while scanning are there, as are
+      /// those taken when a plugin is loaded again to make an instance. A describe worker
+      /// sends back the steps it took, which are recorded here along with a "describeWorker"
+      /// step for the whole of its run.
+      std::vector<LoadTiming> getLoadTimings() const;
+
+      /// the total seconds recorded against a bundle, eg to blacklist slow ones
+      double getBundleLoadTime(const std::string &bundlePath) const;
+
+      /// wall clock seconds the last call to scanPluginFiles() took
+      double getScanTime() const;
+
+      /// forget the load timings recorded so far
+      void clearLoadTimings();
+
+      /// write a report of the load timings, slowest bundle first
+      void dumpLoadTimings(std::ostream &os) const;
+
+      /// write the load timings report to stdout
+      void dumpLoadTimingsToStdOut() const { dumpLoadTimings(std::cout); }
+
       // write the plugin cache output file to the given stream
       void writePluginCache(std::ostream &os) const;
+
+      /// write the plugin cache as a binary cache, the stream must be opened in binary mode
+      void writeBinaryCache(std::ostream &os) const;
       
       // callback function for the XML
       void elementBeginCallback(void *userData, const XML_Char *name, const XML_Char **attrs);
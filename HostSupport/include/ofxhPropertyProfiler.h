@@ -0,0 +1,126 @@
+
+/*
+Software License :
+
+Copyright (c) 2007-2009, The Open Effects Association Ltd. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+* Neither the name The Open Effects Association Ltd, nor the names of its 
+contributors may be used to endorse or promote products derived from this
+software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OFX_PROPERTY_PROFILER_H
+#define OFX_PROPERTY_PROFILER_H
+
+#include <string>
+#include <vector>
+#include <iosfwd>
+
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1900)
+#define OFX_PROFILER_HAS_ATOMIC
+#include <atomic>
+#endif
+
+#include "ofxhPropertySuite.h"
+
+namespace OFX {
+
+  namespace Host {
+
+    namespace Property {
+
+      /// Counts and times the calls plugins make on the property suite, aggregated by the
+      /// property name, the kind of set it lives in (see Set::setKind) and the action the
+      /// plugin was in when it made the call.
+      ///
+      /// This is off by default, and then costs each suite call a single test of a flag.
+      /// It is turned on by setEnabled(true), or by setting the OFX_PROPERTY_PROFILE
+      /// environment variable before the host starts.
+      namespace Profiler {
+
+        /// what has been gathered about one (name, kind, action)
+        struct Entry {
+          std::string        name;    ///< the property
+          std::string        kind;    ///< the kind of set it was fetched from
+          std::string        action;  ///< the action that was running, "" if none
+          unsigned long long calls;   ///< how many suite calls were made
+          double             seconds; ///< how long they took altogether
+        };
+
+        /// how dump() formats its output
+        enum Format {
+          eTable, ///< aligned columns, slowest first
+          eJSON   ///< an array of objects, one per Entry
+        };
+
+        /// don't use this, call isEnabled()
+#     ifdef OFX_PROFILER_HAS_ATOMIC
+        extern std::atomic<bool> gEnabled;
+
+        /// is the profiler gathering, may be called from any thread
+        inline bool isEnabled() { return gEnabled.load(std::memory_order_relaxed); }
+#     else
+        extern volatile bool gEnabled;
+
+        /// is the profiler gathering
+        inline bool isEnabled() { return gEnabled; }
+#     endif
+
+        /// start or stop gathering, what has been gathered so far is kept
+        void setEnabled(bool enabled);
+
+        /// forget everything gathered so far
+        void reset();
+
+        /// add a call to the counts, name and action are interned, action may be NULL
+        void record(Atom name, const char *kind, Atom action, double seconds);
+
+        /// what has been gathered so far, slowest first
+        void getEntries(std::vector<Entry> &entries);
+
+        /// write what has been gathered so far
+        void dump(std::ostream &os, Format format = eTable);
+
+        /// the action the calling thread is in, NULL if none
+        Atom getCurrentAction();
+
+        /// marks the calling thread as being in an action for the life of a scope, to
+        /// be put around calls to a plugin's main entry
+        class ActionScope {
+          Atom _previous;
+
+          ActionScope(const ActionScope &);
+          ActionScope &operator=(const ActionScope &);
+        public :
+          explicit ActionScope(const char *action);
+          ~ActionScope();
+        };
+
+      }
+
+    }
+
+  }
+
+}
+
+#endif
@@ -34,8 +34,11 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <vector>
 #include <map>
 #include <algorithm>
+#include <string.h>
 #include <sstream> // stringstream
 
+#include "ofxhMultiThread.h"
+
 #ifndef WINDOWS
 #if __cplusplus < 201103L
 #define OFX_EXCEPTION_SPEC throw (OFX::Host::Property::Exception)
@@ -93,6 +96,104 @@ namespace OFX {
         }
       };
 
+      /// A vector of POD property values, which holds up to N values inline and only goes to
+      /// the heap beyond that. Almost all properties have a dimension of 4 or less, so this
+      /// saves an allocation per value vector on the many property sets made while rendering.
+      template<class Type, int N>
+      class ValueVector {
+        Type    _inline[N];
+        Type   *_values;    ///< either _inline or a heap block
+        size_t  _size;
+        size_t  _capacity;
+
+      public :
+        typedef Type *iterator;
+        typedef const Type *const_iterator;
+
+        ValueVector()
+          : _values(_inline)
+          , _size(0)
+          , _capacity(N)
+        {
+        }
+
+        ValueVector(const ValueVector &other)
+          : _values(_inline)
+          , _size(0)
+          , _capacity(N)
+        {
+          assign(other._values, other._size);
+        }
+
+        ~ValueVector()
+        {
+          if(_values != _inline)
+            delete [] _values;
+        }
+
+        ValueVector &operator=(const ValueVector &other)
+        {
+          if(this != &other)
+            assign(other._values, other._size);
+          return *this;
+        }
+
+        size_t size() const { return _size; }
+        bool empty() const { return _size == 0; }
+
+        Type &operator[](size_t i) { return _values[i]; }
+        const Type &operator[](size_t i) const { return _values[i]; }
+
+        iterator begin() { return _values; }
+        iterator end() { return _values + _size; }
+        const_iterator begin() const { return _values; }
+        const_iterator end() const { return _values + _size; }
+
+        /// make room for n values without changing the size
+        void reserve(size_t n)
+        {
+          if(n <= _capacity)
+            return;
+          size_t capacity = std::max(n, _capacity * 2);
+          Type *values = new Type[capacity];
+          memcpy(values, _values, _size * sizeof(Type));
+          if(_values != _inline)
+            delete [] _values;
+          _values = values;
+          _capacity = capacity;
+        }
+
+        /// resize, new values are zero
+        void resize(size_t n)
+        {
+          reserve(n);
+          if(n > _size)
+            memset(_values + _size, 0, (n - _size) * sizeof(Type));
+          _size = n;
+        }
+
+        /// replace our values with n values copied from v
+        void assign(const Type *v, size_t n)
+        {
+          reserve(n);
+          memcpy(_values, v, n * sizeof(Type));
+          _size = n;
+        }
+      };
+
+      /// the values of a ValueVector as a std::vector
+      template<class Type, int N>
+      inline std::vector<Type> toStdVector(const ValueVector<Type, N> &v)
+      {
+        return std::vector<Type>(v.begin(), v.end());
+      }
+
+      /// string values are already held in a std::vector
+      inline const std::vector<std::string> &toStdVector(const std::vector<std::string> &v)
+      {
+        return v;
+      }
+
       /// type of a property
       enum TypeEnum {
         eNone = -1,
@@ -107,6 +208,8 @@ namespace OFX {
         typedef int APIType; ///< C type of the property that is passed across the raw API
         typedef int Type; ///< Type we actually hold and deal with the propery in everything by the raw API
         typedef int ReturnType; ///< type to return from a function call
+        typedef ValueVector<int, 4> Vector; ///< how a property holds its values
+        typedef std::vector<int> ValuesType; ///< what getValues() returns
         static const TypeEnum typeCode = eInt;
         static int kEmpty;
       };
@@ -116,6 +219,8 @@ namespace OFX {
         typedef double APIType;
         typedef double Type;
         typedef double ReturnType; ///< type to return from a function call
+        typedef ValueVector<double, 4> Vector; ///< how a property holds its values
+        typedef std::vector<double> ValuesType; ///< what getValues() returns
         static const TypeEnum typeCode = eDouble;
         static double kEmpty;
       };
@@ -125,6 +230,8 @@ namespace OFX {
         typedef void *APIType;
         typedef void *Type;
         typedef void *ReturnType; ///< type to return from a function call
+        typedef ValueVector<void *, 4> Vector; ///< how a property holds its values
+        typedef std::vector<void *> ValuesType; ///< what getValues() returns
         static const TypeEnum typeCode = ePointer;
         static void *kEmpty;
       };
@@ -134,6 +241,8 @@ namespace OFX {
         typedef const char *APIType;
         typedef std::string Type;
         typedef const std::string &ReturnType; ///< type to return from a function call
+        typedef std::vector<std::string> Vector; ///< how a property holds its values
+        typedef const std::vector<std::string> &ValuesType; ///< what getValues() returns
         static const TypeEnum typeCode = eString;
         static std::string kEmpty;
       };
@@ -303,13 +412,18 @@ namespace OFX {
         typedef typename T::Type Type; 
         typedef typename T::ReturnType ReturnType; 
         typedef typename T::APIType APIType;
+        typedef typename T::Vector Vector;
+        typedef typename T::ValuesType ValuesType;
+
+        /// the type of the property, used to check property types without a dynamic_cast
+        static const TypeEnum kTypeCode = T::typeCode;
         
       protected :
         /// this is the present value of the property
-        std::vector<Type> _value;
+        Vector _value;
 
         /// this is the default value of the property
-        std::vector<Type> _defaultValue;
+        Vector _defaultValue;
 
       public :
         /// constructor
@@ -328,8 +442,14 @@ namespace OFX {
         {
         }
 
-        /// get the vector
-        const std::vector<Type> &getValues()
+        /// get the values as a std::vector, a copy for all but string properties
+        ValuesType getValues() const
+        {
+          return toStdVector(_value);
+        }
+
+        /// get the values as they are held, without copying them
+        const Vector &getValueVector() const
         {
           return _value;
         }
@@ -391,6 +511,18 @@ namespace OFX {
       /// A std::map of properties by name
       typedef std::map<std::string, Property *> PropertyMap;
 
+      /// An interned property name. Each distinct name is interned once, for the life of the
+      /// process, so that names can be compared and hashed by the address of their atom.
+      typedef const std::string *Atom;
+
+      /// get the atom for a name, interning it if need be, NULL for a NULL name
+      Atom internName(const char *name);
+
+      /// Get the atom for a name, NULL if it is NULL or has never been interned, in which case no
+      /// property set has a property of that name. Lookups of the same pointer on the same
+      /// thread, eg: a plugin passing the kOfx constants, skip hashing the name.
+      Atom findName(const char *name);
+
 
       //................................................................................
       /// Class that holds a set of properties and manipulates them
@@ -404,11 +536,31 @@ namespace OFX {
       protected :
         PropertyMap _props; ///< Our properties.
 
+        /// an entry in the hashed index of _props
+        struct IndexEntry {
+          Atom      atom;     ///< name of the property, NULL for an empty entry
+          Property *property;
+          TypeEnum  type;     ///< type of the property, so typed fetches need no dynamic_cast
+        };
+
+        /// _props hashed by atom, open addressed with linear probing, the size is a power of two
+        std::vector<IndexEntry> _index;
+        size_t                  _indexCount; ///< number of entries in use
+
+        /// add or replace a property in the index
+        void indexProperty(Property *prop);
+
+        /// find the index entry for a name, following the chain if asked, NULL if none
+        const IndexEntry *findIndexEntry(Atom atom, bool followChain) const;
+
         /// chained property set, which is read only
         /// these are searched on a get if not found 
         /// on a local search
         Set *_chainedSet;
 
+        /// what sort of set this is, eg: "clip", for the profiler, never NULL
+        const char *_kind;
+
         /// hide assignment
         void operator=(const Set &);
 
@@ -453,9 +605,18 @@ namespace OFX {
         /// add one new property
         void addProperty(Property *prop);
 
+        /// reset all our properties to their defaults
+        void reset();
+
         /// set the chained property set
         void setChainedSet(Set *s) {_chainedSet = s;}
 
+        /// say what sort of set this is, the string must outlive the set, typically a literal
+        void setKind(const char *kind) {_kind = kind ? kind : "";}
+
+        /// what sort of set this is, "" if never said
+        const char *getKind() const {return _kind;}
+
         /// grab the internal properties map
         const PropertyMap &getProperties() const
         {
@@ -474,12 +635,18 @@ namespace OFX {
         /// 'followChain' arg is not false.
         Property *fetchProperty(const std::string &name, bool followChain = false) const;
 
+        /// as above, without making a std::string, as used by the suite functions
+        Property *fetchProperty(const char *name, bool followChain = false) const;
+
         /// get property with the particular name and type.  if the property is 
         /// missing or is of the wrong type, return an error status.  if this is a sloppy
         /// property set and the property is missing, a new one will be created of the right
         /// type
         template<class T> bool fetchTypedProperty(const std::string &name, T *&prop, bool followChain = false) const;
 
+        /// as above, without making a std::string, as used by the suite functions
+        template<class T> bool fetchTypedProperty(const char *name, T *&prop, bool followChain = false) const;
+
         /// retrieve the nameed string property
         String *fetchStringProperty(const std::string &name,  bool followChain = false) const;
 
@@ -565,9 +732,58 @@ namespace OFX {
         bool verifyMagic() { return _magic == kMagic; }
       };
 
+      /// A pool of identical property sets, for sets that are filled in and thrown away over
+      /// and over, eg: the arguments to an action. Sets are deep copied from a prototype when
+      /// the pool is empty, and are reset to their defaults when given back, so reusing one
+      /// allocates nothing. Sets can be taken from several threads at once.
+      class SetPool {
+        Set                  _prototype;
+        std::vector<Set *>   _free;
+        MultiThread::Mutex   _lock;
+
+        /// hide copy and assignment
+        SetPool(const SetPool &);
+        void operator=(const SetPool &);
+
+      public :
+        /// make a pool of sets described by the PropSpecs
+        explicit SetPool(const PropSpec *spec);
+
+        /// make a pool of copies of the prototype
+        explicit SetPool(const Set &prototype);
+
+        ~SetPool();
+
+        /// take a set from the pool, with all properties at their defaults
+        Set *acquire();
+
+        /// reset a set and give it back to the pool
+        void release(Set *set);
+      };
+
+      /// takes a set from a SetPool for the life of the object
+      class PooledSet {
+        SetPool &_pool;
+        Set     *_set;
+
+        /// hide copy and assignment
+        PooledSet(const PooledSet &);
+        void operator=(const PooledSet &);
+
+      public :
+        explicit PooledSet(SetPool &pool) : _pool(pool), _set(pool.acquire()) {}
+        ~PooledSet() { _pool.release(_set); }
+
+        Set &operator*() const { return *_set; }
+        Set *operator->() const { return _set; }
+      };
+
       
       /// return the OFX function suite that manages properties
       const void *GetSuite(int version);
+
+      /// return the OFX function suite that gets many properties in one call, see ofxPropertyBatch.h
+      const void *GetBatchSuite(int version);
     }
   }
 }
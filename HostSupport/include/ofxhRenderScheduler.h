@@ -0,0 +1,176 @@
+
+/*
+Software License :
+
+Copyright (c) 2007-2009, The Open Effects Association Ltd. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+* Neither the name The Open Effects Association Ltd, nor the names of its 
+contributors may be used to endorse or promote products derived from this
+software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OFX_RENDER_SCHEDULER_H
+#define OFX_RENDER_SCHEDULER_H
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include "ofxCore.h"
+#include "ofxImageEffect.h"
+
+#include "ofxhMultiThread.h"
+
+namespace OFX {
+
+  namespace Host {
+
+    namespace ImageEffect {
+
+      // forward declare
+      class Instance;
+
+      /// The arguments to the render actions that are common to every frame of a render.
+      struct RenderArgs {
+        OfxTime     startFrame;         ///< first frame to render
+        OfxTime     endFrame;           ///< last frame to render, inclusive
+        OfxTime     step;               ///< frame step, must be positive
+        std::string field;              ///< field to render, defaults to kOfxImageFieldNone
+        OfxRectI    renderWindow;       ///< render window, in pixel coordinates
+        OfxPointD   renderScale;        ///< defaults to 1,1
+        bool        interactive;
+        bool        interactiveRender;
+        bool        draftRender;
+#     ifdef OFX_SUPPORTS_OPENGLRENDER
+        bool        openGLRender;
+#      ifdef OFX_EXTENSIONS_NATRON
+        void       *contextData;
+#      endif
+#     endif
+#     if defined(OFX_EXTENSIONS_VEGAS) || defined(OFX_EXTENSIONS_NUKE)
+        int         view;
+#     endif
+#     ifdef OFX_EXTENSIONS_VEGAS
+        int         nViews;
+#     endif
+#     ifdef OFX_EXTENSIONS_NUKE
+        std::list<std::string> planes;
+#     endif
+
+        RenderArgs();
+
+        /// the number of frames from startFrame to endFrame
+        int getNFrames() const;
+
+        /// the time of the nth frame
+        OfxTime getFrame(int n) const { return startFrame + n * step; }
+      };
+
+      /// Renders a range of frames of an effect instance, rendering frames concurrently on a
+      /// thread pool where the effect's kOfxImageEffectPluginRenderThreadSafety allows it.
+      ///
+      ///   - kOfxImageEffectRenderFullySafe effects render all the frames concurrently on the
+      ///     one instance, inside a single begin/end sequence render pair,
+      ///   - kOfxImageEffectRenderInstanceSafe effects render concurrently on several instances,
+      ///     one per thread, each with its own begin/end sequence render pair. The extra instances
+      ///     come from newRenderInstance(),
+      ///   - kOfxImageEffectRenderUnsafe effects, and effects that require sequential rendering,
+      ///     render their frames in order on the calling thread. No two instances of an unsafe
+      ///     plugin render at once through any scheduler.
+      ///
+      /// The host's clips must support getImage being called from several threads at once.
+      class RenderScheduler {
+      public:
+        /// how the frames of a render are shared out
+        enum ThreadingEnum {
+          eThreadingSerial,            ///< one frame at a time, in order, on the calling thread
+          eThreadingSharedInstance,    ///< frames rendered concurrently on the one instance
+          eThreadingInstancePerThread  ///< frames rendered concurrently, each thread with its own instance
+        };
+
+        /// render the given instance on the given pool, the instance must have been created
+        /// and its clip preferences fetched
+        RenderScheduler(Instance &instance, MultiThread::ThreadPool &pool);
+
+        /// destroys any instances made by newRenderInstance()
+        virtual ~RenderScheduler();
+
+        /// the instance being rendered
+        Instance &getInstance() const { return _instance; }
+
+        /// how the frames of a render would currently be shared out
+        ThreadingEnum getThreading() const;
+
+        /// Render all the frames in the given args, returns the first failing status from any of
+        /// the actions, or kOfxStatOK. Rendering stops early on failure or if the instance aborts.
+        OfxStatus render(const RenderArgs &args);
+
+        /// Destroy the extra instances made for instance safe effects, call this if the main
+        /// instance's params or clips change so that the next render makes fresh ones.
+        void clearRenderInstances();
+
+        /// call beginRenderAction on the instance with the given args
+        static OfxStatus beginRenderAction(Instance &instance, const RenderArgs &args, bool sequentialRender);
+
+        /// call endRenderAction on the instance with the given args
+        static OfxStatus endRenderAction(Instance &instance, const RenderArgs &args, bool sequentialRender);
+
+        /// call renderAction on the instance for the given window, with the rest of the arguments from args
+        static OfxStatus renderAction(Instance &instance, OfxTime time, const OfxRectI &renderWindow,
+                                      const RenderArgs &args, bool sequentialRender);
+
+      protected:
+        /// Override this to make another instance of the effect for a render thread of an instance
+        /// safe effect, with the same params and clip connections as the main instance, on which
+        /// createInstanceAction and getClipPreferences have been called. Returning NULL limits the
+        /// render to the instances made so far. The scheduler owns the instance and calls
+        /// destroyInstanceAction before deleting it.
+        ///
+        /// The default returns NULL, so instance safe effects render serially on the main instance.
+        virtual Instance *newRenderInstance();
+
+        /// Render a single frame on the given instance, this may be called on several threads at
+        /// once. The default calls renderAction with the render args. Override this to do any per
+        /// frame work, eg: computing a render window or saving the output image.
+        virtual OfxStatus renderFrame(Instance &instance, OfxTime time, const RenderArgs &args, bool sequentialRender);
+
+      private:
+        RenderScheduler(const RenderScheduler &);
+        RenderScheduler &operator=(const RenderScheduler &);
+
+        struct RenderState;
+        static void renderThreadFunction(unsigned int threadIndex, unsigned int threadMax, void *customArg);
+
+        OfxStatus renderSerially(const RenderArgs &args);
+
+        Instance                &_instance;
+        MultiThread::ThreadPool &_pool;
+        std::vector<Instance *>  _renderInstances; ///< extra instances for instance safe effects
+      };
+
+    } // namespace ImageEffect
+
+  } // namespace Host
+
+} // namespace OFX
+
+#endif // OFX_RENDER_SCHEDULER_H
@@ -0,0 +1,147 @@
+
+/*
+Software License :
+
+Copyright (c) 2007-2009, The Open Effects Association Ltd. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+* Neither the name The Open Effects Association Ltd, nor the names of its 
+contributors may be used to endorse or promote products derived from this
+software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OFX_TILE_RENDERER_H
+#define OFX_TILE_RENDERER_H
+
+#include <map>
+#include <vector>
+
+#include "ofxCore.h"
+#include "ofxImageEffect.h"
+
+#include "ofxhMultiThread.h"
+#include "ofxhRenderScheduler.h"
+
+namespace OFX {
+
+  namespace Host {
+
+    namespace ImageEffect {
+
+      // forward declare
+      class ClipInstance;
+      class Image;
+      class Instance;
+
+      /// a tile of a render and the regions of the input clips needed to render it
+      struct RenderTile {
+        OfxRectI                            window; ///< the tile, in pixel coordinates
+        std::map<ClipInstance *, OfxRectD>  rois;   ///< region of interest on each input clip, in canonical coordinates
+      };
+
+      /// Renders a frame of an effect as a set of tiles, for effects that support tiles.
+      ///
+      /// The render window is split into tiles sized so that a tile of the output fits in
+      /// the cache. The regions of interest of each tile are found with the region of interest
+      /// action, then the tiles are rendered, concurrently on the thread pool if the effect
+      /// is fully thread safe.
+      ///
+      /// Before a tile is rendered, each connected input clip's image is fetched for just that
+      /// tile's region of interest, through ClipInstance::getImage with the region as bounds.
+      /// While the tile renders, clipGetImage calls the plugin makes on that thread for those
+      /// clips at the render time, with no bounds or bounds inside the region, are given those
+      /// images rather than asking the clip again. setPrefetchInputs(false) turns this off.
+      ///
+      /// Calls to renderFrame() must be made between the begin/end sequence render actions, a
+      /// RenderScheduler may call it from its own renderFrame. Several frames of a fully safe
+      /// effect may then be rendered at once on one instance, so the region of interest action,
+      /// which need not be thread safe, is called on one thread at a time for each instance.
+      class TileRenderer {
+      public:
+        TileRenderer(MultiThread::ThreadPool &pool);
+        virtual ~TileRenderer();
+
+        /// set the number of bytes of output a tile should hold, the default is 512KB
+        void setTileBytes(size_t nBytes) { _tileBytes = nBytes; }
+
+        /// set a fixed tile size in pixels, 0 means size tiles by setTileBytes()
+        void setTileSize(int width, int height) { _tileWidth = width; _tileHeight = height; }
+
+        /// fetch the input images each tile needs before rendering it, the default is true
+        void setPrefetchInputs(bool prefetch) { _prefetchInputs = prefetch; }
+
+        /// can the instance be rendered in tiles, ie: do the effect and its output clip support tiles
+        static bool canTile(const Instance &instance);
+
+        /// the tile size that would be used to render the given instance
+        void getTileSize(Instance &instance, int &width, int &height) const;
+
+        /// split a window into tiles of the given size, row by row from the bottom left
+        static void splitIntoTiles(const OfxRectI &window, int tileWidth, int tileHeight, std::vector<OfxRectI> &tiles);
+
+        /// Render the args' render window of the given frame. Effects that can't be tiled
+        /// are rendered in one go.
+        OfxStatus renderFrame(Instance &instance, OfxTime time, const RenderArgs &args, bool sequentialRender);
+
+        /// Used by clipGetImage. If the calling thread is rendering a tile, returns the image of
+        /// the clip fetched for it, with a reference added for the caller, provided the time
+        /// matches and bounds is NULL or inside the tile's region of interest. Otherwise NULL.
+        static Image *getPrefetchedImage(ClipInstance *clip, OfxTime time, const OfxRectD *bounds);
+
+      protected:
+        /// Called before a tile is rendered and its inputs are fetched, possibly on several
+        /// threads at once. The default does nothing.
+        virtual OfxStatus prepareTile(Instance &instance, OfxTime time, const RenderTile &tile);
+
+        /// Called after a tile has been rendered, with the status of the render action, possibly on
+        /// several threads at once. Override this to release anything prepareTile acquired. The
+        /// default does nothing.
+        virtual void tileRendered(Instance &instance, OfxTime time, const RenderTile &tile, OfxStatus stat);
+
+      private:
+        TileRenderer(const TileRenderer &);
+        TileRenderer &operator=(const TileRenderer &);
+
+        struct TileState;
+        static void tileThreadFunction(unsigned int threadIndex, unsigned int threadMax, void *customArg);
+
+        OfxStatus renderTile(Instance &instance, OfxTime time, const RenderTile &tile, const RenderArgs &args, bool sequentialRender);
+
+        /// the lock held while calling the region of interest action on an instance
+        MultiThread::Mutex &getRoILock(Instance &instance);
+
+        MultiThread::ThreadPool &_pool;
+        size_t                   _tileBytes;
+        int                      _tileWidth;
+        int                      _tileHeight;
+        bool                     _prefetchInputs;
+
+        MultiThread::Mutex                           _roiLocksLock; ///< guards _roiLocks
+        std::map<Instance *, MultiThread::Mutex *>   _roiLocks;
+      };
+
+    } // namespace ImageEffect
+
+  } // namespace Host
+
+} // namespace OFX
+
+#endif // OFX_TILE_RENDERER_H
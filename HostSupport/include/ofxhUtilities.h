@@ -141,6 +141,23 @@ namespace OFX {
     return r;
   }
 
+  /// the starting value for HashBytes
+  const unsigned long long kHashSeed = 14695981039346656037ULL;
+
+  /// the 64 bit FNV-1a hash of some bytes, carrying on from the given hash
+  inline unsigned long long HashBytes(const void *data, size_t nBytes, unsigned long long hash = kHashSeed)
+  {
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    for(size_t i = 0; i < nBytes; ++i) {
+      hash ^= bytes[i];
+      hash *= 1099511628211ULL;
+    }
+    return hash;
+  }
+
+  /// seconds since some arbitrary point in the past, from a monotonic high resolution clock, for timing things
+  double GetTimeInSeconds();
+
   inline const char* StatStr(OfxStatus stat) {
     switch(stat) {
       case kOfxStatOK:
@@ -27,12 +27,14 @@ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <stdio.h>
+
 #include "ofxhBinary.h"
 #include "ofxhUtilities.h"
 
 using namespace OFX;
 
-Binary::Binary(const std::string &binaryPath): _binaryPath(binaryPath), _invalid(false), _dlHandle(NULL), _users(0)
+Binary::Binary(const std::string &binaryPath): _binaryPath(binaryPath), _invalid(false), _dlHandle(NULL), _users(0), _loadTime(0)
 {
   _invalid = !getFileModTimeAndSize(binaryPath, _time, _size);
 }
@@ -59,17 +61,53 @@ bool Binary::getFileModTimeAndSize(const std::string &binaryPath, time_t& modifi
   }
 }
 
+bool Binary::getFileContentHash(const std::string &binaryPath, std::string &hash)
+{
+#ifdef WINDOWS
+  FILE *f = _wfopen(OFX::utf8_to_utf16(binaryPath).c_str(), L"rb");
+#else
+  FILE *f = fopen(binaryPath.c_str(), "rb");
+#endif
+  if (!f) {
+    return false;
+  }
+
+  unsigned long long h = 14695981039346656037ULL;
+  unsigned char buffer[65536];
+  size_t n;
+  while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0) {
+    for (size_t i = 0; i < n; ++i) {
+      h ^= buffer[i];
+      h *= 1099511628211ULL;
+    }
+  }
+  bool ok = !ferror(f);
+  fclose(f);
+  if (!ok) {
+    return false;
+  }
+
+  static const char hexDigits[] = "0123456789abcdef";
+  hash.resize(16);
+  for (int i = 15; i >= 0; --i, h >>= 4) {
+    hash[i] = hexDigits[h & 0xf];
+  }
+  return true;
+}
+
 // actually open the binary.
 void Binary::load() 
 {
   if(_invalid)
     return;
 
+  double start = GetTimeInSeconds();
 #if defined (UNIX)
   _dlHandle = dlopen(_binaryPath.c_str(), RTLD_LAZY|RTLD_LOCAL);
 #else
   _dlHandle = LoadLibraryW(utf8_to_utf16(_binaryPath).c_str());
 #endif
+  _loadTime = GetTimeInSeconds() - start;
   if (_dlHandle == 0) {
 #if defined (UNIX)
     std::cerr << "couldn't open library " << _binaryPath << " because " << dlerror() << std::endl;
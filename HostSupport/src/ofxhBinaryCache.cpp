@@ -0,0 +1,488 @@
+
+/*
+Software License :
+
+Copyright (c) 2007-2009, The Open Effects Association Ltd. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+* Neither the name The Open Effects Association Ltd, nor the names of its 
+contributors may be used to endorse or promote products derived from this
+software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <string.h>
+#include <ostream>
+
+#include "ofxCore.h"
+#include "ofxhBinary.h"
+#include "ofxhBinaryCache.h"
+
+#include "ofxhUtilities.h"
+
+#ifdef WINDOWS
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace OFX {
+
+  namespace Host {
+
+    namespace BinaryCache {
+
+      static const char   kMagic[8] = "OFXHBCF";
+      static const UInt32 kByteOrderMark = 0x01020304;
+
+      // the layout must not depend on the compiler
+      typedef char HeaderSizeCheck[sizeof(Header) == 72 ? 1 : -1];
+      typedef char BinaryRecordSizeCheck[sizeof(BinaryRecord) == 40 ? 1 : -1];
+      typedef char PluginRecordSizeCheck[sizeof(PluginRecord) == 32 ? 1 : -1];
+      typedef char SetRecordSizeCheck[sizeof(SetRecord) == 24 ? 1 : -1];
+      typedef char PropertyRecordSizeCheck[sizeof(PropertyRecord) == 24 ? 1 : -1];
+      typedef char ValueSizeCheck[sizeof(Value) == 8 ? 1 : -1];
+
+      ////////////////////////////////////////////////////////////////////////////////
+      // Writer
+
+      Writer::Writer(const std::string &cacheVersion)
+      {
+        _cacheVersion = addString(cacheVersion);
+      }
+
+      UInt32 Writer::addString(const std::string &s)
+      {
+        std::map<std::string, UInt32>::const_iterator i = _stringOffsets.find(s);
+        if(i != _stringOffsets.end())
+          return i->second;
+
+        UInt32 offset = UInt32(_strings.size());
+        _strings.append(s.c_str(), s.size() + 1);
+        _stringOffsets[s] = offset;
+        return offset;
+      }
+
+      void Writer::addBinary(const std::string &path, const std::string &bundlePath, Int64 mtime, Int64 size, bool isStatic,
+                             const std::string &hash)
+      {
+        BinaryRecord record;
+        memset(&record, 0, sizeof(record));
+        record.mtime = mtime;
+        record.size = size;
+        record.path = addString(path);
+        record.bundlePath = addString(bundlePath);
+        record.isStatic = isStatic ? 1 : 0;
+        record.hash = addString(hash);
+        record.firstPlugin = UInt32(_plugins.size());
+        record.nPlugins = 0;
+        _binaries.push_back(record);
+      }
+
+      void Writer::addPlugin(const std::string &identifier, const std::string &api, int index,
+                             int apiVersion, int versionMajor, int versionMinor)
+      {
+        PluginRecord record;
+        memset(&record, 0, sizeof(record));
+        record.identifier = addString(identifier);
+        record.api = addString(api);
+        record.index = index;
+        record.apiVersion = apiVersion;
+        record.versionMajor = versionMajor;
+        record.versionMinor = versionMinor;
+        record.firstSet = UInt32(_sets.size());
+        record.nSets = 0;
+        _plugins.push_back(record);
+        _binaries.back().nPlugins++;
+      }
+
+      void Writer::addSet(const std::string &tag, const std::string &name, const std::string &type, const Property::Set &set)
+      {
+        SetRecord record;
+        memset(&record, 0, sizeof(record));
+        record.tag = addString(tag);
+        record.name = addString(name);
+        record.type = addString(type);
+        record.firstProperty = UInt32(_properties.size());
+
+        const Property::PropertyMap &props = set.getProperties();
+        for(Property::PropertyMap::const_iterator i = props.begin(); i != props.end(); ++i) {
+          Property::Property *prop = i->second;
+          if(prop->getType() == Property::ePointer)
+            continue;
+
+          PropertyRecord propRecord;
+          memset(&propRecord, 0, sizeof(propRecord));
+          propRecord.name = addString(prop->getName());
+          propRecord.type = UInt32(prop->getType());
+          propRecord.fixedDimension = prop->getFixedDimension();
+          propRecord.dimension = UInt32(prop->getDimension());
+          propRecord.firstValue = UInt32(_values.size());
+
+          for(UInt32 j = 0; j < propRecord.dimension; ++j) {
+            Value value;
+            memset(&value, 0, sizeof(value));
+            switch(prop->getType()) {
+            case Property::eInt :
+              value.i = static_cast<Property::Int *>(prop)->getValueVector()[j];
+              break;
+            case Property::eDouble :
+              value.d = static_cast<Property::Double *>(prop)->getValueVector()[j];
+              break;
+            case Property::eString :
+              value.s = addString(static_cast<Property::String *>(prop)->getValueVector()[j]);
+              break;
+            default :
+              break;
+            }
+            _values.push_back(value);
+          }
+
+          _properties.push_back(propRecord);
+          record.nProperties++;
+        }
+
+        _sets.push_back(record);
+        _plugins.back().nSets++;
+      }
+
+      /// round up to a multiple of 8, so every table is aligned for its records
+      static UInt32 align8(size_t n)
+      {
+        return UInt32((n + 7) & ~size_t(7));
+      }
+
+      /// write a table and pad it to a multiple of 8
+      static void writeTable(std::ostream &os, const void *data, size_t nBytes)
+      {
+        static const char zeros[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+        if(nBytes)
+          os.write(static_cast<const char *>(data), std::streamsize(nBytes));
+        os.write(zeros, std::streamsize(align8(nBytes) - nBytes));
+      }
+
+      template<class T> static const void *tableData(const std::vector<T> &v)
+      {
+        return v.empty() ? 0 : &v[0];
+      }
+
+      void Writer::write(std::ostream &os) const
+      {
+        Header header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, kMagic, sizeof(header.magic));
+        header.formatVersion = kFormatVersion;
+        header.byteOrder = kByteOrderMark;
+        header.cacheVersion = _cacheVersion;
+
+        UInt32 offset = align8(sizeof(Header));
+        header.strings.offset = offset;
+        header.strings.count = UInt32(_strings.size());
+        offset += align8(_strings.size());
+        header.binaries.offset = offset;
+        header.binaries.count = UInt32(_binaries.size());
+        offset += align8(_binaries.size() * sizeof(BinaryRecord));
+        header.plugins.offset = offset;
+        header.plugins.count = UInt32(_plugins.size());
+        offset += align8(_plugins.size() * sizeof(PluginRecord));
+        header.sets.offset = offset;
+        header.sets.count = UInt32(_sets.size());
+        offset += align8(_sets.size() * sizeof(SetRecord));
+        header.properties.offset = offset;
+        header.properties.count = UInt32(_properties.size());
+        offset += align8(_properties.size() * sizeof(PropertyRecord));
+        header.values.offset = offset;
+        header.values.count = UInt32(_values.size());
+
+        writeTable(os, &header, sizeof(header));
+        writeTable(os, _strings.data(), _strings.size());
+        writeTable(os, tableData(_binaries), _binaries.size() * sizeof(BinaryRecord));
+        writeTable(os, tableData(_plugins), _plugins.size() * sizeof(PluginRecord));
+        writeTable(os, tableData(_sets), _sets.size() * sizeof(SetRecord));
+        writeTable(os, tableData(_properties), _properties.size() * sizeof(PropertyRecord));
+        writeTable(os, tableData(_values), _values.size() * sizeof(Value));
+      }
+
+      ////////////////////////////////////////////////////////////////////////////////
+      // Reader
+
+      /// a read only memory mapping of a whole file
+      class Reader::MappedFile {
+#ifdef WINDOWS
+        HANDLE _file;
+        HANDLE _mapping;
+#endif
+        const char *_data;
+        size_t      _size;
+
+      public :
+        explicit MappedFile(const std::string &path)
+          : _data(0)
+          , _size(0)
+        {
+#ifdef WINDOWS
+          _mapping = NULL;
+          _file = CreateFileW(OFX::utf8_to_utf16(path).c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+          if(_file == INVALID_HANDLE_VALUE)
+            return;
+          LARGE_INTEGER size;
+          if(!GetFileSizeEx(_file, &size) || size.QuadPart == 0)
+            return;
+          _mapping = CreateFileMappingW(_file, NULL, PAGE_READONLY, 0, 0, NULL);
+          if(!_mapping)
+            return;
+          _data = static_cast<const char *>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+          if(_data)
+            _size = size_t(size.QuadPart);
+#else
+          int fd = ::open(path.c_str(), O_RDONLY);
+          if(fd < 0)
+            return;
+          struct stat sb;
+          if(fstat(fd, &sb) == 0 && sb.st_size > 0) {
+            void *data = mmap(0, size_t(sb.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if(data != MAP_FAILED) {
+              _data = static_cast<const char *>(data);
+              _size = size_t(sb.st_size);
+            }
+          }
+          // the mapping outlives the descriptor
+          close(fd);
+#endif
+        }
+
+        ~MappedFile()
+        {
+#ifdef WINDOWS
+          if(_data)
+            UnmapViewOfFile(_data);
+          if(_mapping)
+            CloseHandle(_mapping);
+          if(_file != INVALID_HANDLE_VALUE)
+            CloseHandle(_file);
+#else
+          if(_data)
+            munmap(const_cast<char *>(_data), _size);
+#endif
+        }
+
+        const char *data() const { return _data; }
+        size_t size() const { return _size; }
+      };
+
+      Reader::Reader()
+        : _file(0)
+        , _data(0)
+        , _size(0)
+        , _header(0)
+      {
+      }
+
+      Reader::~Reader()
+      {
+        delete _file;
+      }
+
+      bool Reader::open(const std::string &path, const std::string &cacheVersion, std::string &why)
+      {
+        reset();
+        _file = new MappedFile(path);
+        if(!_file->data()) {
+          why = "could not map " + path;
+          reset();
+          return false;
+        }
+        return use(_file->data(), _file->size(), cacheVersion, why);
+      }
+
+      bool Reader::read(const std::string &data, const std::string &cacheVersion, std::string &why)
+      {
+        reset();
+        _buffer.assign((data.size() + sizeof(Int64) - 1) / sizeof(Int64), 0);
+        if(!data.empty())
+          memcpy(&_buffer[0], data.data(), data.size());
+        return use(_buffer.empty() ? 0 : reinterpret_cast<const char *>(&_buffer[0]), data.size(), cacheVersion, why);
+      }
+
+      bool Reader::use(const char *data, size_t size, const std::string &cacheVersion, std::string &why)
+      {
+        _data = data;
+        _size = size;
+        _header = 0;
+
+        if(_size < sizeof(Header)) {
+          why = "too short";
+        }
+        else {
+          _header = reinterpret_cast<const Header *>(_data);
+          if(validate(cacheVersion, why))
+            return true;
+        }
+
+        reset();
+        return false;
+      }
+
+      void Reader::reset()
+      {
+        delete _file;
+        _file = 0;
+        _buffer.clear();
+        _data = 0;
+        _size = 0;
+        _header = 0;
+      }
+
+      bool Reader::inFile(UInt32 offset, UInt32 count, size_t recordSize) const
+      {
+        return offset % 8 == 0 && (unsigned long long)offset + (unsigned long long)count * recordSize <= _size;
+      }
+
+      /// are count things from first inside a table of total things
+      static bool inTable(UInt32 first, UInt32 count, UInt32 total)
+      {
+        return first <= total && count <= total - first;
+      }
+
+      bool Reader::validate(const std::string &cacheVersion, std::string &why) const
+      {
+        const Header &h = *_header;
+        if(memcmp(h.magic, kMagic, sizeof(kMagic)) != 0) {
+          why = "not a binary plugin cache";
+          return false;
+        }
+        if(h.formatVersion != kFormatVersion || h.byteOrder != kByteOrderMark) {
+          why = "written by an incompatible host";
+          return false;
+        }
+        if(!inFile(h.strings.offset, h.strings.count, 1) ||
+           !inFile(h.binaries.offset, h.binaries.count, sizeof(BinaryRecord)) ||
+           !inFile(h.plugins.offset, h.plugins.count, sizeof(PluginRecord)) ||
+           !inFile(h.sets.offset, h.sets.count, sizeof(SetRecord)) ||
+           !inFile(h.properties.offset, h.properties.count, sizeof(PropertyRecord)) ||
+           !inFile(h.values.offset, h.values.count, sizeof(Value))) {
+          why = "truncated";
+          return false;
+        }
+
+        // with a nul at the end of the string table, any offset into it is a valid string
+        const UInt32 nChars = h.strings.count;
+        if(nChars == 0 || _data[h.strings.offset + nChars - 1] != 0) {
+          why = "bad string table";
+          return false;
+        }
+
+        if(h.cacheVersion >= nChars || cacheVersion != getString(h.cacheVersion)) {
+          why = "mismatched cache version";
+          return false;
+        }
+
+        why = "corrupt";
+        for(UInt32 i = 0; i < h.binaries.count; ++i) {
+          const BinaryRecord &r = getBinary(i);
+          if(r.path >= nChars || r.bundlePath >= nChars || r.hash >= nChars || !inTable(r.firstPlugin, r.nPlugins, h.plugins.count))
+            return false;
+        }
+        for(UInt32 i = 0; i < h.plugins.count; ++i) {
+          const PluginRecord &r = getPlugin(i);
+          if(r.identifier >= nChars || r.api >= nChars || !inTable(r.firstSet, r.nSets, h.sets.count))
+            return false;
+        }
+        for(UInt32 i = 0; i < h.sets.count; ++i) {
+          const SetRecord &r = getSet(i);
+          if(r.tag >= nChars || r.name >= nChars || r.type >= nChars || !inTable(r.firstProperty, r.nProperties, h.properties.count))
+            return false;
+        }
+        const PropertyRecord *props = records<PropertyRecord>(h.properties);
+        const Value *values = records<Value>(h.values);
+        for(UInt32 i = 0; i < h.properties.count; ++i) {
+          const PropertyRecord &r = props[i];
+          if(r.name >= nChars || r.type > UInt32(Property::eString) || r.fixedDimension < 0 || !inTable(r.firstValue, r.dimension, h.values.count))
+            return false;
+          if(r.type == UInt32(Property::eString)) {
+            for(UInt32 j = 0; j < r.dimension; ++j) {
+              if(values[r.firstValue + j].s >= nChars)
+                return false;
+            }
+          }
+        }
+
+        why.clear();
+        return true;
+      }
+
+      void Reader::readSet(const SetRecord &record, Property::Set &set) const
+      {
+        const PropertyRecord *props = records<PropertyRecord>(_header->properties) + record.firstProperty;
+        const Value *values = records<Value>(_header->values);
+
+        for(UInt32 i = 0; i < record.nProperties; ++i) {
+          const PropertyRecord &r = props[i];
+          const char *name = getString(r.name);
+          Property::TypeEnum type = Property::TypeEnum(r.type);
+
+          Property::Property *prop = set.fetchProperty(name, false);
+          if(!prop) {
+            switch(type) {
+            case Property::eInt :
+              prop = new Property::Int(name, r.fixedDimension, false, 0);
+              break;
+            case Property::eDouble :
+              prop = new Property::Double(name, r.fixedDimension, false, 0);
+              break;
+            case Property::eString :
+              prop = new Property::String(name, r.fixedDimension, false, "");
+              break;
+            default :
+              continue;
+            }
+            set.addProperty(prop);
+          }
+          else if(prop->getType() != type) {
+            continue;
+          }
+
+          const Value *v = values + r.firstValue;
+          for(UInt32 j = 0; j < r.dimension; ++j) {
+            switch(type) {
+            case Property::eInt :
+              static_cast<Property::Int *>(prop)->setValue(int(v[j].i), int(j));
+              break;
+            case Property::eDouble :
+              static_cast<Property::Double *>(prop)->setValue(v[j].d, int(j));
+              break;
+            case Property::eString :
+              static_cast<Property::String *>(prop)->setValue(getString(v[j].s), int(j));
+              break;
+            default :
+              break;
+            }
+          }
+        }
+      }
+
+    }
+
+  }
+
+}
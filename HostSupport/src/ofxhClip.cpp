@@ -90,6 +90,7 @@ namespace OFX {
       ClipBase::ClipBase()
         : _properties(clipDescriptorStuffs) 
       {
+        _properties.setKind("clip");
       }
 
       /// props to clips and 
@@ -698,6 +699,7 @@ namespace OFX {
         : Property::Set(imageBaseStuffs)
         , _referenceCount(1)
       {
+        setKind("image");
       }
 
       /// called during ctor to get bits from the clip props into ours
@@ -725,6 +727,7 @@ namespace OFX {
         : Property::Set(imageBaseStuffs)
         , _referenceCount(1)
       {
+        setKind("image");
         getClipBits(instance);
       }      
 
@@ -740,6 +743,7 @@ namespace OFX {
         : Property::Set(imageBaseStuffs)
         , _referenceCount(1)
       {
+        setKind("image");
         getClipBits(instance);
 
         // set other data
@@ -781,8 +785,7 @@ namespace OFX {
       // release the reference 
       void ImageBase::releaseReference()
       {
-        _referenceCount -= 1;
-        if(_referenceCount <= 0)
+        if(--_referenceCount <= 0)
           delete this;
       }
 
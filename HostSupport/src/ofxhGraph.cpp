@@ -0,0 +1,366 @@
+
+/*
+Software License :
+
+Copyright (c) 2007-2009, The Open Effects Association Ltd. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+* Neither the name The Open Effects Association Ltd, nor the names of its 
+contributors may be used to endorse or promote products derived from this
+software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <math.h>
+#include <algorithm>
+#include <set>
+
+// ofx
+#include "ofxCore.h"
+#include "ofxImageEffect.h"
+
+// ofx host
+#include "ofxhBinary.h"
+#include "ofxhPropertySuite.h"
+#include "ofxhClip.h"
+#include "ofxhImageEffect.h"
+#include "ofxhUtilities.h"
+#include "ofxhRenderScheduler.h"
+#include "ofxhGraph.h"
+
+namespace OFX {
+
+  namespace Host {
+
+    namespace ImageEffect {
+
+      /// did the action succeed
+      static bool statusOK(OfxStatus stat)
+      {
+        return stat == kOfxStatOK || stat == kOfxStatReplyDefault;
+      }
+
+      /// is the rect empty
+      static bool isEmpty(const OfxRectD &r)
+      {
+        return r.x2 <= r.x1 || r.y2 <= r.y1;
+      }
+
+      /// the frames in a set of frame ranges, every whole frame in a range plus its ends
+      static void getFrames(const std::vector<OfxRangeD> &ranges, std::set<OfxTime> &frames)
+      {
+        for(size_t i = 0; i < ranges.size(); ++i) {
+          const OfxRangeD &range = ranges[i];
+          frames.insert(range.min);
+          for(OfxTime t = ceil(range.min); t < range.max; t += 1.)
+            frames.insert(t);
+          frames.insert(range.max);
+        }
+      }
+
+      Graph::Graph()
+#     ifdef OFX_EXTENSIONS_NUKE
+        : _view(0)
+#     endif
+      {
+        _renderScale.x = _renderScale.y = 1.;
+      }
+
+      Graph::~Graph()
+      {
+      }
+
+      void Graph::addNode(Instance *node)
+      {
+        if(node && std::find(_nodes.begin(), _nodes.end(), node) == _nodes.end())
+          _nodes.push_back(node);
+      }
+
+      void Graph::removeNode(Instance *node)
+      {
+        std::vector<Instance *>::iterator found = std::find(_nodes.begin(), _nodes.end(), node);
+        if(found == _nodes.end())
+          return;
+        _nodes.erase(found);
+
+        // drop connections to and from the node
+        for(int i = 0; i < node->getNClips(); ++i)
+          _inputs.erase(node->getNthClip(i));
+        for(std::map<ClipInstance *, Instance *>::iterator it = _inputs.begin(); it != _inputs.end();) {
+          if(it->second == node)
+            _inputs.erase(it++);
+          else
+            ++it;
+        }
+
+        invalidate();
+      }
+
+      bool Graph::connect(Instance *upstream, Instance *downstream, const std::string &clipName)
+      {
+        if(std::find(_nodes.begin(), _nodes.end(), upstream) == _nodes.end() ||
+           std::find(_nodes.begin(), _nodes.end(), downstream) == _nodes.end())
+          return false;
+
+        ClipInstance *clip = downstream->getClip(clipName);
+        if(!clip || clip->isOutput())
+          return false;
+
+        if(isUpstream(downstream, upstream))
+          return false;
+
+        _inputs[clip] = upstream;
+        invalidate();
+        return true;
+      }
+
+      void Graph::disconnect(Instance *downstream, const std::string &clipName)
+      {
+        ClipInstance *clip = downstream->getClip(clipName);
+        if(clip && _inputs.erase(clip))
+          invalidate();
+      }
+
+      Instance *Graph::getInput(ClipInstance *clip) const
+      {
+        std::map<ClipInstance *, Instance *>::const_iterator found = _inputs.find(clip);
+        return found == _inputs.end() ? 0 : found->second;
+      }
+
+      Instance *Graph::getInput(Instance *downstream, const std::string &clipName) const
+      {
+        return getInput(downstream->getClip(clipName));
+      }
+
+      bool Graph::isUpstream(Instance *node, Instance *of) const
+      {
+        if(node == of)
+          return true;
+        for(int i = 0; i < of->getNClips(); ++i) {
+          Instance *input = getInput(of->getNthClip(i));
+          if(input && isUpstream(node, input))
+            return true;
+        }
+        return false;
+      }
+
+      void Graph::sortNodes(Instance *output, std::vector<Instance *> &order) const
+      {
+        std::map<Instance *, bool> visited;
+        order.clear();
+        sortNodes(output, order, visited);
+      }
+
+      void Graph::sortNodes(Instance *node, std::vector<Instance *> &order, std::map<Instance *, bool> &visited) const
+      {
+        bool &seen = visited[node];
+        if(seen)
+          return;
+        seen = true;
+
+        for(int i = 0; i < node->getNClips(); ++i) {
+          Instance *input = getInput(node->getNthClip(i));
+          if(input)
+            sortNodes(input, order, visited);
+        }
+        order.push_back(node);
+      }
+
+      void Graph::invalidate()
+      {
+        _rods.clear();
+        _needed.clear();
+      }
+
+      OfxStatus Graph::getRegionOfDefinition(Instance *node, OfxTime time, OfxRectD &rod)
+      {
+        RegionMap &rods = _rods[node];
+        RegionMap::iterator found = rods.find(time);
+        if(found != rods.end()) {
+          rod = found->second;
+          return kOfxStatOK;
+        }
+
+        // upstream clips may call back into the graph for their own region of definition
+        OfxStatus st = node->getRegionOfDefinitionAction(time, _renderScale,
+#                                                        ifdef OFX_EXTENSIONS_NUKE
+                                                         _view,
+#                                                        endif
+                                                         rod);
+        if(statusOK(st))
+          _rods[node][time] = rod;
+        return st;
+      }
+
+      OfxStatus Graph::evaluate(Instance *output, OfxTime time, const OfxRectD &roi, const RenderArgs &args)
+      {
+        bool sameScale = args.renderScale.x == _renderScale.x && args.renderScale.y == _renderScale.y;
+#     ifdef OFX_EXTENSIONS_NUKE
+        sameScale = sameScale && args.view == _view;
+        _view = args.view;
+#     endif
+        if(!sameScale)
+          _rods.clear();
+        _renderScale = args.renderScale;
+        _needed.clear();
+
+        std::vector<Instance *> order;
+        sortNodes(output, order);
+
+        // frames needed, downstream first
+        std::map<Instance *, std::set<OfxTime> > frames;
+        std::map<Instance *, std::map<OfxTime, RangeMap> > framesNeeded;
+        frames[output].insert(time);
+        for(std::vector<Instance *>::reverse_iterator node = order.rbegin(); node != order.rend(); ++node) {
+          const std::set<OfxTime> &nodeFrames = frames[*node];
+          for(std::set<OfxTime>::const_iterator t = nodeFrames.begin(); t != nodeFrames.end(); ++t) {
+            RangeMap &rangeMap = framesNeeded[*node][*t];
+            OfxStatus st = (*node)->getFrameNeededAction(*t, rangeMap);
+            if(!statusOK(st))
+              return st;
+
+            for(RangeMap::iterator it = rangeMap.begin(); it != rangeMap.end(); ++it) {
+              Instance *input = getInput(it->first);
+              if(input)
+                getFrames(it->second, frames[input]);
+            }
+          }
+        }
+
+        // regions of definition, upstream first
+        for(std::vector<Instance *>::iterator node = order.begin(); node != order.end(); ++node) {
+          const std::set<OfxTime> &nodeFrames = frames[*node];
+          for(std::set<OfxTime>::const_iterator t = nodeFrames.begin(); t != nodeFrames.end(); ++t) {
+            OfxRectD rod;
+            OfxStatus st = getRegionOfDefinition(*node, *t, rod);
+            if(!statusOK(st))
+              return st;
+          }
+        }
+
+        // regions of interest, downstream first
+        _needed[output][time] = Clamp(roi, _rods[output][time]);
+        for(std::vector<Instance *>::reverse_iterator node = order.rbegin(); node != order.rend(); ++node) {
+          RegionMap &needed = _needed[*node];
+          for(RegionMap::iterator it = needed.begin(); it != needed.end(); ++it) {
+            if(isEmpty(it->second))
+              continue;
+
+            std::map<ClipInstance *, OfxRectD> rois;
+            OfxStatus st = (*node)->getRegionOfInterestAction(it->first, _renderScale,
+#                                                             ifdef OFX_EXTENSIONS_NUKE
+                                                              _view,
+#                                                             endif
+                                                              it->second, rois);
+            if(!statusOK(st))
+              return st;
+
+            RangeMap &rangeMap = framesNeeded[*node][it->first];
+            for(std::map<ClipInstance *, OfxRectD>::iterator clipRoI = rois.begin(); clipRoI != rois.end(); ++clipRoI) {
+              Instance *input = getInput(clipRoI->first);
+              if(!input || isEmpty(clipRoI->second))
+                continue;
+
+              std::set<OfxTime> inputFrames;
+              getFrames(rangeMap[clipRoI->first], inputFrames);
+              RegionMap &inputNeeded = _needed[input];
+              for(std::set<OfxTime>::iterator t = inputFrames.begin(); t != inputFrames.end(); ++t) {
+                OfxRectD region = Clamp(clipRoI->second, _rods[input][*t]);
+                if(isEmpty(region))
+                  continue;
+                RegionMap::iterator existing = inputNeeded.find(*t);
+                if(existing == inputNeeded.end())
+                  inputNeeded[*t] = region;
+                else
+                  existing->second = Union(existing->second, region);
+              }
+            }
+          }
+        }
+
+        return kOfxStatOK;
+      }
+
+      const Graph::RegionMap *Graph::getRegionsNeeded(Instance *node) const
+      {
+        std::map<Instance *, RegionMap>::const_iterator found = _needed.find(node);
+        return found == _needed.end() ? 0 : &found->second;
+      }
+
+      OfxRectI Graph::toPixels(Instance &node, const OfxRectD &region, const OfxPointD &renderScale)
+      {
+        ClipInstance *output = node.getClip(kOfxImageEffectOutputClipName);
+        double par = output ? output->getAspectRatio() : 1.;
+        if(par <= 0.)
+          par = 1.;
+
+        OfxRectI window;
+        window.x1 = int(floor(region.x1 * renderScale.x / par));
+        window.x2 = int(ceil(region.x2 * renderScale.x / par));
+        window.y1 = int(floor(region.y1 * renderScale.y));
+        window.y2 = int(ceil(region.y2 * renderScale.y));
+        return window;
+      }
+
+      OfxStatus Graph::renderNode(Instance &node, OfxTime time, const OfxRectI &renderWindow, const RenderArgs &args)
+      {
+        RenderArgs frameArgs(args);
+        frameArgs.startFrame = frameArgs.endFrame = time;
+        frameArgs.step = 1;
+        frameArgs.renderWindow = renderWindow;
+
+        OfxStatus st = RenderScheduler::beginRenderAction(node, frameArgs, false);
+        if(!statusOK(st))
+          return st;
+        st = RenderScheduler::renderAction(node, time, renderWindow, frameArgs, false);
+        OfxStatus endSt = RenderScheduler::endRenderAction(node, frameArgs, false);
+        return statusOK(st) ? endSt : st;
+      }
+
+      OfxStatus Graph::render(Instance *output, OfxTime time, const OfxRectD &roi, const RenderArgs &args)
+      {
+        OfxStatus st = evaluate(output, time, roi, args);
+        if(!statusOK(st))
+          return st;
+
+        std::vector<Instance *> order;
+        sortNodes(output, order);
+        for(std::vector<Instance *>::iterator node = order.begin(); node != order.end(); ++node) {
+          const RegionMap &needed = _needed[*node];
+          for(RegionMap::const_iterator it = needed.begin(); it != needed.end(); ++it) {
+            if(isEmpty(it->second))
+              continue;
+            if(output->abort())
+              return kOfxStatFailed;
+
+            st = renderNode(**node, it->first, toPixels(**node, it->second, _renderScale), args);
+            if(!statusOK(st))
+              return st;
+          }
+        }
+
+        return kOfxStatOK;
+      }
+
+    } // namespace ImageEffect
+
+  } // namespace Host
+
+} // namespace OFX
@@ -35,6 +35,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 // ofx
 #include "ofxCore.h"
 #include "ofxProperty.h"
+#include "ofxPropertyBatch.h"
 #include "ofxMultiThread.h"
 #include "ofxMemory.h"
 #ifdef OFX_SUPPORTS_OPENGLRENDER
@@ -42,6 +43,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #endif
 
 #include "ofxhHost.h"
+#include "ofxhMemory.h"
 
 typedef OfxPlugin* (*OfxGetPluginType)(int);
 
@@ -50,11 +52,11 @@ namespace OFX {
   namespace Host {
 
     ////////////////////////////////////////////////////////////////////////////////
-    /// simple memory suite 
+    /// simple memory suite, on the pool so per frame buffers get reused
     namespace Memory {
       static OfxStatus memoryAlloc(void */*handle*/, size_t bytes, void **data)
       {
-        *data = malloc(bytes);
+        *data = Pool::getDefault().allocate(bytes);
         if (*data) {
           return kOfxStatOK;
         } else {
@@ -64,7 +66,7 @@ namespace OFX {
       
       static OfxStatus memoryFree(void *data)
       {
-        free(data);
+        Pool::getDefault().deallocate(data);
         return kOfxStatOK;
       }
       
@@ -109,6 +111,7 @@ namespace OFX {
     // Base Host
     Host::Host() : _properties(hostStuffs) 
     {
+      _properties.setKind("host");
       _host.host = _properties.getHandle();
       _host.fetchSuite = OFX::Host::fetchSuite;
 
@@ -141,6 +144,9 @@ namespace OFX {
       if (strcmp(suiteName, kOfxPropertySuite)==0  && suiteVersion == 1) {
         return Property::GetSuite(suiteVersion);
       }
+      else if (strcmp(suiteName, kOfxPropertyBatchSuite)==0 && suiteVersion == 1) {
+        return Property::GetBatchSuite(suiteVersion);
+      }
       else if (strcmp(suiteName, kOfxMemorySuite)==0 && suiteVersion == 1) {
         return (void*)&Memory::gMallocSuite;
       }  
@@ -0,0 +1,250 @@
+
+/*
+Software License :
+
+Copyright (c) 2007-2009, The Open Effects Association Ltd. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+* Neither the name The Open Effects Association Ltd, nor the names of its 
+contributors may be used to endorse or promote products derived from this
+software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <float.h>
+#include <limits.h>
+#include <stdlib.h>
+
+// ofx
+#include "ofxCore.h"
+#include "ofxImageEffect.h"
+
+// ofx host
+#include "ofxhBinary.h"
+#include "ofxhPropertySuite.h"
+#include "ofxhClip.h"
+#include "ofxhImageCache.h"
+
+namespace OFX {
+
+  namespace Host {
+
+    namespace ImageEffect {
+
+      ////////////////////////////////////////////////////////////////////////////////
+      // image cache keys
+
+      ImageCacheKey::ImageCacheKey()
+        : instance(0)
+        , renderHash(0)
+        , time(0)
+        , view(0)
+      {
+        renderScale.x = renderScale.y = 1.;
+        bounds.x1 = bounds.y1 = bounds.x2 = bounds.y2 = 0;
+      }
+
+      bool ImageCacheKey::sameImagePlane(const ImageCacheKey &other) const
+      {
+        return instance == other.instance &&
+          renderHash == other.renderHash &&
+          time == other.time &&
+          view == other.view &&
+          renderScale.x == other.renderScale.x &&
+          renderScale.y == other.renderScale.y &&
+          plane == other.plane;
+      }
+
+      bool ImageCacheKey::operator<(const ImageCacheKey &other) const
+      {
+        // bounds go last, so that all the images of a plane are next to each other
+        if(instance != other.instance) return instance < other.instance;
+        if(renderHash != other.renderHash) return renderHash < other.renderHash;
+        if(time != other.time) return time < other.time;
+        if(view != other.view) return view < other.view;
+        if(renderScale.x != other.renderScale.x) return renderScale.x < other.renderScale.x;
+        if(renderScale.y != other.renderScale.y) return renderScale.y < other.renderScale.y;
+        if(plane != other.plane) return plane < other.plane;
+        if(bounds.x1 != other.bounds.x1) return bounds.x1 < other.bounds.x1;
+        if(bounds.y1 != other.bounds.y1) return bounds.y1 < other.bounds.y1;
+        if(bounds.x2 != other.bounds.x2) return bounds.x2 < other.bounds.x2;
+        return bounds.y2 < other.bounds.y2;
+      }
+
+      /// does a contain b
+      static bool contains(const OfxRectI &a, const OfxRectI &b)
+      {
+        return a.x1 <= b.x1 && a.y1 <= b.y1 && a.x2 >= b.x2 && a.y2 >= b.y2;
+      }
+
+      ////////////////////////////////////////////////////////////////////////////////
+      // image cache
+
+      ImageCache::ImageCache(size_t maxBytes)
+        : _maxBytes(maxBytes)
+        , _bytes(0)
+        , _floor(0.)
+        , _nHits(0)
+        , _nMisses(0)
+      {
+      }
+
+      ImageCache::~ImageCache()
+      {
+        for(EntryMap::iterator it = _entries.begin(); it != _entries.end(); ++it)
+          it->second.image->releaseReference();
+      }
+
+      size_t ImageCache::getImageBytes(const ImageBase &image)
+      {
+        OfxRectI bounds = image.getBounds();
+        if(bounds.y2 <= bounds.y1)
+          return 0;
+        return size_t(abs(image.getIntProperty(kOfxImagePropRowBytes))) * size_t(bounds.y2 - bounds.y1);
+      }
+
+      void ImageCache::setMaxBytes(size_t maxBytes)
+      {
+        MultiThread::ScopedLock lock(_lock);
+        _maxBytes = maxBytes;
+        if(_maxBytes > 0)
+          evict(_maxBytes);
+      }
+
+      void ImageCache::touch(EntryMap::iterator entry)
+      {
+        Entry &e = entry->second;
+        if(e.priority != _priorities.end())
+          _priorities.erase(e.priority);
+        // equal priorities keep insertion order, so this also makes it the most recently used
+        double cost = e.cost > 0. ? e.cost : double(e.nBytes);
+        e.priority = _priorities.insert(std::make_pair(_floor + cost / double(e.nBytes > 0 ? e.nBytes : 1), entry->first));
+      }
+
+      void ImageCache::remove(EntryMap::iterator entry)
+      {
+        _priorities.erase(entry->second.priority);
+        _bytes -= entry->second.nBytes;
+        entry->second.image->releaseReference();
+        _entries.erase(entry);
+      }
+
+      size_t ImageCache::evict(size_t nBytes)
+      {
+        size_t freed = 0;
+        PriorityMap::iterator it = _priorities.begin();
+        while(_bytes > nBytes && it != _priorities.end()) {
+          EntryMap::iterator entry = _entries.find(it->second);
+          ++it;
+
+          // something other than us holds the image
+          if(entry->second.image->getReferenceCount() > 1)
+            continue;
+
+          _floor = entry->second.priority->first;
+          freed += entry->second.nBytes;
+          remove(entry);
+        }
+        return freed;
+      }
+
+      ImageBase *ImageCache::get(const ImageCacheKey &key)
+      {
+        MultiThread::ScopedLock lock(_lock);
+
+        // first image of the plane
+        ImageCacheKey first(key);
+        first.bounds.x1 = first.bounds.y1 = first.bounds.x2 = first.bounds.y2 = INT_MIN;
+
+        for(EntryMap::iterator it = _entries.lower_bound(first); it != _entries.end() && it->first.sameImagePlane(key); ++it) {
+          if(contains(it->first.bounds, key.bounds)) {
+            ++_nHits;
+            touch(it);
+            it->second.image->addReference();
+            return it->second.image;
+          }
+        }
+
+        ++_nMisses;
+        return 0;
+      }
+
+      void ImageCache::insert(const ImageCacheKey &key, ImageBase *image, size_t nBytes, double cost)
+      {
+        if(!image)
+          return;
+        if(nBytes == 0)
+          nBytes = getImageBytes(*image);
+
+        MultiThread::ScopedLock lock(_lock);
+        if(_maxBytes > 0 && nBytes > _maxBytes)
+          return;
+
+        EntryMap::iterator existing = _entries.find(key);
+        if(existing != _entries.end())
+          remove(existing);
+
+        image->addReference();
+        Entry entry;
+        entry.image = image;
+        entry.nBytes = nBytes;
+        entry.cost = cost;
+        entry.priority = _priorities.end();
+        EntryMap::iterator it = _entries.insert(std::make_pair(key, entry)).first;
+        _bytes += nBytes;
+        touch(it);
+
+        if(_maxBytes > 0)
+          evict(_maxBytes);
+      }
+
+      void ImageCache::erase(Instance *instance)
+      {
+        MultiThread::ScopedLock lock(_lock);
+
+        // the lowest possible key for the instance
+        ImageCacheKey first;
+        first.instance = instance;
+        first.time = -DBL_MAX;
+        first.view = INT_MIN;
+        first.renderScale.x = first.renderScale.y = -DBL_MAX;
+        first.bounds.x1 = first.bounds.y1 = first.bounds.x2 = first.bounds.y2 = INT_MIN;
+        EntryMap::iterator it = _entries.lower_bound(first);
+        while(it != _entries.end() && it->first.instance == instance)
+          remove(it++);
+      }
+
+      void ImageCache::clear()
+      {
+        MultiThread::ScopedLock lock(_lock);
+        evict(0);
+      }
+
+      size_t ImageCache::purge(size_t nBytes)
+      {
+        MultiThread::ScopedLock lock(_lock);
+        return evict(nBytes);
+      }
+
+    } // namespace ImageEffect
+
+  } // namespace Host
+
+} // namespace OFX
@@ -32,6 +32,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 // ofx
 #include "ofxCore.h"
 #include "ofxImageEffect.h"
+#include "ofxParameterBatch.h"
 #ifdef OFX_SUPPORTS_DIALOG
 #include "ofxDialog.h"
 #endif
@@ -51,6 +52,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 // ofx host
 #include "ofxhBinary.h"
 #include "ofxhPropertySuite.h"
+#include "ofxhPropertyProfiler.h"
 #include "ofxhClip.h"
 #include "ofxhParam.h"
 #include "ofxhMemory.h"
@@ -60,6 +62,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "ofxhHost.h"
 #include "ofxhImageEffectAPI.h"
 #include "ofxhUtilities.h"
+#include "ofxhTileRenderer.h"
 #ifdef OFX_SUPPORTS_PARAMETRIC
 #include "ofxhParametricParam.h"
 #endif
@@ -163,11 +166,15 @@ namespace OFX {
 
       Base::Base(const Property::Set &set) 
         : _properties(set) 
-      {}
+      {
+        _properties.setKind("effect");
+      }
 
       Base::Base(const Property::PropSpec * propSpec)
         : _properties(propSpec) 
-      {}
+      {
+        _properties.setKind("effect");
+      }
 
       Base::~Base() {}
 
@@ -582,6 +589,235 @@ namespace OFX {
         Property::propSpecEnd
       };
 
+      ////////////////////////////////////////////////////////////////////////////////
+      // argument sets of the actions called while rendering
+
+      /// in args of the begin sequence render action
+      static const Property::PropSpec beginRenderInStuff[] = {
+        { kOfxImageEffectPropFrameRange, Property::eDouble, 2, true, "0" },
+        { kOfxImageEffectPropFrameStep, Property::eDouble, 1, true, "0" }, 
+        { kOfxPropIsInteractive, Property::eInt, 1, true, "0" },
+        { kOfxImageEffectPropRenderScale, Property::eDouble, 2, true, "0" },
+        { kOfxImageEffectPropSequentialRenderStatus, Property::eInt, 1, true, "0" },
+        { kOfxImageEffectPropInteractiveRenderStatus, Property::eInt, 1, true, "0" },
+#     ifdef OFX_SUPPORTS_OPENGLRENDER
+        { kOfxImageEffectPropOpenGLEnabled, Property::eInt, 1, true, "0" }, // OFX 1.3
+#      ifdef OFX_EXTENSIONS_NATRON
+        { kNatronOfxImageEffectPropOpenGLContextData , Property::ePointer, 1, false, NULL },
+#      endif
+#     endif
+        { kOfxImageEffectPropRenderQualityDraft, Property::eInt, 1, true, "0" }, // OFX 1.4
+#     ifdef OFX_EXTENSIONS_RESOLVE
+        { kOfxImageEffectPropOpenCLEnabled, Property::eInt, 1, true, "0" },
+        { kOfxImageEffectPropCudaEnabled, Property::eInt, 1, true, "0" },
+        { kOfxImageEffectPropOpenCLCommandQueue, Property::ePointer, 1, false, "0" },
+#     endif
+#     ifdef OFX_EXTENSIONS_NUKE
+        { kFnOfxImageEffectPropView, Property::eInt, 1, true, "0" },
+#     endif
+        Property::propSpecEnd
+      };
+
+      /// in args of the render action
+      static const Property::PropSpec renderInStuff[] = {
+        { kOfxPropTime, Property::eDouble, 1, true, "0" },
+        { kOfxImageEffectPropFieldToRender, Property::eString, 1, true, "" }, 
+        { kOfxImageEffectPropRenderWindow, Property::eInt, 4, true, "0" },
+        { kOfxImageEffectPropRenderScale, Property::eDouble, 2, true, "0" },
+        { kOfxImageEffectPropSequentialRenderStatus, Property::eInt, 1, true, "0" },
+        { kOfxImageEffectPropInteractiveRenderStatus, Property::eInt, 1, true, "0" },
+#     ifdef OFX_SUPPORTS_OPENGLRENDER
+        { kOfxImageEffectPropOpenGLEnabled, Property::eInt, 1, true, "0" }, // OFX 1.3
+#      ifdef OFX_EXTENSIONS_NATRON
+        { kNatronOfxImageEffectPropOpenGLContextData , Property::ePointer, 1, false, "0" },
+#      endif
+#     endif
+        { kOfxImageEffectPropRenderQualityDraft, Property::eInt, 1, true, "0" }, // OFX 1.4
+#     ifdef OFX_EXTENSIONS_RESOLVE
+        { kOfxImageEffectPropOpenCLEnabled, Property::eInt, 1, true, "0" },
+        { kOfxImageEffectPropCudaEnabled, Property::eInt, 1, true, "0" },
+        { kOfxImageEffectPropOpenCLCommandQueue, Property::ePointer, 1, false, "0" },
+#     endif
+#     ifdef OFX_EXTENSIONS_VEGAS
+        { kOfxImageEffectPropRenderView, Property::eInt, 1, true, "0" },
+        { kOfxImageEffectPropViewsToRender, Property::eInt, 1, true, "1" },
+        { kOfxImageEffectPropRenderQuality, Property::eString, 1, true, "" },
+#     endif
+#     ifdef OFX_EXTENSIONS_NUKE
+        { kFnOfxImageEffectPropView, Property::eInt, 1, true, "0" },
+        { kOfxImageEffectPropRenderPlanes, Property::eString, 0, true, "" },
+#     endif
+        Property::propSpecEnd
+      };
+
+      /// in args of the end sequence render action
+      static const Property::PropSpec endRenderInStuff[] = {
+        { kOfxImageEffectPropFrameRange, Property::eDouble, 2, true, "0" },
+        { kOfxImageEffectPropFrameStep, Property::eDouble, 1, true, "0" }, 
+        { kOfxPropIsInteractive, Property::eInt, 1, true, "0" },
+        { kOfxImageEffectPropRenderScale, Property::eDouble, 2, true, "0" },
+        { kOfxImageEffectPropSequentialRenderStatus, Property::eInt, 1, true, "0" },
+        { kOfxImageEffectPropInteractiveRenderStatus, Property::eInt, 1, true, "0" },
+#     ifdef OFX_SUPPORTS_OPENGLRENDER
+        { kOfxImageEffectPropOpenGLEnabled, Property::eInt, 1, true, "0" }, // OFX 1.3
+#      ifdef OFX_EXTENSIONS_NATRON
+        { kNatronOfxImageEffectPropOpenGLContextData , Property::ePointer, 1, false, "0" },
+#      endif
+#     endif
+        { kOfxImageEffectPropRenderQualityDraft, Property::eInt, 1, true, "0" }, // OFX 1.4
+#     ifdef OFX_EXTENSIONS_RESOLVE
+        { kOfxImageEffectPropOpenCLEnabled, Property::eInt, 1, true, "0" },
+        { kOfxImageEffectPropCudaEnabled, Property::eInt, 1, true, "0" },
+        { kOfxImageEffectPropOpenCLCommandQueue, Property::ePointer, 1, false, "0" },
+#     endif
+#     ifdef OFX_EXTENSIONS_NUKE
+        { kFnOfxImageEffectPropView, Property::eInt, 1, true, "0" },
+#     endif
+        Property::propSpecEnd
+      };
+
+      /// in args of the region of definition action
+      static const Property::PropSpec rodInStuff[] = {
+        { kOfxPropTime, Property::eDouble, 1, true, "0" },
+        { kOfxImageEffectPropRenderScale, Property::eDouble, 2, true, "0" },
+#ifdef OFX_EXTENSIONS_NUKE
+        { kFnOfxImageEffectPropView, Property::eInt, 1, true, "0" },
+#endif
+        Property::propSpecEnd
+      };
+
+      /// out args of the region of definition action
+      static const Property::PropSpec rodOutStuff[] = {
+        { kOfxImageEffectPropRegionOfDefinition , Property::eDouble, 4, false, "0" },
+        Property::propSpecEnd
+      };
+
+      /// in args of the regions of interest action
+      static const Property::PropSpec roiInStuff[] = {
+        { kOfxPropTime, Property::eDouble, 1, true, "0" },
+        { kOfxImageEffectPropRenderScale, Property::eDouble, 2, true, "0" },
+        { kOfxImageEffectPropRegionOfInterest , Property::eDouble, 4, true, 0 },
+#     ifdef OFX_EXTENSIONS_NUKE
+        { kFnOfxImageEffectPropView, Property::eInt, 1, true, "0" },
+#     endif
+        Property::propSpecEnd
+      };
+
+      /// in args of the frames needed action
+      static const Property::PropSpec framesNeededInStuff[] = {
+        { kOfxPropTime, Property::eDouble, 1, true, "0" },
+#ifdef OFX_EXTENSIONS_NUKE
+        { kFnOfxImageEffectPropView, Property::eInt, 1, true, "0" },
+#endif
+        Property::propSpecEnd
+      };
+
+      /// in args of the is identity action
+      static const Property::PropSpec isIdentityInStuff[] = {
+        { kOfxPropTime, Property::eDouble, 1, true, "0" },
+        { kOfxImageEffectPropFieldToRender, Property::eString, 1, true, "" }, 
+        { kOfxImageEffectPropRenderWindow, Property::eInt, 4, true, "0" },
+        { kOfxImageEffectPropRenderScale, Property::eDouble, 2, true, "0" },
+#ifdef OFX_EXTENSIONS_NUKE
+        { kFnOfxImageEffectPropView, Property::eInt, 1, true, "0" },
+        { kOfxImageEffectPropIdentityPlane, Property::eString, 1, true, ""},
+#endif
+        Property::propSpecEnd
+      };
+
+      /// out args of the is identity action
+      static const Property::PropSpec isIdentityOutStuff[] = {
+        { kOfxPropTime, Property::eDouble, 1, false, "0.0" },
+        { kOfxPropName, Property::eString, 1, false, "" },
+#ifdef OFX_EXTENSIONS_NUKE
+        { kFnOfxImageEffectPropView, Property::eInt, 1, true, "0" },
+        { kOfxImageEffectPropIdentityPlane, Property::eString, 1, true, ""},
+#endif
+        Property::propSpecEnd
+      };
+
+      /// The argument sets of the actions called while rendering. These are pooled per
+      /// instance, rather than being built from their PropSpecs on every call. The out args of
+      /// the regions of interest and frames needed actions have a property per clip, so
+      /// their prototypes, and the names of those properties, are made here once.
+      struct Instance::ActionArgs {
+        /// a clip and the name of its property in a set of action args
+        struct ClipArg {
+          ClipInstance *clip;
+          std::string   name;
+        };
+
+        Property::SetPool beginRenderIn;
+        Property::SetPool renderIn;
+        Property::SetPool endRenderIn;
+        Property::SetPool rodIn;
+        Property::SetPool rodOut;
+        Property::SetPool roiIn;
+        Property::SetPool framesNeededIn;
+        Property::SetPool isIdentityIn;
+        Property::SetPool isIdentityOut;
+
+        std::vector<ClipArg> roiClips;          ///< clips with an RoI in the regions of interest out args
+        Property::SetPool   *roiOut;
+
+        std::vector<ClipArg> framesNeededClips; ///< clips with a range in the frames needed out args
+        Property::SetPool   *framesNeededOut;
+
+        explicit ActionArgs(Instance &instance)
+          : beginRenderIn(beginRenderInStuff)
+          , renderIn(renderInStuff)
+          , endRenderIn(endRenderInStuff)
+          , rodIn(rodInStuff)
+          , rodOut(rodOutStuff)
+          , roiIn(roiInStuff)
+          , framesNeededIn(framesNeededInStuff)
+          , isIdentityIn(isIdentityInStuff)
+          , isIdentityOut(isIdentityOutStuff)
+          , roiOut(0)
+          , framesNeededOut(0)
+        {
+          Property::Set roiOutArgs;
+          Property::Set framesNeededOutArgs;
+
+          for(std::map<std::string, ClipInstance*>::iterator it = instance._clips.begin();
+              it != instance._clips.end();
+              ++it) {
+            ClipArg arg;
+            arg.clip = it->second;
+            if (!it->second->isOutput() ||
+#               ifdef OFX_EXTENSIONS_TUTTLE
+                instance.getContext() == kOfxImageEffectContextReader ||
+#               endif
+                instance.getContext() == kOfxImageEffectContextGenerator) {
+              arg.name = "OfxImageClipPropRoI_" + it->first;
+              Property::PropSpec s = { arg.name.c_str(), Property::eDouble, 4, false, "" };
+              roiOutArgs.createProperty(s);
+              roiClips.push_back(arg);
+            }
+            if (!it->second->isOutput()) {
+              arg.name = "OfxImageClipPropFrameRange_" + it->first;
+              Property::PropSpec s = { arg.name.c_str(), Property::eDouble, 0, false, "" };
+              framesNeededOutArgs.createProperty(s);
+              framesNeededClips.push_back(arg);
+            }
+          }
+
+          roiOut = new Property::SetPool(roiOutArgs);
+          framesNeededOut = new Property::SetPool(framesNeededOutArgs);
+        }
+
+        ~ActionArgs()
+        {
+          delete roiOut;
+          delete framesNeededOut;
+        }
+      };
+
+      Instance::ActionArgs &Instance::getActionArgs()
+      {
+        return *_actionArgs;
+      }
+
       Instance::Instance(ImageEffectPlugin* plugin,
                          Descriptor         &other, 
                          const std::string  &context,
@@ -597,6 +833,7 @@ namespace OFX {
         , _continuousSamples(false)
         , _frameVarying(false)
         , _outputFrameRate(24)
+        , _actionArgs(0)
       {
         int i = 0;
         
@@ -630,6 +867,10 @@ namespace OFX {
             }
           i++;
         }
+
+        // made up front, as actions may be called on several threads at once, and again
+        // by populate() once there are clips
+        _actionArgs = new ActionArgs(*this);
       }
 
       Instance::Instance(const Instance& other)
@@ -648,8 +889,10 @@ namespace OFX {
       , _outputPreMultiplication(other._outputPreMultiplication)
       , _outputFielding(other._outputFielding)
       , _outputFrameRate(other._outputFrameRate)
+      , _actionArgs(0)
       {
-
+        // we share the other's clips, so our argument sets can be made straight away
+        _actionArgs = new ActionArgs(*this);
       }
 
       /// implemented for Param::SetDescriptor
@@ -726,6 +969,10 @@ namespace OFX {
             }
           }
 
+        // now the clips exist, make the argument sets of the render actions
+        delete _actionArgs;
+        _actionArgs = new ActionArgs(*this);
+
         return kOfxStatOK;
       }
 
@@ -865,6 +1112,10 @@ namespace OFX {
 #         endif
           destroyInstanceAction();
         }
+        if (gImageEffectHost) {
+          gImageEffectHost->getMemoryBudget().removeInstance(this);
+        }
+        delete _actionArgs;
         /// clobber my clips
         if (_ownsData) {
           std::map<std::string, ClipInstance*>::iterator i;
@@ -915,14 +1166,35 @@ namespace OFX {
 
       // return an memory::instance calls makeMemoryInstance that can be overriden
       Memory::Instance* Instance::imageMemoryAlloc(size_t nBytes){
-        Memory::Instance* instance = newMemoryInstance(nBytes);
-        if(instance)
-          return instance;
-        else{
-          Memory::Instance* instance = new Memory::Instance;
-          instance->alloc(nBytes);
-          return instance;
+        MemoryBudget* budget = gImageEffectHost ? &gImageEffectHost->getMemoryBudget() : 0;
+        if(budget && !budget->reserve(this, nBytes))
+          return 0;
+
+        Memory::Instance* instance = 0;
+        try {
+          instance = newMemoryInstance(nBytes);
+          if(!instance){
+            instance = new Memory::Instance;
+            if(!instance->alloc(nBytes)) {
+              delete instance;
+              instance = 0;
+            }
+          }
+        }
+        catch(...) {
+          if(budget)
+            budget->release(this, nBytes);
+          throw;
         }
+        if(!instance) {
+          // the suite reports kOfxStatErrMemory, the reservation must not outlive the failure
+          if(budget)
+            budget->release(this, nBytes);
+          return 0;
+        }
+        if(budget)
+          budget->trackMemory(instance, this, nBytes);
+        return instance;
       }
 
       // call the effect entry point
@@ -937,14 +1209,18 @@ namespace OFX {
             OfxPlugin* ofxPlugin = pHandle->getOfxPlugin();
             if(ofxPlugin){
               
+              Property::Profiler::ActionScope profile(action);
+
               OfxPropertySetHandle inHandle = 0;
               if(inArgs) {
+                inArgs->setKind("inArgs");
                 setCustomInArgs(action, *inArgs);
                 inHandle = inArgs->getHandle();
               }
               
               OfxPropertySetHandle outHandle = 0;
               if(outArgs) {
+                outArgs->setKind("outArgs");
                 setCustomOutArgs(action, *outArgs);
                 outHandle = outArgs->getHandle();
               }
@@ -1011,6 +1287,10 @@ namespace OFX {
       {
         OfxStatus st = kOfxStatFailed;
         if (_created) {
+          // stop the memory budget purging it, and wait for a purge already under way
+          if (gImageEffectHost) {
+            gImageEffectHost->getMemoryBudget().removeInstance(this);
+          }
 #         ifdef OFX_DEBUG_ACTIONS
             OfxPlugin *ofxp = _plugin->getPluginHandle()->getOfxPlugin();
             const char* id = ofxp->pluginIdentifier;
@@ -1065,6 +1345,8 @@ namespace OFX {
           return kOfxStatFailed;
         }
 
+        paramValueChanged(param);
+
         Property::PropSpec stuff[] = {
           { kOfxPropType, Property::eString, 1, true, kOfxTypeParameter },
           { kOfxPropName, Property::eString, 1, true, paramName.c_str() },
@@ -1284,32 +1566,8 @@ namespace OFX {
              OFX::IsNaN(step) ) {
           return kOfxStatFailed;
         }
-        Property::PropSpec stuff[] = {
-          { kOfxImageEffectPropFrameRange, Property::eDouble, 2, true, "0" },
-          { kOfxImageEffectPropFrameStep, Property::eDouble, 1, true, "0" }, 
-          { kOfxPropIsInteractive, Property::eInt, 1, true, "0" },
-          { kOfxImageEffectPropRenderScale, Property::eDouble, 2, true, "0" },
-          { kOfxImageEffectPropSequentialRenderStatus, Property::eInt, 1, true, "0" },
-          { kOfxImageEffectPropInteractiveRenderStatus, Property::eInt, 1, true, "0" },
-#       ifdef OFX_SUPPORTS_OPENGLRENDER
-          { kOfxImageEffectPropOpenGLEnabled, Property::eInt, 1, true, "0" }, // OFX 1.3
-#        ifdef OFX_EXTENSIONS_NATRON
-          { kNatronOfxImageEffectPropOpenGLContextData , Property::ePointer, 1, false, NULL },
-#        endif
-#       endif
-          { kOfxImageEffectPropRenderQualityDraft, Property::eInt, 1, true, "0" }, // OFX 1.4
-#       ifdef OFX_EXTENSIONS_RESOLVE
-          { kOfxImageEffectPropOpenCLEnabled, Property::eInt, 1, true, "0" },
-          { kOfxImageEffectPropCudaEnabled, Property::eInt, 1, true, "0" },
-          { kOfxImageEffectPropOpenCLCommandQueue, Property::ePointer, 1, false, "0" },
-#       endif
-#       ifdef OFX_EXTENSIONS_NUKE
-          { kFnOfxImageEffectPropView, Property::eInt, 1, true, "0" },
-#       endif
-          Property::propSpecEnd
-        };
-
-        Property::Set inArgs(stuff);
+        Property::PooledSet pooledInArgs(getActionArgs().beginRenderIn);
+        Property::Set &inArgs = *pooledInArgs;
 
         // set up second dimension for frame range and render scale
         inArgs.setDoubleProperty(kOfxImageEffectPropFrameRange,startFrame, 0);
@@ -1384,38 +1642,8 @@ namespace OFX {
         if ( OFX::IsNaN(time) ) {
           return kOfxStatFailed;
         }
-        static const Property::PropSpec inStuff[] = {
-          { kOfxPropTime, Property::eDouble, 1, true, "0" },
-          { kOfxImageEffectPropFieldToRender, Property::eString, 1, true, "" }, 
-          { kOfxImageEffectPropRenderWindow, Property::eInt, 4, true, "0" },
-          { kOfxImageEffectPropRenderScale, Property::eDouble, 2, true, "0" },
-          { kOfxImageEffectPropSequentialRenderStatus, Property::eInt, 1, true, "0" },
-          { kOfxImageEffectPropInteractiveRenderStatus, Property::eInt, 1, true, "0" },
-#       ifdef OFX_SUPPORTS_OPENGLRENDER
-          { kOfxImageEffectPropOpenGLEnabled, Property::eInt, 1, true, "0" }, // OFX 1.3
-#        ifdef OFX_EXTENSIONS_NATRON
-          { kNatronOfxImageEffectPropOpenGLContextData , Property::ePointer, 1, false, "0" },
-#        endif
-#       endif
-          { kOfxImageEffectPropRenderQualityDraft, Property::eInt, 1, true, "0" }, // OFX 1.4
-#       ifdef OFX_EXTENSIONS_RESOLVE
-          { kOfxImageEffectPropOpenCLEnabled, Property::eInt, 1, true, "0" },
-          { kOfxImageEffectPropCudaEnabled, Property::eInt, 1, true, "0" },
-          { kOfxImageEffectPropOpenCLCommandQueue, Property::ePointer, 1, false, "0" },
-#       endif
-#       ifdef OFX_EXTENSIONS_VEGAS
-          { kOfxImageEffectPropRenderView, Property::eInt, 1, true, "0" },
-          { kOfxImageEffectPropViewsToRender, Property::eInt, 1, true, "1" },
-          { kOfxImageEffectPropRenderQuality, Property::eString, 1, true, "" },
-#       endif
-#       ifdef OFX_EXTENSIONS_NUKE
-          { kFnOfxImageEffectPropView, Property::eInt, 1, true, "0" },
-          { kOfxImageEffectPropRenderPlanes, Property::eString, 0, true, "" },
-#       endif
-          Property::propSpecEnd
-        };
-
-        Property::Set inArgs(inStuff);
+        Property::PooledSet pooledInArgs(getActionArgs().renderIn);
+        Property::Set &inArgs = *pooledInArgs;
         
         inArgs.setStringProperty(kOfxImageEffectPropFieldToRender,field);
         inArgs.setDoubleProperty(kOfxPropTime,time);
@@ -1462,7 +1690,21 @@ namespace OFX {
           <<")"<<std::endl;
 #       endif
 
-        OfxStatus st = mainEntry(kOfxImageEffectActionRender,this->getHandle(), &inArgs, 0);
+        // plugins aren't asked to purge their caches while rendering
+        MemoryBudget* budget = gImageEffectHost ? &gImageEffectHost->getMemoryBudget() : 0;
+        if(budget)
+          budget->renderStarted(this);
+        OfxStatus st = kOfxStatFailed;
+        try {
+          st = mainEntry(kOfxImageEffectActionRender,this->getHandle(), &inArgs, 0);
+        }
+        catch(...) {
+          if(budget)
+            budget->renderFinished(this);
+          throw;
+        }
+        if(budget)
+          budget->renderFinished(this);
 #       ifdef OFX_DEBUG_ACTIONS
           std::cout << "OFX: "<<id<<"("<<(void*)ofxp<<")->"<<kOfxImageEffectActionRender<<"("<<time<<","<<field<<",("<<renderRoI.x1<<","<<renderRoI.y1<<","<<renderRoI.x2<<","<<renderRoI.y2<<"),("<<renderScale.x<<","<<renderScale.y<<"),"<<sequentialRender<<","<<interactiveRender<<","<<draftRender
 #         if defined(OFX_EXTENSIONS_VEGAS) || defined(OFX_EXTENSIONS_NUKE)
@@ -1501,32 +1743,8 @@ namespace OFX {
              OFX::IsNaN(step) ) {
           return kOfxStatFailed;
         }
-        static const Property::PropSpec inStuff[] = {
-          { kOfxImageEffectPropFrameRange, Property::eDouble, 2, true, "0" },
-          { kOfxImageEffectPropFrameStep, Property::eDouble, 1, true, "0" }, 
-          { kOfxPropIsInteractive, Property::eInt, 1, true, "0" },
-          { kOfxImageEffectPropRenderScale, Property::eDouble, 2, true, "0" },
-          { kOfxImageEffectPropSequentialRenderStatus, Property::eInt, 1, true, "0" },
-          { kOfxImageEffectPropInteractiveRenderStatus, Property::eInt, 1, true, "0" },
-#       ifdef OFX_SUPPORTS_OPENGLRENDER
-          { kOfxImageEffectPropOpenGLEnabled, Property::eInt, 1, true, "0" }, // OFX 1.3
-#        ifdef OFX_EXTENSIONS_NATRON
-          { kNatronOfxImageEffectPropOpenGLContextData , Property::ePointer, 1, false, "0" },
-#        endif
-#       endif
-          { kOfxImageEffectPropRenderQualityDraft, Property::eInt, 1, true, "0" }, // OFX 1.4
-#       ifdef OFX_EXTENSIONS_RESOLVE
-          { kOfxImageEffectPropOpenCLEnabled, Property::eInt, 1, true, "0" },
-          { kOfxImageEffectPropCudaEnabled, Property::eInt, 1, true, "0" },
-          { kOfxImageEffectPropOpenCLCommandQueue, Property::ePointer, 1, false, "0" },
-#       endif
-#       ifdef OFX_EXTENSIONS_NUKE
-          { kFnOfxImageEffectPropView, Property::eInt, 1, true, "0" },
-#       endif
-          Property::propSpecEnd
-        };
-
-        Property::Set inArgs(inStuff);
+        Property::PooledSet pooledInArgs(getActionArgs().endRenderIn);
+        Property::Set &inArgs = *pooledInArgs;
 
         inArgs.setDoubleProperty(kOfxImageEffectPropFrameStep,step);
 
@@ -1838,22 +2056,11 @@ namespace OFX {
         if ( OFX::IsNaN(time) ) {
           return kOfxStatFailed;
         }
-        static const Property::PropSpec inStuff[] = {
-          { kOfxPropTime, Property::eDouble, 1, true, "0" },
-          { kOfxImageEffectPropRenderScale, Property::eDouble, 2, true, "0" },
-#ifdef OFX_EXTENSIONS_NUKE
-          { kFnOfxImageEffectPropView, Property::eInt, 1, true, "0" },
-#endif
-          Property::propSpecEnd
-        };
-
-        static const Property::PropSpec outStuff[] = {
-          { kOfxImageEffectPropRegionOfDefinition , Property::eDouble, 4, false, "0" },
-          Property::propSpecEnd
-        };
-
-        Property::Set inArgs(inStuff);
-        Property::Set outArgs(outStuff);
+        ActionArgs &args = getActionArgs();
+        Property::PooledSet pooledInArgs(args.rodIn);
+        Property::PooledSet pooledOutArgs(args.rodOut);
+        Property::Set &inArgs = *pooledInArgs;
+        Property::Set &outArgs = *pooledOutArgs;
         
         inArgs.setDoubleProperty(kOfxPropTime,time);
 #ifdef OFX_EXTENSIONS_NUKE
@@ -1924,17 +2131,11 @@ namespace OFX {
         // RoI for this clip to its RoD, but still call action and let the effect have the final decision.
         bool supportstiles = supportsTiles();
 
+        ActionArgs &args = getActionArgs();
+
         /// set up the in args 
-        static const Property::PropSpec inStuff[] = {
-          { kOfxPropTime, Property::eDouble, 1, true, "0" },
-          { kOfxImageEffectPropRenderScale, Property::eDouble, 2, true, "0" },
-          { kOfxImageEffectPropRegionOfInterest , Property::eDouble, 4, true, 0 },
-#         ifdef OFX_EXTENSIONS_NUKE
-          { kFnOfxImageEffectPropView, Property::eInt, 1, true, "0" },
-#         endif
-          Property::propSpecEnd
-        };
-        Property::Set inArgs(inStuff);
+        Property::PooledSet pooledInArgs(args.roiIn);
+        Property::Set &inArgs = *pooledInArgs;
 
         inArgs.setDoublePropertyN(kOfxImageEffectPropRenderScale, &renderScale.x, 2);
         inArgs.setDoubleProperty(kOfxPropTime,time);
@@ -1943,40 +2144,27 @@ namespace OFX {
         inArgs.setIntProperty(kFnOfxImageEffectPropView, view);
 #       endif
 
-        Property::Set outArgs;
-        for (std::map<std::string, ClipInstance*>::iterator it=_clips.begin();
-            it!=_clips.end();
-            ++it) {
-          if (!it->second->isOutput() ||
-#             ifdef OFX_EXTENSIONS_TUTTLE
-              getContext() == kOfxImageEffectContextReader ||
-#             endif
-              getContext() == kOfxImageEffectContextGenerator) {
-            Property::PropSpec s;
-            std::string name = "OfxImageClipPropRoI_"+it->first;
+        Property::PooledSet pooledOutArgs(*args.roiOut);
+        Property::Set &outArgs = *pooledOutArgs;
+        for (std::vector<ActionArgs::ClipArg>::const_iterator it = args.roiClips.begin();
+             it != args.roiClips.end();
+             ++it) {
+          ClipInstance *clip = it->clip;
 
-            s.name = name.c_str();
-            s.type = Property::eDouble;
-            s.dimension = 4;
-            s.readonly = false;
-            s.defaultValue = "";
-            outArgs.createProperty(s);
-            
-            /// initialise to the default
-            if (supportstiles && it->second->supportsTiles()) {
-              outArgs.setDoublePropertyN(s.name, &roi.x1, 4);
-            } else {
-              OfxRectD rod = roi;
-              // needed to be able to fetch the RoD
-              if (it->second->isOutput() || it->second->getConnected()) {
-#               ifdef OFX_EXTENSIONS_NUKE
-                rod = it->second->getRegionOfDefinition(time, view);
-#               else
-                rod = it->second->getRegionOfDefinition(time);
-#               endif
-              }
-              outArgs.setDoublePropertyN(s.name, &rod.x1, 4);
+          /// initialise to the default
+          if (supportstiles && clip->supportsTiles()) {
+            outArgs.setDoublePropertyN(it->name, &roi.x1, 4);
+          } else {
+            OfxRectD rod = roi;
+            // needed to be able to fetch the RoD
+            if (clip->isOutput() || clip->getConnected()) {
+#             ifdef OFX_EXTENSIONS_NUKE
+              rod = clip->getRegionOfDefinition(time, view);
+#             else
+              rod = clip->getRegionOfDefinition(time);
+#             endif
             }
+            outArgs.setDoublePropertyN(it->name, &rod.x1, 4);
           }
         }
 
@@ -2010,31 +2198,21 @@ namespace OFX {
         std::cout << std::endl;
 #       endif
         // get the results
-        for (std::map<std::string, ClipInstance*>::iterator it=_clips.begin();
-             it!=_clips.end();
+        for (std::vector<ActionArgs::ClipArg>::const_iterator it = args.roiClips.begin();
+             it != args.roiClips.end();
              ++it) {
-          if (!it->second->isOutput() ||
-#ifdef OFX_EXTENSIONS_TUTTLE
-              getContext() == kOfxImageEffectContextReader ||
-#endif
-              getContext() == kOfxImageEffectContextGenerator) {
-            if (it->second->isOutput() || it->second->getConnected()) { // needed to be able to fetch the RoD
-                  
-              std::string name = "OfxImageClipPropRoI_"+it->first;
-              OfxRectD thisRoi;
-              thisRoi.x1 = outArgs.getDoubleProperty(name,0);
-              thisRoi.y1 = outArgs.getDoubleProperty(name,1);
-              thisRoi.x2 = outArgs.getDoubleProperty(name,2);
-              thisRoi.y2 = outArgs.getDoubleProperty(name,3);
-                  
-              // and DON'T clamp it to the clip's rod
-              // We cannot clip it against the RoD because the RoI may be used for frames
-              // at different a time or view than the current time and view passed to this action
-              // which would result in a wrong clipping. Unfortunately only the implementation of
-              // the host can do the correct clipping.
-              //thisRoi = Clamp(thisRoi, rod);
-              rois[it->second] = thisRoi;
-            }
+          ClipInstance *clip = it->clip;
+          if (clip->isOutput() || clip->getConnected()) { // needed to be able to fetch the RoD
+            OfxRectD thisRoi;
+            outArgs.getDoublePropertyN(it->name, &thisRoi.x1, 4);
+
+            // and DON'T clamp it to the clip's rod
+            // We cannot clip it against the RoD because the RoI may be used for frames
+            // at different a time or view than the current time and view passed to this action
+            // which would result in a wrong clipping. Unfortunately only the implementation of
+            // the host can do the correct clipping.
+            //thisRoi = Clamp(thisRoi, rod);
+            rois[clip] = thisRoi;
           }
         }
         return stat;
@@ -2310,37 +2488,21 @@ namespace OFX {
           return kOfxStatFailed;
         }
         OfxStatus stat = kOfxStatReplyDefault;
-        Property::Set outArgs;
+        ActionArgs &args = getActionArgs();
+        Property::PooledSet pooledOutArgs(*args.framesNeededOut);
+        Property::Set &outArgs = *pooledOutArgs;
       
         if(temporalAccess()) {
-          static const Property::PropSpec inStuff[] = {
-            { kOfxPropTime, Property::eDouble, 1, true, "0" },          
-#ifdef OFX_EXTENSIONS_NUKE
-            { kFnOfxImageEffectPropView, Property::eInt, 1, true, "0" },
-#endif
-            Property::propSpecEnd
-          };
-          Property::Set inArgs(inStuff);       
+          Property::PooledSet pooledInArgs(args.framesNeededIn);
+          Property::Set &inArgs = *pooledInArgs;
           inArgs.setDoubleProperty(kOfxPropTime,time);
         
-        
-          for(std::map<std::string, ClipInstance*>::iterator it=_clips.begin();
-              it!=_clips.end();
+          for(std::vector<ActionArgs::ClipArg>::const_iterator it = args.framesNeededClips.begin();
+              it != args.framesNeededClips.end();
               ++it) {
-            if(!it->second->isOutput()) {
-              Property::PropSpec s;
-              std::string name = "OfxImageClipPropFrameRange_"+it->first;
-              
-              s.name = name.c_str();
-              s.type = Property::eDouble;
-              s.dimension = 0;
-              s.readonly = false;
-              s.defaultValue = "";
-              outArgs.createProperty(s);
-              /// intialise it to the current frame
-              outArgs.setDoubleProperty(name, time, 0);
-              outArgs.setDoubleProperty(name, time, 1);
-            }
+            /// intialise it to the current frame
+            outArgs.setDoubleProperty(it->name, time, 0);
+            outArgs.setDoubleProperty(it->name, time, 1);
           }
 
 #         ifdef OFX_DEBUG_ACTIONS
@@ -2387,36 +2549,34 @@ namespace OFX {
         defaultRange.min = 
           defaultRange.max = time;
 
-        for(std::map<std::string, ClipInstance*>::iterator it=_clips.begin();
-            it!=_clips.end();
+        for(std::vector<ActionArgs::ClipArg>::const_iterator it = args.framesNeededClips.begin();
+            it != args.framesNeededClips.end();
             ++it) {
-          ClipInstance *clip = it->second;
-          
-          if(!clip->isOutput()) {
-            if(stat != kOfxStatOK) {
+          ClipInstance *clip = it->clip;
+
+          if(stat != kOfxStatOK) {
+            rangeMap[clip].push_back(defaultRange);
+          }
+          else {
+            const std::string &name = it->name;
+        
+            int nRanges = outArgs.getDimension(name);
+            if(nRanges%2 != 0)
+              return kOfxStatFailed; // bad! needs to be divisible by 2
+
+            if(nRanges == 0) {
               rangeMap[clip].push_back(defaultRange);
             }
             else {
-              std::string name = "OfxImageClipPropFrameRange_"+it->first;
-          
-              int nRanges = outArgs.getDimension(name);
-              if(nRanges%2 != 0)
-                return kOfxStatFailed; // bad! needs to be divisible by 2
-
-              if(nRanges == 0) {
-                rangeMap[clip].push_back(defaultRange);
-              }
-              else {
-                for(int r=0;r<nRanges;){
-                  double min = outArgs.getDoubleProperty(name,r);
-                  double max = outArgs.getDoubleProperty(name,r+1);
-                  r += 2;
-                
-                  OfxRangeD range;
-                  range.min = min;
-                  range.max = max;
-                  rangeMap[clip].push_back(range);
-                }
+              for(int r=0;r<nRanges;){
+                double min = outArgs.getDoubleProperty(name,r);
+                double max = outArgs.getDoubleProperty(name,r+1);
+                r += 2;
+              
+                OfxRangeD range;
+                range.min = min;
+                range.max = max;
+                rangeMap[clip].push_back(range);
               }
             }
           }
@@ -2438,29 +2598,9 @@ namespace OFX {
         if ( OFX::IsNaN(time) ) {
           return kOfxStatFailed;
         }
-        static const Property::PropSpec inStuff[] = {
-          { kOfxPropTime, Property::eDouble, 1, true, "0" },
-          { kOfxImageEffectPropFieldToRender, Property::eString, 1, true, "" }, 
-          { kOfxImageEffectPropRenderWindow, Property::eInt, 4, true, "0" },
-          { kOfxImageEffectPropRenderScale, Property::eDouble, 2, true, "0" },
-#ifdef OFX_EXTENSIONS_NUKE
-          { kFnOfxImageEffectPropView, Property::eInt, 1, true, "0" },
-          { kOfxImageEffectPropIdentityPlane, Property::eString, 1, true, ""},
-#endif
-          Property::propSpecEnd
-        };
-
-        static const Property::PropSpec outStuff[] = {
-          { kOfxPropTime, Property::eDouble, 1, false, "0.0" },
-          { kOfxPropName, Property::eString, 1, false, "" },
-#ifdef OFX_EXTENSIONS_NUKE
-          { kFnOfxImageEffectPropView, Property::eInt, 1, true, "0" },
-          { kOfxImageEffectPropIdentityPlane, Property::eString, 1, true, ""},
-#endif
-          Property::propSpecEnd
-        };
-
-        Property::Set inArgs(inStuff);        
+        ActionArgs &args = getActionArgs();
+        Property::PooledSet pooledInArgs(args.isIdentityIn);
+        Property::Set &inArgs = *pooledInArgs;
 
         inArgs.setStringProperty(kOfxImageEffectPropFieldToRender,field);
         inArgs.setDoubleProperty(kOfxPropTime,time);
@@ -2471,7 +2611,8 @@ namespace OFX {
         inArgs.setStringProperty(kOfxImageEffectPropIdentityPlane, plane);
 #endif
           
-        Property::Set outArgs(outStuff);
+        Property::PooledSet pooledOutArgs(args.isIdentityOut);
+        Property::Set &outArgs = *pooledOutArgs;
 #ifdef OFX_EXTENSIONS_NUKE
         // set the default value on outArgs for backward compatibility
         outArgs.setIntProperty(kFnOfxImageEffectPropView, view);
@@ -3246,7 +3387,10 @@ namespace OFX {
           return kOfxStatErrBadHandle;
         }
 
-        Image* image = clipInstance->getImage(time,h2);
+        // an input the tile renderer has already fetched for the tile being rendered on this thread
+        Image* image = TileRenderer::getPrefetchedImage(clipInstance, time, h2);
+        if(!image)
+          image = clipInstance->getImage(time,h2);
         if(!image) {
           *h3 = NULL;
 
@@ -3462,6 +3606,9 @@ namespace OFX {
         Memory::Instance *memoryInstance = reinterpret_cast<Memory::Instance*>(memoryHandle);
 
         if(memoryInstance && memoryInstance->verifyMagic()) {
+          if (gImageEffectHost) {
+            gImageEffectHost->getMemoryBudget().releaseMemory(memoryInstance);
+          }
           if (memoryInstance->freeMem()) {
             delete memoryInstance;
           }
@@ -4017,7 +4164,6 @@ namespace OFX {
       };
 
       ////////////////////////////////////////////////////////////////////////////////
-#ifdef OFX_SUPPORTS_MULTITHREAD
       // Forward all multithread suite calls to the host implementation.
  
       static OfxStatus multiThread(OfxThreadFunctionV1 func,
@@ -4061,75 +4207,6 @@ namespace OFX {
       static OfxStatus mutexTryLock(const OfxMutexHandle mutex){
         return gImageEffectHost->mutexTryLock(mutex);
       }
-#else // !OFX_SUPPORTS_MULTITHREAD
-      /// a simple multithread suite
-      static OfxStatus multiThread(OfxThreadFunctionV1 func,
-                                   unsigned int /*nThreads*/,
-                                   void *customArg)
-      {
-        if (!func)
-          return kOfxStatFailed;
-        func(0,1,customArg);
-        return kOfxStatOK;
-      }
-
-      static OfxStatus multiThreadNumCPUs(unsigned int *nCPUs)
-      {
-        if (!nCPUs)
-          return kOfxStatFailed;
-        *nCPUs = 1;
-        return kOfxStatOK;
-      }
-
-      static OfxStatus multiThreadIndex(unsigned int *threadIndex){
-        if (!threadIndex)
-          return kOfxStatFailed;
-        *threadIndex = 0;
-        return kOfxStatOK;
-      }
-
-      static int multiThreadIsSpawnedThread(void){
-        return false;
-      }
-
-      static OfxStatus mutexCreate(OfxMutexHandle *mutex, int /*lockCount*/)
-      {
-        if (!mutex)
-          return kOfxStatFailed;
-        // do nothing single threaded
-        *mutex = 0;
-        return kOfxStatOK;
-      }
-
-      static OfxStatus mutexDestroy(const OfxMutexHandle mutex)
-      {
-        if (mutex != 0)
-          return kOfxStatErrBadHandle;
-        // do nothing single threaded
-        return kOfxStatOK;
-      }
-
-      static OfxStatus mutexLock(const OfxMutexHandle mutex){
-        if (mutex != 0)
-          return kOfxStatErrBadHandle;
-        // do nothing single threaded
-        return kOfxStatOK;
-      }
-       
-      static OfxStatus mutexUnLock(const OfxMutexHandle mutex){
-        if (mutex != 0)
-          return kOfxStatErrBadHandle;
-        // do nothing single threaded
-        return kOfxStatOK;
-      }       
-
-      static OfxStatus mutexTryLock(const OfxMutexHandle mutex){
-        if (mutex != 0)
-          return kOfxStatErrBadHandle;
-        // do nothing single threaded
-        return kOfxStatOK;
-      }
-#endif // !OFX_SUPPORTS_MULTITHREAD
        
       static const struct OfxMultiThreadSuiteV1 gMultiThreadSuite = {
         multiThread,
@@ -4248,14 +4325,95 @@ namespace OFX {
 
       // return an memory::instance calls makeMemoryInstance that can be overriden
       Memory::Instance* Host::imageMemoryAlloc(size_t nBytes){
-        Memory::Instance* instance = newMemoryInstance(nBytes);
-        if(instance)
-          return instance;
-        else{
-          Memory::Instance* instance = new Memory::Instance;
-          instance->alloc(nBytes);
-          return instance;
+        if(!_memoryBudget.reserve(0, nBytes))
+          return 0;
+
+        Memory::Instance* instance = 0;
+        try {
+          instance = newMemoryInstance(nBytes);
+          if(!instance){
+            instance = new Memory::Instance;
+            if(!instance->alloc(nBytes)) {
+              delete instance;
+              instance = 0;
+            }
+          }
+        }
+        catch(...) {
+          _memoryBudget.release(0, nBytes);
+          throw;
         }
+        if(!instance) {
+          // the suite reports kOfxStatErrMemory, the reservation must not outlive the failure
+          _memoryBudget.release(0, nBytes);
+          return 0;
+        }
+        _memoryBudget.trackMemory(instance, 0, nBytes);
+        return instance;
+      }
+
+      OfxStatus Host::multiThread(OfxThreadFunctionV1 func, unsigned int nThreads, void *customArg)
+      {
+        return _threadPool.run(func, nThreads, customArg);
+      }
+
+      OfxStatus Host::multiThreadNumCPUS(unsigned int *nCPUs) const
+      {
+        if (!nCPUs)
+          return kOfxStatFailed;
+        *nCPUs = _threadPool.getNumThreads();
+        return kOfxStatOK;
+      }
+
+      OfxStatus Host::multiThreadIndex(unsigned int *threadIndex) const
+      {
+        if (!threadIndex)
+          return kOfxStatFailed;
+        *threadIndex = MultiThread::ThreadPool::getThreadIndex();
+        return kOfxStatOK;
+      }
+
+      int Host::multiThreadIsSpawnedThread() const
+      {
+        return MultiThread::ThreadPool::isSpawnedThread() ? 1 : 0;
+      }
+
+      OfxStatus Host::mutexCreate(OfxMutexHandle *mutex, int lockCount)
+      {
+        if (!mutex)
+          return kOfxStatFailed;
+        *mutex = (new MultiThread::Mutex(lockCount))->getHandle();
+        return kOfxStatOK;
+      }
+
+      OfxStatus Host::mutexDestroy(const OfxMutexHandle mutex)
+      {
+        if (!mutex)
+          return kOfxStatErrBadHandle;
+        delete reinterpret_cast<MultiThread::Mutex *>(mutex);
+        return kOfxStatOK;
+      }
+
+      OfxStatus Host::mutexLock(const OfxMutexHandle mutex)
+      {
+        if (!mutex)
+          return kOfxStatErrBadHandle;
+        reinterpret_cast<MultiThread::Mutex *>(mutex)->lock();
+        return kOfxStatOK;
+      }
+
+      OfxStatus Host::mutexUnLock(const OfxMutexHandle mutex)
+      {
+        if (!mutex)
+          return kOfxStatErrBadHandle;
+        return reinterpret_cast<MultiThread::Mutex *>(mutex)->unlock() ? kOfxStatOK : kOfxStatFailed;
+      }
+
+      OfxStatus Host::mutexTryLock(const OfxMutexHandle mutex)
+      {
+        if (!mutex)
+          return kOfxStatErrBadHandle;
+        return reinterpret_cast<MultiThread::Mutex *>(mutex)->tryLock() ? kOfxStatOK : kOfxStatFailed;
       }
 
       /// our suite fetcher
@@ -4270,6 +4428,9 @@ namespace OFX {
         else if (strcmp(suiteName, kOfxParameterSuite)==0) {
           return Param::GetSuite(suiteVersion);
         }
+        else if (strcmp(suiteName, kOfxParameterBatchSuite)==0) {
+          return Param::GetBatchSuite(suiteVersion);
+        }
         else if (strcmp(suiteName, kOfxMessageSuite)==0) {
           // version 2 is backward-compatible
           if(suiteVersion==1 || suiteVersion==2)
@@ -32,6 +32,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <string>
 #include <map>
 #include <ctype.h>
+#include <string.h>
 #include <stdexcept>
 
 // ofx
@@ -39,16 +40,20 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 // ofx host
 #include "ofxhBinary.h"
+#include "ofxhBinaryCache.h"
 #include "ofxhPropertySuite.h"
+#include "ofxhPropertyProfiler.h"
 #include "ofxhClip.h"
 #include "ofxhParam.h"
 #include "ofxhMemory.h"
+#include "ofxhMultiThread.h"
 #include "ofxhImageEffect.h"
 #include "ofxhPluginAPICache.h"
 #include "ofxhPluginCache.h"
 #include "ofxhHost.h"
 #include "ofxhImageEffectAPI.h"
 #include "ofxhXml.h"
+#include "ofxhUtilities.h"
 
 // Disable the "this pointer used in base member initialiser list" warning in Windows
 namespace OFX {
@@ -70,6 +75,10 @@ namespace OFX {
         , _baseDescriptor(NULL)
         , _madeKnownContexts(false)
         , _pluginHandle()
+        , _binaryCache(NULL)
+        , _binaryCacheFirstSet(0)
+        , _binaryCacheNSets(0)
+        , _decodingBinaryCache(false)
       {
         _baseDescriptor = gImageEffectHost->makeDescriptor(this);
       }
@@ -88,6 +97,10 @@ namespace OFX {
         , _baseDescriptor(NULL) 
         , _madeKnownContexts(false)
         , _pluginHandle()
+        , _binaryCache(NULL)
+        , _binaryCacheFirstSet(0)
+        , _binaryCacheNSets(0)
+        , _decodingBinaryCache(false)
       {        
         _baseDescriptor = gImageEffectHost->makeDescriptor(this);
       }
@@ -102,6 +115,9 @@ namespace OFX {
           delete it->second;
         }
         _contexts.clear();
+        for(size_t i = 0; i < _staleContexts.size(); ++i) {
+          delete _staleContexts[i];
+        }
         unload();
         delete _baseDescriptor;
       }
@@ -114,14 +130,111 @@ namespace OFX {
 
       /// get the image effect descriptor
       Descriptor &ImageEffectPlugin::getDescriptor() {
+        decodeBinaryCache();
         return *_baseDescriptor;
       }
 
       /// get the image effect descriptor const version
       const Descriptor &ImageEffectPlugin::getDescriptor() const {
+        decodeBinaryCache();
         return *_baseDescriptor;
       }
 
+      /// guards the decoding of plugins from a binary cache
+      static MultiThread::Mutex gBinaryCacheLock;
+
+      /// tells the plugin cache how long a step of loading a plugin took, when it goes out of scope
+      class LoadTimer {
+        const Plugin *_plugin;
+        std::string _step;
+        double _start;
+      public :
+        LoadTimer(const Plugin *plugin, const std::string &step)
+          : _plugin(plugin)
+          , _step(step)
+          , _start(OFX::GetTimeInSeconds())
+        {
+        }
+
+        ~LoadTimer()
+        {
+          OFX::Host::PluginCache::getPluginCache()->recordLoadTiming(_plugin->getBinary()->getBundlePath(), _plugin->getIdentifier(),
+                                                                     _step, OFX::GetTimeInSeconds() - _start);
+        }
+      };
+
+      void ImageEffectPlugin::setBinaryCache(const BinaryCache::Reader &reader, BinaryCache::UInt32 firstSet, BinaryCache::UInt32 nSets)
+      {
+        _binaryCacheFirstSet = firstSet;
+        _binaryCacheNSets = nSets;
+        _binaryCache = &reader;
+      }
+
+      void ImageEffectPlugin::decodeBinaryCache() const
+      {
+        if(!_binaryCache) {
+          return;
+        }
+
+        MultiThread::ScopedLock lock(gBinaryCacheLock);
+        if(!_binaryCache || _decodingBinaryCache) {
+          // done by another thread, or we are being called back while decoding
+          return;
+        }
+        _decodingBinaryCache = true;
+        const BinaryCache::Reader *reader = _binaryCache;
+
+        // decoding is logically const, it just fills in what we already had
+        ImageEffectPlugin *self = const_cast<ImageEffectPlugin *>(this);
+        Descriptor *context = 0;
+        for(BinaryCache::UInt32 i = 0; i < _binaryCacheNSets; ++i) {
+          const BinaryCache::SetRecord &record = reader->getSet(_binaryCacheFirstSet + i);
+          const char *tag = reader->getString(record.tag);
+          if(strcmp(tag, "descriptor") == 0) {
+            reader->readSet(record, _baseDescriptor->getProps());
+          }
+          else if(strcmp(tag, "context") == 0) {
+            context = gImageEffectHost->makeDescriptor(getBinary()->getBundlePath(), self);
+            reader->readSet(record, context->getProps());
+            self->addContext(reader->getString(record.name), context);
+          }
+          else if(strcmp(tag, "param") == 0 && context) {
+            Param::Descriptor *param = context->paramDefine(reader->getString(record.type), reader->getString(record.name));
+            if(param) {
+              reader->readSet(record, param->getProperties());
+            }
+          }
+          else if(strcmp(tag, "clip") == 0 && context) {
+            ClipDescriptor *clip = new ClipDescriptor(reader->getString(record.name));
+            context->addClip(reader->getString(record.name), clip);
+            reader->readSet(record, clip->getProps());
+          }
+        }
+        self->addSupportedContexts();
+        _decodingBinaryCache = false;
+        _binaryCache = NULL;
+      }
+
+      void ImageEffectPlugin::saveBinary(BinaryCache::Writer &writer)
+      {
+        writer.addSet("descriptor", "", "", getDescriptor().getProps());
+
+        for(std::map<std::string, Descriptor *>::const_iterator it = _contexts.begin(); it != _contexts.end(); ++it) {
+          Descriptor *context = it->second;
+          writer.addSet("context", it->first, "", context->getProps());
+
+          const std::list<Param::Descriptor *> &params = context->getParamList();
+          for(std::list<Param::Descriptor *>::const_iterator p = params.begin(); p != params.end(); ++p) {
+            writer.addSet("param", (*p)->getName(), (*p)->getType(), (*p)->getProperties());
+          }
+
+          const std::vector<ClipDescriptor *> &clips = context->getClipsByOrder();
+          for(std::vector<ClipDescriptor *>::const_iterator c = clips.begin(); c != clips.end(); ++c) {
+            writer.addSet("clip", (*c)->getName(), "", (*c)->getProps());
+          }
+        }
+      }
+
       void ImageEffectPlugin::addContext(const std::string &context, Descriptor *ied)
       {
         _contexts[context] = ied;
@@ -141,12 +254,43 @@ namespace OFX {
         _madeKnownContexts = true;
       }
 
+      void ImageEffectPlugin::addSupportedContexts()
+      {
+        const OFX::Host::Property::Set &eProps = getDescriptor().getProps();
+        int size = eProps.getDimension(kOfxImageEffectPropSupportedContexts);
+        for (int j=0;j<size;j++) {
+          addContextInternal(eProps.getStringProperty(kOfxImageEffectPropSupportedContexts, j));
+        }
+      }
+
       void ImageEffectPlugin::saveXML(std::ostream &os) 
       {        
         APICache::propertySetXMLWrite(os, getDescriptor().getProps(), 6);
+
+        for(std::map<std::string, Descriptor *>::const_iterator it = _contexts.begin(); it != _contexts.end(); ++it) {
+          Descriptor *context = it->second;
+          os << "      <context " << XML::attribute("name", it->first) << ">\n";
+          APICache::propertySetXMLWrite(os, context->getProps(), 8);
+
+          const std::list<Param::Descriptor *> &params = context->getParamList();
+          for(std::list<Param::Descriptor *>::const_iterator p = params.begin(); p != params.end(); ++p) {
+            os << "        <param " << XML::attribute("name", (*p)->getName()) << XML::attribute("type", (*p)->getType()) << ">\n";
+            APICache::propertySetXMLWrite(os, (*p)->getProperties(), 10);
+            os << "        </param>\n";
+          }
+
+          const std::vector<ClipDescriptor *> &clips = context->getClipsByOrder();
+          for(std::vector<ClipDescriptor *>::const_iterator c = clips.begin(); c != clips.end(); ++c) {
+            os << "        <clip " << XML::attribute("name", (*c)->getName()) << ">\n";
+            APICache::propertySetXMLWrite(os, (*c)->getProps(), 10);
+            os << "        </clip>\n";
+          }
+          os << "      </context>\n";
+        }
       }
 
       const std::set<std::string> &ImageEffectPlugin::getContexts() const {
+        decodeBinaryCache();
         if (_madeKnownContexts) {
           return _knownContexts;
         } 
@@ -178,6 +322,8 @@ namespace OFX {
 #           ifdef OFX_DEBUG_ACTIONS
               std::cout << "OFX: "<<op->pluginIdentifier<<"("<<(void*)op<<")->"<<kOfxActionLoad<<"()"<<std::endl;
 #           endif
+            Property::Profiler::ActionScope profile(kOfxActionLoad);
+            LoadTimer timer(this, kOfxActionLoad);
             stat = op->mainEntry(kOfxActionLoad, 0, 0, 0);
 #           ifdef OFX_DEBUG_ACTIONS
               std::cout << "OFX: "<<op->pluginIdentifier<<"("<<(void*)op<<")->"<<kOfxActionLoad<<"()->"<<StatStr(stat)<<std::endl;
@@ -193,6 +339,8 @@ namespace OFX {
 #           ifdef OFX_DEBUG_ACTIONS
               std::cout << "OFX: "<<op->pluginIdentifier<<"("<<(void*)op<<")->"<<kOfxActionDescribe<<"()"<<std::endl;
 #           endif
+            Property::Profiler::ActionScope profile(kOfxActionDescribe);
+            LoadTimer timer(this, kOfxActionDescribe);
             stat = op->mainEntry(kOfxActionDescribe, getDescriptor().getHandle(), 0, 0);
 #           ifdef OFX_DEBUG_ACTIONS
               std::cout << "OFX: "<<op->pluginIdentifier<<"("<<(void*)op<<")->"<<kOfxActionDescribe<<"()->"<<StatStr(stat)<<std::endl;
@@ -210,6 +358,8 @@ namespace OFX {
 
       Descriptor *ImageEffectPlugin::getContext(const std::string &context) 
       {
+        decodeBinaryCache();
+
         std::map<std::string, Descriptor *>::iterator it = _contexts.find(context);
 
         if (it != _contexts.end()) {
@@ -217,10 +367,26 @@ namespace OFX {
           return it->second;
         }
 
-        if (_knownContexts.find(context) == _knownContexts.end()) {
+        const std::set<std::string> &contexts = getContexts();
+        if (contexts.find(context) == contexts.end()) {
           return 0;
         }
 
+        return describeInContext(context);
+      }
+
+      Descriptor *ImageEffectPlugin::describeInContext(const std::string &context)
+      {
+        PluginHandle *ph = getPluginHandle();
+        Descriptor *desc = describeInContext(context, ph->getOfxPlugin());
+        if (desc) {
+          _liveContexts.insert(context);
+        }
+        return desc;
+      }
+
+      Descriptor *ImageEffectPlugin::describeInContext(const std::string &context, OfxPlugin *ofxPlugin)
+      {
         //        printf("doing context description.\n");
 
         OFX::Host::Property::PropSpec inargspec[] = {
@@ -229,24 +395,31 @@ namespace OFX {
         };
         
         OFX::Host::Property::Set inarg(inargspec);
+        inarg.setKind("inArgs");
 
-        PluginHandle *ph = getPluginHandle();
         auto_ptr<ImageEffect::Descriptor> newContext( gImageEffectHost->makeDescriptor(getDescriptor(), this));
 
         OfxStatus stat;
         try {
 #         ifdef OFX_DEBUG_ACTIONS
-            OfxPlugin *ofxp = ph->getOfxPlugin();
+            OfxPlugin *ofxp = ofxPlugin;
             const char* id = ofxp->pluginIdentifier;
             std::cout << "OFX: "<<id<<"("<<ofxp<<")->"<<kOfxImageEffectActionDescribeInContext<<"("<<context<<")"<<std::endl;
 #         endif
-          stat = ph->getOfxPlugin()->mainEntry(kOfxImageEffectActionDescribeInContext, newContext->getHandle(), inarg.getHandle(), 0);
+          Property::Profiler::ActionScope profile(kOfxImageEffectActionDescribeInContext);
+          LoadTimer timer(this, std::string(kOfxImageEffectActionDescribeInContext) + " " + context);
+          stat = ofxPlugin->mainEntry(kOfxImageEffectActionDescribeInContext, newContext->getHandle(), inarg.getHandle(), 0);
 #         ifdef OFX_DEBUG_ACTIONS
             std::cout << "OFX: "<<id<<"("<<ofxp<<")->"<<kOfxImageEffectActionDescribeInContext<<"("<<context<<")->"<<StatStr(stat)<<std::endl;
 #         endif
-        } CatchAllSetStatus(stat, gImageEffectHost, ph->getOfxPlugin(), kOfxImageEffectActionDescribeInContext);
+        } CatchAllSetStatus(stat, gImageEffectHost, ofxPlugin, kOfxImageEffectActionDescribeInContext);
 
         if (stat == kOfxStatOK || stat == kOfxStatReplyDefault) {
+          std::map<std::string, Descriptor *>::iterator it = _contexts.find(context);
+          if (it != _contexts.end()) {
+            // the one from the cache may still be pointed at
+            _staleContexts.push_back(it->second);
+          }
           _contexts[context] = newContext.release();
           return _contexts[context];
         }
@@ -263,6 +436,12 @@ namespace OFX {
         getPluginHandle();
 
         Descriptor *desc = getContext(context);
+
+        // a context descriptor from the cache will do to look at, but plugins keep state
+        // from describing a context that their instances need, so have the plugin do it
+        if (desc && _liveContexts.find(context) == _liveContexts.end()) {
+          desc = describeInContext(context);
+        }
         
         if (desc) {
           ImageEffect::Instance *instance = gImageEffectHost->newInstance(clientData,
@@ -283,6 +462,7 @@ namespace OFX {
               OfxPlugin *op = _pluginHandle->getOfxPlugin();
               std::cout << "OFX: "<<op->pluginIdentifier<<"("<<(void*)op<<")->"<<kOfxActionUnload<<"()"<<std::endl;
 #           endif
+            Property::Profiler::ActionScope profile(kOfxActionUnload);
             stat = (*_pluginHandle)->mainEntry(kOfxActionUnload, 0, 0, 0);
 #           ifdef OFX_DEBUG_ACTIONS
               std::cout << "OFX: "<<op->pluginIdentifier<<"("<<(void*)op<<")->"<<kOfxActionUnload<<"()->"<<StatStr(stat)<<std::endl;
@@ -410,6 +590,8 @@ namespace OFX {
 #         ifdef OFX_DEBUG_ACTIONS
             std::cout << "OFX: "<<id<<"("<<ofxp<<")->"<<kOfxActionLoad<<"()"<<std::endl;
 #         endif
+          Property::Profiler::ActionScope profile(kOfxActionLoad);
+          LoadTimer timer(op, kOfxActionLoad);
           stat = plug->mainEntry(kOfxActionLoad, 0, 0, 0);
 #         ifdef OFX_DEBUG_ACTIONS
             std::cout << "OFX: "<<id<<"("<<ofxp<<")->"<<kOfxActionLoad<<"()->"<<StatStr(stat)<<std::endl;
@@ -425,6 +607,8 @@ namespace OFX {
 #         ifdef OFX_DEBUG_ACTIONS
             std::cout << "OFX: "<<id<<"("<<ofxp<<")->"<<kOfxActionDescribe<<"()"<<std::endl;
 #         endif
+          Property::Profiler::ActionScope profile(kOfxActionDescribe);
+          LoadTimer timer(op, kOfxActionDescribe);
           stat = plug->mainEntry(kOfxActionDescribe, p->getDescriptor().getHandle(), 0, 0);
 #         ifdef OFX_DEBUG_ACTIONS
             std::cout << "OFX: "<<id<<"("<<ofxp<<")->"<<kOfxActionDescribe<<"()->"<<StatStr(stat)<<std::endl;
@@ -446,10 +630,20 @@ namespace OFX {
           p->addContext(context);
         }
 
+        // describe the contexts while we have the plugin loaded, so they go in the cache
+        // and hosts can look at them without loading the plugin again
+        for (int j=0;j<size;j++) {
+          std::string context = eProps.getStringProperty(kOfxImageEffectPropSupportedContexts, j);
+          if (!p->describeInContext(context, plug.getOfxPlugin())) {
+            std::cerr << "describe in context " << context << " failed on plugin " << op->getIdentifier() << std::endl;
+          }
+        }
+
         try {
 #         ifdef OFX_DEBUG_ACTIONS
             std::cout << "OFX: "<<id<<"("<<ofxp<<")->"<<kOfxActionUnload<<"()"<<std::endl;
 #         endif
+          Property::Profiler::ActionScope profile(kOfxActionUnload);
           stat = plug->mainEntry(kOfxActionUnload, 0, 0, 0);
 #         ifdef OFX_DEBUG_ACTIONS
             std::cout << "OFX: "<<id<<"("<<ofxp<<")->"<<kOfxActionUnload<<"()->"<<StatStr(stat)<<std::endl;
@@ -520,6 +714,11 @@ namespace OFX {
           return;
         }
 
+        if (_currentContext) {
+          APICache::propertySetXMLRead(el, map, _currentContext->getProps(), _currentProp);
+          return;
+        }
+
         if (!_currentContext && !_currentParam) {
           APICache::propertySetXMLRead(el, map, _currentPlugin->getDescriptor().getProps(), _currentProp);
           return;
@@ -537,12 +736,21 @@ namespace OFX {
           _currentParam = 0;
         }
 
+        if (el == "clip") {
+          _currentClip = 0;
+        }
+
         if (el == "context") {
           _currentContext = 0;
+          _currentClip = 0;
         }
       }
 
       void PluginCache::endXmlParsing() {
+        if (_currentPlugin) {
+          // reading in contexts has made them known, make sure the others are too
+          _currentPlugin->addSupportedContexts();
+        }
         _currentPlugin = 0;
       }
 
@@ -553,6 +761,20 @@ namespace OFX {
         }
       }
 
+      void PluginCache::saveBinary(Plugin *ip, BinaryCache::Writer &writer) const {
+        ImageEffectPlugin *p = dynamic_cast<ImageEffectPlugin*>(ip);
+        if (p) {
+          p->saveBinary(writer);
+        }
+      }
+
+      void PluginCache::loadBinary(Plugin *ip, const BinaryCache::Reader &reader, BinaryCache::UInt32 firstSet, BinaryCache::UInt32 nSets) {
+        ImageEffectPlugin *p = dynamic_cast<ImageEffectPlugin*>(ip);
+        if (p) {
+          p->setBinaryCache(reader, firstSet, nSets);
+        }
+      }
+
       void PluginCache::confirmPlugin(Plugin *p, const std::list<std::string>& pluginPath) {
         ImageEffectPlugin *plugin = dynamic_cast<ImageEffectPlugin*>(p);
         if (!plugin) {
@@ -609,6 +831,19 @@ namespace OFX {
         }
       }
 
+      void PluginCache::forgetPlugin(Plugin *p, const std::list<std::string>& pluginPath) {
+        // work out again which versions win without it
+        std::vector<ImageEffectPlugin *> plugins;
+        plugins.swap(_plugins);
+        _pluginsByID.clear();
+        _pluginsByIDMajor.clear();
+        for (std::vector<ImageEffectPlugin *>::iterator it = plugins.begin(); it != plugins.end(); ++it) {
+          if (*it != p) {
+            confirmPlugin(*it, pluginPath);
+          }
+        }
+      }
+
       Plugin *PluginCache::newPlugin(PluginBinary *pb,
         int pi,
         OfxPlugin *pl) {
@@ -42,6 +42,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 // ofx host
 #include "ofxhBinary.h"
 #include "ofxhPropertySuite.h"
+#include "ofxhPropertyProfiler.h"
 #include "ofxhClip.h"
 #include "ofxhParam.h"
 #include "ofxhMemory.h"
@@ -72,6 +73,7 @@ namespace OFX {
         , _state(eUninitialised)
         , _entryPoint(NULL)
       {
+        _properties.setKind("interact");
       }
 
       Descriptor::~Descriptor()
@@ -103,6 +105,7 @@ namespace OFX {
                                       OfxPropertySetHandle outArgs)
       {
         if(_entryPoint && _state != eFailed) {
+          Property::Profiler::ActionScope profile(action);
           return _entryPoint(action, handle, inArgs, outArgs);
         }
         else
@@ -165,6 +168,8 @@ namespace OFX {
         , _effectInstance(effectInstance)
         , _argProperties(interactArgsStuffs)
       {
+        _properties.setKind("interact");
+        _argProperties.setKind("inArgs");
         _properties.setPointerProperty(kOfxPropEffectInstance, effectInstance);
         _properties.setChainedSet(&desc.getProperties()); /// chain it into the descriptor props
         _properties.setGetHook(kOfxInteractPropPixelScale, this);
@@ -29,12 +29,29 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 // ofx host
 
+#include <stdlib.h>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+#include <vector>
+
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1900)
+#define OFX_HOST_HAS_THREADS
+#endif
+
+#ifdef OFX_HOST_HAS_THREADS
+#include <atomic>
+#include <functional>
+#include <thread>
+#endif
+
 // ofx
 #include "ofxCore.h"
 #include "ofxImageEffect.h"
 
 // ofx host
 #include "ofxhMemory.h"
+#include "ofxhMultiThread.h"
 
 namespace OFX {
 
@@ -42,18 +59,397 @@ namespace OFX {
 
     namespace Memory {
 
-      Instance::Instance() : _ptr(NULL), _locked(0) {}
+      ////////////////////////////////////////////////////////////////////////////////
+      // memory pool
+
+      static const size_t kAlignment = 64;
+      static const size_t kPageSize = 4096;
+      static const size_t kMinSizeClass = 64;
+      static const int    kMinSizeClassLog2 = 6;
+      static const int    kNSizeClasses = 4 * (8 * int(sizeof(size_t)) - kMinSizeClassLog2);
+      static const size_t kBlockMagic = 0x0f0e0d0c;
+
+      /// what sits just ahead of the memory handed out
+      struct BlockHeader {
+        size_t sizeClass;
+        size_t magic;
+      };
+
+      /// floor(log2(n)), n > 0
+      static int log2Floor(size_t n)
+      {
+        int l = 0;
+        while(n >>= 1)
+          ++l;
+        return l;
+      }
+
+      /// the index of the size class nBytes rounds up to, and that size class
+      static int getSizeClassIndex(size_t nBytes, size_t &sizeClass)
+      {
+        if(nBytes <= kMinSizeClass) {
+          sizeClass = kMinSizeClass;
+          return 0;
+        }
+
+        // four classes per power of two, base, base*5/4, base*6/4 and base*7/4
+        int l = log2Floor(nBytes - 1);
+        size_t base = size_t(1) << l;
+        size_t step = base / 4;
+        size_t quarter = (nBytes - base + step - 1) / step;
+        if(quarter == 4) {
+          ++l;
+          base <<= 1;
+          quarter = 0;
+        }
+        sizeClass = base + quarter * (base / 4);
+        return 4 * (l - kMinSizeClassLog2) + int(quarter);
+      }
+
+      /// the offset from the start of a block to the memory handed out, which sets its alignment
+      static size_t getBlockOffset(size_t sizeClass)
+      {
+        return sizeClass >= kPageSize ? kPageSize : kAlignment;
+      }
+
+      /// get a block from the system
+      static void *systemAllocate(size_t sizeClass)
+      {
+        size_t offset = getBlockOffset(sizeClass);
+        if(sizeClass > size_t(-1) - offset)
+          return 0;
+        void *block = 0;
+#     ifdef _WIN32
+        block = _aligned_malloc(offset + sizeClass, offset);
+#     else
+        if(posix_memalign(&block, offset, offset + sizeClass) != 0)
+          block = 0;
+#     endif
+        if(!block)
+          return 0;
+
+        char *ptr = static_cast<char *>(block) + offset;
+        BlockHeader *header = reinterpret_cast<BlockHeader *>(ptr - kAlignment);
+        header->sizeClass = sizeClass;
+        header->magic = kBlockMagic;
+        return ptr;
+      }
+
+      /// give a block back to the system
+      static void systemFree(void *ptr, size_t sizeClass)
+      {
+        void *block = static_cast<char *>(ptr) - getBlockOffset(sizeClass);
+#     ifdef _WIN32
+        _aligned_free(block);
+#     else
+        free(block);
+#     endif
+      }
+
+      /// the header of a block handed out by the pool
+      static BlockHeader *getHeader(void *ptr)
+      {
+        return reinterpret_cast<BlockHeader *>(static_cast<char *>(ptr) - kAlignment);
+      }
+
+      /// a counter that can be shared between threads
+#   ifdef OFX_HOST_HAS_THREADS
+      typedef std::atomic<size_t> Counter;
+#   else
+      typedef size_t Counter;
+#   endif
+
+      /// a set of free lists with their own lock
+      struct Arena {
+        MultiThread::Mutex   lock;
+        std::vector<void *>  freeLists[kNSizeClasses];
+      };
+
+#   ifdef OFX_HOST_HAS_THREADS
+      /// the most bytes of freed blocks one thread keeps to itself, beyond that they go to the arenas
+      static const size_t kThreadCacheMaxBytes = 8 * 1024 * 1024;
+
+      /// the most freed blocks of one size class one thread keeps to itself
+      static const size_t kThreadCacheMaxBlocks = 8;
+#   endif
+
+      class Pool::Implementation {
+      public:
+        std::vector<Arena *>  arenas;
+        Counter               maxRetainedBytes;
+        Counter               retainedBytes;
+        Counter               allocatedBytes;
+        bool                  threadCached; ///< does this pool use the per thread caches
+
+#     ifdef OFX_HOST_HAS_THREADS
+        /// freed blocks of the default pool kept by one thread, used without taking any lock
+        struct ThreadCache {
+          std::vector<void *> freeLists[kNSizeClasses];
+          size_t              bytes;
+
+          ThreadCache() : bytes(0) {}
+
+          /// hands the blocks to the default pool's arenas, or to the system if it has gone
+          ~ThreadCache();
+        };
+
+        /// the calling thread's cache, only the default pool uses these
+        static thread_local ThreadCache threadCache;
+
+        /// the default pool while it exists, for threads that exit to give their caches back to
+        static std::atomic<Implementation *> defaultPool;
+
+        /// called once, when the default pool is made
+        static bool setDefault(Implementation *imp)
+        {
+          imp->threadCached = true;
+          defaultPool.store(imp);
+          return true;
+        }
+#     endif
+
+        Implementation(size_t maxRetained)
+          : threadCached(false)
+        {
+          maxRetainedBytes = maxRetained;
+          retainedBytes = 0;
+          allocatedBytes = 0;
+
+          unsigned int nArenas = MultiThread::getNumHardwareThreads();
+          if(nArenas > 16)
+            nArenas = 16;
+          for(unsigned int i = 0; i < nArenas; ++i)
+            arenas.push_back(new Arena);
+        }
+
+        ~Implementation()
+        {
+#       ifdef OFX_HOST_HAS_THREADS
+          if(threadCached)
+            defaultPool.store(0);
+#       endif
+          trim(0);
+          for(size_t i = 0; i < arenas.size(); ++i)
+            delete arenas[i];
+        }
+
+        /// the arena the calling thread uses
+        Arena &getArena()
+        {
+#       ifdef OFX_HOST_HAS_THREADS
+          size_t id = std::hash<std::thread::id>()(std::this_thread::get_id());
+          return *arenas[id % arenas.size()];
+#       else
+          return *arenas[0];
+#       endif
+        }
+
+#     ifdef OFX_HOST_HAS_THREADS
+        /// move the blocks in a thread's cache to the shared arenas, they stay counted as retained
+        void drainThreadCache(ThreadCache &cache)
+        {
+          Arena &arena = getArena();
+          MultiThread::ScopedLock lock(arena.lock);
+          for(int index = 0; index < kNSizeClasses && cache.bytes > 0; ++index) {
+            std::vector<void *> &freeList = cache.freeLists[index];
+            arena.freeLists[index].insert(arena.freeLists[index].end(), freeList.begin(), freeList.end());
+            for(size_t i = 0; i < freeList.size(); ++i)
+              cache.bytes -= getHeader(freeList[i])->sizeClass;
+            freeList.clear();
+          }
+        }
+#     endif
+
+        /// give blocks back to the system, only the calling thread's cache can be reached,
+        /// other threads' caches are given back when those threads exit
+        void trim(size_t nBytes)
+        {
+#       ifdef OFX_HOST_HAS_THREADS
+          if(threadCached)
+            drainThreadCache(threadCache);
+#       endif
+          // biggest blocks first, they give back the most for the least work
+          for(int index = kNSizeClasses - 1; index >= 0 && retainedBytes > nBytes; --index) {
+            for(size_t a = 0; a < arenas.size() && retainedBytes > nBytes; ++a) {
+              Arena &arena = *arenas[a];
+              MultiThread::ScopedLock lock(arena.lock);
+              std::vector<void *> &freeList = arena.freeLists[index];
+              while(!freeList.empty() && retainedBytes > nBytes) {
+                void *ptr = freeList.back();
+                freeList.pop_back();
+                size_t sizeClass = getHeader(ptr)->sizeClass;
+                retainedBytes -= sizeClass;
+                systemFree(ptr, sizeClass);
+              }
+            }
+          }
+        }
+      };
+
+#   ifdef OFX_HOST_HAS_THREADS
+      thread_local Pool::Implementation::ThreadCache Pool::Implementation::threadCache;
+
+      std::atomic<Pool::Implementation *> Pool::Implementation::defaultPool(0);
+
+      Pool::Implementation::ThreadCache::~ThreadCache()
+      {
+        Implementation *imp = defaultPool.load();
+        if(imp) {
+          imp->drainThreadCache(*this);
+          return;
+        }
+        // the thread has outlived the default pool
+        for(int index = 0; index < kNSizeClasses; ++index) {
+          for(size_t i = 0; i < freeLists[index].size(); ++i)
+            systemFree(freeLists[index][i], getHeader(freeLists[index][i])->sizeClass);
+        }
+      }
+#   endif
+
+      Pool::Pool(size_t maxRetainedBytes)
+        : _imp(new Implementation(maxRetainedBytes))
+      {
+      }
+
+      Pool::~Pool()
+      {
+        delete _imp;
+      }
+
+      Pool &Pool::getDefault()
+      {
+        static Pool pool;
+#     ifdef OFX_HOST_HAS_THREADS
+        // only the default pool, which lives until exit, has per thread caches
+        static bool threadCached = Implementation::setDefault(pool._imp);
+        (void)threadCached;
+#     endif
+        return pool;
+      }
+
+      size_t Pool::getSizeClass(size_t nBytes)
+      {
+        size_t sizeClass;
+        getSizeClassIndex(nBytes, sizeClass);
+        return sizeClass;
+      }
+
+      void *Pool::allocate(size_t nBytes)
+      {
+        size_t sizeClass;
+        int index = getSizeClassIndex(nBytes, sizeClass);
+
+        void *ptr = 0;
+#     ifdef OFX_HOST_HAS_THREADS
+        if(_imp->threadCached) {
+          Implementation::ThreadCache &cache = Implementation::threadCache;
+          std::vector<void *> &freeList = cache.freeLists[index];
+          if(!freeList.empty()) {
+            ptr = freeList.back();
+            freeList.pop_back();
+            cache.bytes -= sizeClass;
+          }
+        }
+        if(!ptr)
+#     endif
+        {
+          Arena &arena = _imp->getArena();
+          MultiThread::ScopedLock lock(arena.lock);
+          std::vector<void *> &freeList = arena.freeLists[index];
+          if(!freeList.empty()) {
+            ptr = freeList.back();
+            freeList.pop_back();
+          }
+        }
+
+        if(ptr)
+          _imp->retainedBytes -= sizeClass;
+        else
+          ptr = systemAllocate(sizeClass);
+
+        if(ptr)
+          _imp->allocatedBytes += sizeClass;
+        return ptr;
+      }
+
+      void Pool::deallocate(void *ptr)
+      {
+        if(!ptr)
+          return;
+
+        size_t sizeClass = getHeader(ptr)->sizeClass;
+        _imp->allocatedBytes -= sizeClass;
+
+        // over budget, give it straight back
+        if(_imp->retainedBytes + sizeClass > _imp->maxRetainedBytes) {
+          systemFree(ptr, sizeClass);
+          return;
+        }
+
+        size_t rounded;
+        int index = getSizeClassIndex(sizeClass, rounded);
+        _imp->retainedBytes += sizeClass;
+#     ifdef OFX_HOST_HAS_THREADS
+        if(_imp->threadCached) {
+          Implementation::ThreadCache &cache = Implementation::threadCache;
+          std::vector<void *> &freeList = cache.freeLists[index];
+          if(freeList.size() < kThreadCacheMaxBlocks && cache.bytes + sizeClass <= kThreadCacheMaxBytes) {
+            freeList.push_back(ptr);
+            cache.bytes += sizeClass;
+            return;
+          }
+        }
+#     endif
+        Arena &arena = _imp->getArena();
+        MultiThread::ScopedLock lock(arena.lock);
+        arena.freeLists[index].push_back(ptr);
+      }
+
+      size_t Pool::getMaxRetainedBytes() const
+      {
+        return _imp->maxRetainedBytes;
+      }
+
+      void Pool::setMaxRetainedBytes(size_t nBytes)
+      {
+        _imp->maxRetainedBytes = nBytes;
+        _imp->trim(nBytes);
+      }
+
+      void Pool::trim(size_t nBytes)
+      {
+        _imp->trim(nBytes);
+      }
+
+      size_t Pool::getRetainedBytes() const
+      {
+        return _imp->retainedBytes;
+      }
+
+      size_t Pool::getAllocatedBytes() const
+      {
+        return _imp->allocatedBytes;
+      }
+
+      ////////////////////////////////////////////////////////////////////////////////
+      // memory instance
+
+      Instance::Instance() : _ptr(NULL), _locked(0), _pooled(false) {}
 
       Instance::~Instance() {
-        delete [] _ptr;
+        if(_pooled)
+          Pool::getDefault().deallocate(_ptr);
+        else
+          delete [] _ptr;
       }
 
       bool Instance::alloc(size_t nBytes) {
         if(!_locked){
           if(_ptr)
             freeMem(); // ignore return value
-          _ptr = new char[nBytes];
-          return true;
+          _ptr = static_cast<char *>(Pool::getDefault().allocate(nBytes));
+          _pooled = true;
+          return _ptr != 0;
         }
         else
           return false;
@@ -64,8 +460,12 @@ namespace OFX {
       }
 
       bool Instance::freeMem(){
-        delete [] _ptr;
+        if(_pooled)
+          Pool::getDefault().deallocate(_ptr);
+        else
+          delete [] _ptr;
         _ptr = 0;
+        _pooled = false;
         _locked = 0;
         return true;
       }
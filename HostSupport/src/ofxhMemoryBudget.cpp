@@ -0,0 +1,296 @@
+
+/*
+Software License :
+
+Copyright (c) 2007-2009, The Open Effects Association Ltd. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+* Neither the name The Open Effects Association Ltd, nor the names of its 
+contributors may be used to endorse or promote products derived from this
+software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <algorithm>
+
+// ofx
+#include "ofxCore.h"
+#include "ofxImageEffect.h"
+
+// ofx host
+#include "ofxhBinary.h"
+#include "ofxhPropertySuite.h"
+#include "ofxhClip.h"
+#include "ofxhImageEffect.h"
+#include "ofxhImageCache.h"
+#include "ofxhMemory.h"
+#include "ofxhMemoryBudget.h"
+
+namespace OFX {
+
+  namespace Host {
+
+    namespace ImageEffect {
+
+      /// orders instances by when they last rendered
+      struct RenderedBefore {
+        bool operator()(const std::pair<unsigned long, Instance *> &a, const std::pair<unsigned long, Instance *> &b) const
+        {
+          return a.first < b.first;
+        }
+      };
+
+      MemoryBudget::MemoryBudget(size_t maxBytes)
+        : _maxBytes(maxBytes)
+        , _countedBytes(0)
+        , _clock(0)
+      {
+      }
+
+      MemoryBudget::~MemoryBudget()
+      {
+      }
+
+      void MemoryBudget::setMaxBytes(size_t maxBytes)
+      {
+        {
+          MultiThread::ScopedLock lock(_lock);
+          _maxBytes = maxBytes;
+        }
+        if(maxBytes > 0)
+          purge(maxBytes);
+      }
+
+      void MemoryBudget::addCache(ImageCache *cache)
+      {
+        MultiThread::ScopedLock lock(_lock);
+        if(cache && std::find(_caches.begin(), _caches.end(), cache) == _caches.end())
+          _caches.push_back(cache);
+      }
+
+      void MemoryBudget::removeCache(ImageCache *cache)
+      {
+        MultiThread::ScopedLock lock(_lock);
+        _caches.erase(std::remove(_caches.begin(), _caches.end(), cache), _caches.end());
+      }
+
+      size_t MemoryBudget::getBytesLocked() const
+      {
+        size_t nBytes = _countedBytes + Memory::Pool::getDefault().getRetainedBytes();
+        for(size_t i = 0; i < _caches.size(); ++i)
+          nBytes += _caches[i]->getBytes();
+        return nBytes;
+      }
+
+      size_t MemoryBudget::getBytes() const
+      {
+        MultiThread::ScopedLock lock(_lock);
+        return getBytesLocked();
+      }
+
+      size_t MemoryBudget::getInstanceBytes(Instance *instance) const
+      {
+        MultiThread::ScopedLock lock(_lock);
+        std::map<Instance *, InstanceRecord>::const_iterator found = _instances.find(instance);
+        return found == _instances.end() ? 0 : found->second.nBytes;
+      }
+
+      bool MemoryBudget::reserve(Instance *instance, size_t nBytes)
+      {
+        size_t maxBytes;
+        {
+          MultiThread::ScopedLock lock(_lock);
+          maxBytes = _maxBytes;
+          if(maxBytes == 0 || getBytesLocked() + nBytes <= maxBytes) {
+            _instances[instance].nBytes += nBytes;
+            _countedBytes += nBytes;
+            return true;
+          }
+        }
+
+        // make room without holding the lock, as purging calls back into plugins
+        if(nBytes > maxBytes || !purge(maxBytes - nBytes))
+          return false;
+
+        MultiThread::ScopedLock lock(_lock);
+        _instances[instance].nBytes += nBytes;
+        _countedBytes += nBytes;
+        return true;
+      }
+
+      void MemoryBudget::release(Instance *instance, size_t nBytes)
+      {
+        MultiThread::ScopedLock lock(_lock);
+        std::map<Instance *, InstanceRecord>::iterator found = _instances.find(instance);
+        if(found == _instances.end())
+          return;
+        if(nBytes > found->second.nBytes)
+          nBytes = found->second.nBytes;
+        found->second.nBytes -= nBytes;
+        _countedBytes -= nBytes;
+      }
+
+      void MemoryBudget::trackMemory(Memory::Instance *memory, Instance *instance, size_t nBytes)
+      {
+        MultiThread::ScopedLock lock(_lock);
+        MemoryRecord &record = _memory[memory];
+        record.instance = instance;
+        record.nBytes = nBytes;
+      }
+
+      void MemoryBudget::releaseMemory(Memory::Instance *memory)
+      {
+        MemoryRecord record;
+        {
+          MultiThread::ScopedLock lock(_lock);
+          std::map<Memory::Instance *, MemoryRecord>::iterator found = _memory.find(memory);
+          if(found == _memory.end())
+            return;
+          record = found->second;
+          _memory.erase(found);
+        }
+        release(record.instance, record.nBytes);
+      }
+
+      void MemoryBudget::waitForPurge(Instance *instance)
+      {
+#     ifdef OFX_MEMORY_BUDGET_HAS_THREADS
+        for(;;) {
+          std::map<Instance *, InstanceRecord>::iterator found = _instances.find(instance);
+          if(found == _instances.end() || !found->second.purging)
+            return;
+          _purged.wait(_lock);
+        }
+#     else
+        (void)instance; // purges and renders can't overlap without threads
+#     endif
+      }
+
+      void MemoryBudget::renderStarted(Instance *instance)
+      {
+        MultiThread::ScopedLock lock(_lock);
+        waitForPurge(instance);
+        InstanceRecord &record = _instances[instance];
+        record.lastRender = ++_clock;
+        ++record.rendering;
+      }
+
+      void MemoryBudget::renderFinished(Instance *instance)
+      {
+        MultiThread::ScopedLock lock(_lock);
+        InstanceRecord &record = _instances[instance];
+        if(record.rendering > 0)
+          --record.rendering;
+      }
+
+      void MemoryBudget::removeInstance(Instance *instance)
+      {
+        MultiThread::ScopedLock lock(_lock);
+        waitForPurge(instance);
+        std::map<Instance *, InstanceRecord>::iterator found = _instances.find(instance);
+        if(found != _instances.end()) {
+          _countedBytes -= found->second.nBytes;
+          _instances.erase(found);
+        }
+
+        // its memory is no longer counted, but may still be freed through the suite
+        for(std::map<Memory::Instance *, MemoryRecord>::iterator it = _memory.begin(); it != _memory.end();) {
+          if(it->second.instance == instance)
+            _memory.erase(it++);
+          else
+            ++it;
+        }
+      }
+
+      void MemoryBudget::purgeInstance(Instance *instance)
+      {
+        // pin it, it may have started rendering, started purging on another thread or gone
+        // since it was picked
+        {
+          MultiThread::ScopedLock lock(_lock);
+          std::map<Instance *, InstanceRecord>::iterator found = _instances.find(instance);
+          if(found == _instances.end() || found->second.rendering > 0 || found->second.purging)
+            return;
+          found->second.purging = true;
+        }
+
+        try {
+          instance->purgeCachesAction();
+        }
+        catch(...) {}
+
+        MultiThread::ScopedLock lock(_lock);
+        std::map<Instance *, InstanceRecord>::iterator found = _instances.find(instance);
+        if(found != _instances.end())
+          found->second.purging = false;
+#     ifdef OFX_MEMORY_BUDGET_HAS_THREADS
+        _purged.notify_all();
+#     endif
+      }
+
+      bool MemoryBudget::purge(size_t nBytes)
+      {
+        size_t total = getBytes();
+        if(total <= nBytes)
+          return true;
+
+        // free blocks the pool is holding on to
+        Memory::Pool &pool = Memory::Pool::getDefault();
+        size_t excess = total - nBytes;
+        size_t retained = pool.getRetainedBytes();
+        pool.trim(retained > excess ? retained - excess : 0);
+
+        // then host caches
+        std::vector<ImageCache *> caches;
+        std::vector<std::pair<unsigned long, Instance *> > instances;
+        {
+          MultiThread::ScopedLock lock(_lock);
+          caches = _caches;
+          for(std::map<Instance *, InstanceRecord>::iterator it = _instances.begin(); it != _instances.end(); ++it) {
+            if(it->first && it->second.rendering == 0)
+              instances.push_back(std::make_pair(it->second.lastRender, it->first));
+          }
+        }
+
+        for(size_t i = 0; i < caches.size(); ++i) {
+          total = getBytes();
+          if(total <= nBytes)
+            return true;
+          excess = total - nBytes;
+          size_t cacheBytes = caches[i]->getBytes();
+          caches[i]->purge(cacheBytes > excess ? cacheBytes - excess : 0);
+        }
+
+        // then ask plugins to let go of their own caches, least recently rendered first
+        std::sort(instances.begin(), instances.end(), RenderedBefore());
+        for(size_t i = 0; i < instances.size(); ++i) {
+          if(getBytes() <= nBytes)
+            return true;
+          purgeInstance(instances[i].second);
+        }
+
+        return getBytes() <= nBytes;
+      }
+
+    } // namespace ImageEffect
+
+  } // namespace Host
+
+} // namespace OFX
@@ -0,0 +1,505 @@
+
+/*
+Software License :
+
+Copyright (c) 2007-2009, The Open Effects Association Ltd. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+* Neither the name The Open Effects Association Ltd, nor the names of its 
+contributors may be used to endorse or promote products derived from this
+software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// ofx
+#include "ofxCore.h"
+#include "ofxMultiThread.h"
+
+// ofx host
+#include "ofxhMultiThread.h"
+
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1900)
+#define OFX_HOST_HAS_THREADS
+#endif
+
+#ifdef OFX_HOST_HAS_THREADS
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#endif
+
+namespace OFX {
+
+  namespace Host {
+
+    namespace MultiThread {
+
+      /// what the calling thread is doing on behalf of the multithread suite
+      struct ThreadState {
+        bool         spawned; ///< is it running a function launched by ThreadPool::run
+        unsigned int index;   ///< index passed to that function
+        const void  *pool;    ///< the pool this thread is a worker of, if any
+        unsigned int worker;  ///< which worker of that pool it is
+      };
+
+#ifdef OFX_HOST_HAS_THREADS
+      static thread_local ThreadState gThreadState = { false, 0, 0, 0 };
+#else
+      // no threads, so no thread local storage needed
+      static ThreadState gThreadState = { false, 0, 0, 0 };
+#endif
+
+      /// sets the thread state for the duration of a call to a thread function
+      class ThreadStateGuard {
+        ThreadState _saved;
+      public:
+        ThreadStateGuard() : _saved(gThreadState) { gThreadState.spawned = true; }
+        ~ThreadStateGuard() { gThreadState = _saved; }
+        void setIndex(unsigned int index) { gThreadState.index = index; }
+      };
+
+      /// call all the thread functions one after the other on the calling thread
+      static OfxStatus runSerially(OfxThreadFunctionV1 func, unsigned int nThreads, void *customArg)
+      {
+        OfxStatus stat = kOfxStatOK;
+        ThreadStateGuard guard;
+        for(unsigned int i = 0; i < nThreads; ++i) {
+          guard.setIndex(i);
+          try {
+            func(i, nThreads, customArg);
+          }
+          catch(...) {
+            stat = kOfxStatFailed;
+          }
+        }
+        return stat;
+      }
+
+      unsigned int getNumHardwareThreads()
+      {
+#ifdef OFX_HOST_HAS_THREADS
+        unsigned int n = std::thread::hardware_concurrency();
+        return n > 0 ? n : 1;
+#else
+        return 1;
+#endif
+      }
+
+      bool ThreadPool::isSpawnedThread()
+      {
+        return gThreadState.spawned;
+      }
+
+      unsigned int ThreadPool::getThreadIndex()
+      {
+        return gThreadState.spawned ? gThreadState.index : 0;
+      }
+
+#ifdef OFX_HOST_HAS_THREADS
+
+      ////////////////////////////////////////////////////////////////////////////////
+      // thread pool
+
+      /// a single call to ThreadPool::run, shared by all the threads working on it
+      struct Job {
+        OfxThreadFunctionV1      *func;
+        void                     *customArg;
+        unsigned int              nThreads;
+        std::atomic<unsigned int> next;      ///< next index to be claimed
+        std::atomic<unsigned int> done;      ///< number of indices that have returned
+        std::atomic<bool>         failed;
+        bool                      nested;    ///< was it launched from one of the pool's own workers
+        std::mutex                mutex;
+        std::condition_variable   finished;
+
+        Job(OfxThreadFunctionV1 f, unsigned int n, void *arg)
+          : func(f), customArg(arg), nThreads(n), next(0), done(0), failed(false), nested(false)
+        {}
+
+        /// claim and run indices until there are none left, returns true if this
+        /// thread ran the last one to complete
+        bool work()
+        {
+          bool completed = false;
+          ThreadStateGuard guard;
+          for(;;) {
+            unsigned int i = next.fetch_add(1);
+            if(i >= nThreads)
+              break;
+            guard.setIndex(i);
+            try {
+              func(i, nThreads, customArg);
+            }
+            catch(...) {
+              failed = true;
+            }
+            if(done.fetch_add(1) + 1 == nThreads)
+              completed = true;
+          }
+          return completed;
+        }
+
+        bool isDone() const { return done.load() == nThreads; }
+
+        /// block until every index has returned
+        void wait()
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          while(!isDone())
+            finished.wait(lock);
+        }
+      };
+
+      typedef std::shared_ptr<Job> JobPtr;
+
+      /// the queue of work owned by a worker thread
+      struct WorkQueue {
+        std::mutex         mutex;
+        std::deque<JobPtr> jobs;
+      };
+
+      class ThreadPool::Implementation {
+      public:
+        unsigned int               _nThreads;
+        bool                       _started;
+        bool                       _quit;
+        std::vector<std::thread>   _workers;
+        std::vector<std::unique_ptr<WorkQueue> > _queues;
+        std::atomic<int>           _nQueued;   ///< jobs sitting in any of the queues
+        std::atomic<unsigned int>  _nextQueue; ///< round robin for jobs submitted from outside the pool
+        std::mutex                 _mutex;     ///< guards _started and _quit, and idle workers wait on it
+        std::condition_variable    _wake;
+
+        Implementation(unsigned int nThreads)
+          : _nThreads(nThreads)
+          , _started(false)
+          , _quit(false)
+          , _nQueued(0)
+          , _nextQueue(0)
+        {}
+
+        ~Implementation()
+        {
+          {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _quit = true;
+          }
+          _wake.notify_all();
+          for(size_t i = 0; i < _workers.size(); ++i)
+            _workers[i].join();
+        }
+
+        /// start the workers if they are not running yet
+        void start()
+        {
+          std::lock_guard<std::mutex> lock(_mutex);
+          if(_started)
+            return;
+          _started = true;
+          unsigned int nWorkers = _nThreads - 1;
+          for(unsigned int i = 0; i < nWorkers; ++i)
+            _queues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue));
+          for(unsigned int i = 0; i < nWorkers; ++i)
+            _workers.push_back(std::thread(&Implementation::workerMain, this, i));
+        }
+
+        /// put a job on the given worker's queue and wake someone up to do it
+        void push(unsigned int queue, const JobPtr &job)
+        {
+          {
+            WorkQueue &q = *_queues[queue];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            q.jobs.push_back(job);
+          }
+          ++_nQueued;
+          {
+            // make sure a worker about to sleep sees the new job
+            std::lock_guard<std::mutex> lock(_mutex);
+          }
+          _wake.notify_one();
+        }
+
+        /// pop from the back of our own queue, else steal from the front of someone else's
+        bool take(unsigned int self, JobPtr &job)
+        {
+          size_t nQueues = _queues.size();
+          for(size_t n = 0; n < nQueues; ++n) {
+            WorkQueue &q = *_queues[(self + n) % nQueues];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if(q.jobs.empty())
+              continue;
+            if(n == 0) {
+              job = q.jobs.back();
+              q.jobs.pop_back();
+            }
+            else {
+              job = q.jobs.front();
+              q.jobs.pop_front();
+            }
+            --_nQueued;
+            return true;
+          }
+          return false;
+        }
+
+        /// work on a job and wake whoever is waiting on it if we finish it off
+        void work(Job &job)
+        {
+          if(!job.work())
+            return;
+          {
+            std::lock_guard<std::mutex> lock(job.mutex);
+            job.finished.notify_all();
+          }
+          if(job.nested) {
+            // its owner is a worker, which waits alongside the idle ones
+            std::lock_guard<std::mutex> lock(_mutex);
+            _wake.notify_all();
+          }
+        }
+
+        /// wait for a job we launched from one of our workers, running other work meanwhile
+        void helpUntilDone(unsigned int self, Job &job)
+        {
+          while(!job.isDone()) {
+            JobPtr other;
+            if(take(self, other)) {
+              work(*other);
+              continue;
+            }
+            std::unique_lock<std::mutex> lock(_mutex);
+            while(!job.isDone() && _nQueued.load() <= 0)
+              _wake.wait(lock);
+          }
+        }
+
+        void workerMain(unsigned int self)
+        {
+          gThreadState.pool = this;
+          gThreadState.worker = self;
+          for(;;) {
+            JobPtr job;
+            if(take(self, job)) {
+              work(*job);
+              continue;
+            }
+            std::unique_lock<std::mutex> lock(_mutex);
+            while(!_quit && _nQueued.load() <= 0)
+              _wake.wait(lock);
+            if(_quit && _nQueued.load() <= 0)
+              return;
+          }
+        }
+
+        OfxStatus run(OfxThreadFunctionV1 func, unsigned int nThreads, void *customArg)
+        {
+          start();
+
+          JobPtr job(new Job(func, nThreads, customArg));
+          job->nested = gThreadState.pool == this;
+
+          // one entry per worker that can usefully join in, each one claims indices until they run out.
+          // Workers put nested jobs on their own queue, where they are taken first by the worker
+          // itself and stolen last by the others.
+          unsigned int nHelpers = nThreads - 1;
+          if(nHelpers > _queues.size())
+            nHelpers = (unsigned int) _queues.size();
+          for(unsigned int i = 0; i < nHelpers; ++i)
+            push(job->nested ? gThreadState.worker : _nextQueue.fetch_add(1) % _queues.size(), job);
+
+          // do our share, then wait for the workers to finish theirs
+          work(*job);
+          if(job->nested)
+            helpUntilDone(gThreadState.worker, *job);
+          else
+            job->wait();
+
+          return job->failed ? kOfxStatFailed : kOfxStatOK;
+        }
+      };
+
+      ThreadPool::ThreadPool(unsigned int nThreads)
+        : _imp(new Implementation(nThreads > 0 ? nThreads : getNumHardwareThreads()))
+      {
+      }
+
+      ThreadPool::~ThreadPool()
+      {
+        delete _imp;
+      }
+
+      unsigned int ThreadPool::getNumThreads() const
+      {
+        return _imp->_nThreads;
+      }
+
+      OfxStatus ThreadPool::run(OfxThreadFunctionV1 func, unsigned int nThreads, void *customArg)
+      {
+        if(!func)
+          return kOfxStatFailed;
+        if(nThreads == 0)
+          nThreads = getNumThreads();
+
+        if(nThreads == 1 || getNumThreads() == 1)
+          return runSerially(func, nThreads, customArg);
+
+        return _imp->run(func, nThreads, customArg);
+      }
+
+      ////////////////////////////////////////////////////////////////////////////////
+      // mutex
+
+      class Mutex::Implementation {
+      public:
+        std::mutex              _mutex;
+        std::condition_variable _released;
+        std::thread::id         _owner;
+        int                     _lockCount;
+
+        Implementation(int lockCount)
+          : _lockCount(lockCount > 0 ? lockCount : 0)
+        {
+          if(_lockCount > 0)
+            _owner = std::this_thread::get_id();
+        }
+      };
+
+      Mutex::Mutex(int lockCount)
+        : _imp(new Implementation(lockCount))
+      {
+      }
+
+      Mutex::~Mutex()
+      {
+        delete _imp;
+      }
+
+      void Mutex::lock()
+      {
+        std::thread::id me = std::this_thread::get_id();
+        std::unique_lock<std::mutex> lock(_imp->_mutex);
+        if(_imp->_lockCount > 0 && _imp->_owner == me) {
+          ++_imp->_lockCount;
+          return;
+        }
+        while(_imp->_lockCount > 0)
+          _imp->_released.wait(lock);
+        _imp->_owner = me;
+        _imp->_lockCount = 1;
+      }
+
+      bool Mutex::unlock()
+      {
+        std::lock_guard<std::mutex> lock(_imp->_mutex);
+        if(_imp->_lockCount <= 0 || _imp->_owner != std::this_thread::get_id())
+          return false;
+        if(--_imp->_lockCount == 0) {
+          _imp->_owner = std::thread::id();
+          _imp->_released.notify_one();
+        }
+        return true;
+      }
+
+      bool Mutex::tryLock()
+      {
+        std::thread::id me = std::this_thread::get_id();
+        std::lock_guard<std::mutex> lock(_imp->_mutex);
+        if(_imp->_lockCount > 0 && _imp->_owner != me)
+          return false;
+        _imp->_owner = me;
+        ++_imp->_lockCount;
+        return true;
+      }
+
+#else // !OFX_HOST_HAS_THREADS
+
+      ////////////////////////////////////////////////////////////////////////////////
+      // no threading support in this compiler, run everything serially
+
+      class ThreadPool::Implementation {
+      };
+
+      ThreadPool::ThreadPool(unsigned int /*nThreads*/)
+        : _imp(0)
+      {
+      }
+
+      ThreadPool::~ThreadPool()
+      {
+      }
+
+      unsigned int ThreadPool::getNumThreads() const
+      {
+        return 1;
+      }
+
+      OfxStatus ThreadPool::run(OfxThreadFunctionV1 func, unsigned int nThreads, void *customArg)
+      {
+        if(!func)
+          return kOfxStatFailed;
+        return runSerially(func, nThreads > 0 ? nThreads : 1, customArg);
+      }
+
+      class Mutex::Implementation {
+      public:
+        int _lockCount;
+      };
+
+      Mutex::Mutex(int lockCount)
+        : _imp(new Implementation)
+      {
+        _imp->_lockCount = lockCount > 0 ? lockCount : 0;
+      }
+
+      Mutex::~Mutex()
+      {
+        delete _imp;
+      }
+
+      void Mutex::lock()
+      {
+        ++_imp->_lockCount;
+      }
+
+      bool Mutex::unlock()
+      {
+        if(_imp->_lockCount <= 0)
+          return false;
+        --_imp->_lockCount;
+        return true;
+      }
+
+      bool Mutex::tryLock()
+      {
+        ++_imp->_lockCount;
+        return true;
+      }
+
+#endif // !OFX_HOST_HAS_THREADS
+
+    } // MultiThread
+
+  } // Host
+
+} // OFX
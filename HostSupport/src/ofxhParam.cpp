@@ -33,6 +33,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifdef OFX_SUPPORTS_PARAMETRIC
 #include "ofxParametricParam.h"
 #endif
+#include "ofxParameterBatch.h"
 #ifdef OFX_EXTENSIONS_NUKE
 #include "nuke/fnPublicOfxExtensions.h"
 #endif
@@ -68,6 +69,7 @@ namespace OFX {
         _paramType(type)
       {
         assert(_paramType.c_str());
+        _properties.setKind("param");
       }
 
       Base::Base(const std::string &name, const std::string &type, const Property::Set &properties) :
@@ -76,6 +78,7 @@ namespace OFX {
         _properties(properties)
       {
         assert(_paramType.c_str());
+        _properties.setKind("param");
       }
 
 
@@ -772,6 +775,12 @@ namespace OFX {
         return kOfxStatErrUnsupported;
       }
 
+      /// get the values as doubles, for the parameter batch suite
+      OfxStatus Instance::getValuesAtTime(OfxTime /*time*/, double * /*values*/, int /*count*/)
+      {
+        return kOfxStatErrUnsupported;
+      }
+
       /// set a value, implemented by instances to deconstruct var args
       OfxStatus Instance::setV(va_list /*arg*/)
       {
@@ -976,6 +985,20 @@ namespace OFX {
 #       endif
         return stat;
       }
+
+      /// get the values as doubles, for the parameter batch suite
+      OfxStatus ChoiceInstance::getValuesAtTime(OfxTime time, double *values, int count)
+      {
+        if ( OFX::IsNaN(time) || count != 1 ) {
+          return kOfxStatErrValue;
+        }
+        int v;
+        OfxStatus stat = get(time, v);
+        if (stat == kOfxStatOK) {
+          values[0] = v;
+        }
+        return stat;
+      }
       
       /// implementation of var args function
       OfxStatus ChoiceInstance::setV(va_list arg)
@@ -1054,6 +1077,20 @@ namespace OFX {
 #       endif
         return stat;
       }
+
+      /// get the values as doubles, for the parameter batch suite
+      OfxStatus IntegerInstance::getValuesAtTime(OfxTime time, double *values, int count)
+      {
+        if ( OFX::IsNaN(time) || count != 1 ) {
+          return kOfxStatErrValue;
+        }
+        int v;
+        OfxStatus stat = get(time, v);
+        if (stat == kOfxStatOK) {
+          values[0] = v;
+        }
+        return stat;
+      }
       
       /// implementation of var args function
       OfxStatus IntegerInstance::setV(va_list arg)
@@ -1138,6 +1175,15 @@ namespace OFX {
 #       endif
         return stat;
       }
+
+      /// get the values as doubles, for the parameter batch suite
+      OfxStatus DoubleInstance::getValuesAtTime(OfxTime time, double *values, int count)
+      {
+        if ( OFX::IsNaN(time) || count != 1 ) {
+          return kOfxStatErrValue;
+        }
+        return get(time, values[0]);
+      }
       
       /// implementation of var args function
       OfxStatus DoubleInstance::setV(va_list arg)
@@ -1231,6 +1277,20 @@ namespace OFX {
 #       endif
         return stat;
       }
+
+      /// get the values as doubles, for the parameter batch suite
+      OfxStatus BooleanInstance::getValuesAtTime(OfxTime time, double *values, int count)
+      {
+        if ( OFX::IsNaN(time) || count != 1 ) {
+          return kOfxStatErrValue;
+        }
+        bool v;
+        OfxStatus stat = get(time, v);
+        if (stat == kOfxStatOK) {
+          values[0] = v ? 1. : 0.;
+        }
+        return stat;
+      }
       
       /// implementation of var args function
       OfxStatus BooleanInstance::setV(va_list arg)
@@ -1302,6 +1362,15 @@ namespace OFX {
 #       endif
         return stat;
       }
+
+      /// get the values as doubles, for the parameter batch suite
+      OfxStatus RGBAInstance::getValuesAtTime(OfxTime time, double *values, int count)
+      {
+        if ( OFX::IsNaN(time) || count != 4 ) {
+          return kOfxStatErrValue;
+        }
+        return get(time, values[0], values[1], values[2], values[3]);
+      }
       
       /// implementation of var args function
       OfxStatus RGBAInstance::setV(va_list arg)
@@ -1413,6 +1482,15 @@ namespace OFX {
 #       endif
         return stat;
       }
+
+      /// get the values as doubles, for the parameter batch suite
+      OfxStatus RGBInstance::getValuesAtTime(OfxTime time, double *values, int count)
+      {
+        if ( OFX::IsNaN(time) || count != 3 ) {
+          return kOfxStatErrValue;
+        }
+        return get(time, values[0], values[1], values[2]);
+      }
       
       /// implementation of var args function
       OfxStatus RGBInstance::setV(va_list arg)
@@ -1518,6 +1596,15 @@ namespace OFX {
 #       endif
         return stat;
       }
+
+      /// get the values as doubles, for the parameter batch suite
+      OfxStatus Double2DInstance::getValuesAtTime(OfxTime time, double *values, int count)
+      {
+        if ( OFX::IsNaN(time) || count != 2 ) {
+          return kOfxStatErrValue;
+        }
+        return get(time, values[0], values[1]);
+      }
       
       /// implementation of var args function
       OfxStatus Double2DInstance::setV(va_list arg)
@@ -1619,6 +1706,21 @@ namespace OFX {
 #       endif
         return stat;
       }
+
+      /// get the values as doubles, for the parameter batch suite
+      OfxStatus Integer2DInstance::getValuesAtTime(OfxTime time, double *values, int count)
+      {
+        if ( OFX::IsNaN(time) || count != 2 ) {
+          return kOfxStatErrValue;
+        }
+        int x, y;
+        OfxStatus stat = get(time, x, y);
+        if (stat == kOfxStatOK) {
+          values[0] = x;
+          values[1] = y;
+        }
+        return stat;
+      }
       
       /// implementation of var args function
       OfxStatus Integer2DInstance::setV(va_list arg)
@@ -1722,6 +1824,15 @@ namespace OFX {
 #       endif
         return stat;
       }
+
+      /// get the values as doubles, for the parameter batch suite
+      OfxStatus Double3DInstance::getValuesAtTime(OfxTime time, double *values, int count)
+      {
+        if ( OFX::IsNaN(time) || count != 3 ) {
+          return kOfxStatErrValue;
+        }
+        return get(time, values[0], values[1], values[2]);
+      }
       
       /// implementation of var args function
       OfxStatus Double3DInstance::setV(va_list arg)
@@ -1828,6 +1939,22 @@ namespace OFX {
 #       endif
         return stat;
       }
+
+      /// get the values as doubles, for the parameter batch suite
+      OfxStatus Integer3DInstance::getValuesAtTime(OfxTime time, double *values, int count)
+      {
+        if ( OFX::IsNaN(time) || count != 3 ) {
+          return kOfxStatErrValue;
+        }
+        int x, y, z;
+        OfxStatus stat = get(time, x, y, z);
+        if (stat == kOfxStatOK) {
+          values[0] = x;
+          values[1] = y;
+          values[2] = z;
+        }
+        return stat;
+      }
       
       /// implementation of var args function
       OfxStatus Integer3DInstance::setV(va_list arg)
@@ -1956,12 +2083,16 @@ namespace OFX {
       /// ctor
       SetInstance::SetInstance()
       : _ownsParams(true)
+      , _staticHash(0)
+      , _hashValid(false)
       {}
 
       SetInstance::SetInstance(const SetInstance& other)
       : _params(other._params)
       , _paramList(other._paramList)
       , _ownsParams(false)
+      , _staticHash(0)
+      , _hashValid(false)
       {
 
       }
@@ -2010,6 +2141,158 @@ namespace OFX {
         return kOfxStatOK;
       }
 
+      /// hash a double, so that 0 and -0 hash the same
+      static unsigned long long hashDouble(double v, unsigned long long hash)
+      {
+        if(v == 0.)
+          v = 0.;
+        return HashBytes(&v, sizeof(v), hash);
+      }
+
+      static unsigned long long hashInt(int v, unsigned long long hash)
+      {
+        return HashBytes(&v, sizeof(v), hash);
+      }
+
+      bool SetInstance::computeParamHash(Instance *param, OfxTime time, unsigned long long &hash, bool &timeVarying)
+      {
+        hash = kHashSeed;
+        timeVarying = false;
+
+        // params with no value
+        if(dynamic_cast<GroupInstance*>(param) || dynamic_cast<PageInstance*>(param) || dynamic_cast<PushbuttonInstance*>(param))
+          return true;
+
+        // if the host can't tell us about keys, assume the worst
+        KeyframeParam *keyframes = dynamic_cast<KeyframeParam*>(param);
+        unsigned int nKeys = 0;
+        timeVarying = !keyframes || keyframes->getNumKeys(nKeys) != kOfxStatOK || nKeys > 0;
+
+        OfxStatus stat = kOfxStatFailed;
+        if(IntegerInstance *p = dynamic_cast<IntegerInstance*>(param)) {
+          int v = 0;
+          stat = p->get(time, v);
+          hash = hashInt(v, hash);
+        }
+        else if(ChoiceInstance *p = dynamic_cast<ChoiceInstance*>(param)) {
+          int v = 0;
+          stat = p->get(time, v);
+          hash = hashInt(v, hash);
+        }
+        else if(BooleanInstance *p = dynamic_cast<BooleanInstance*>(param)) {
+          bool v = false;
+          stat = p->get(time, v);
+          hash = hashInt(v ? 1 : 0, hash);
+        }
+        else if(DoubleInstance *p = dynamic_cast<DoubleInstance*>(param)) {
+          double v = 0.;
+          stat = p->get(time, v);
+          hash = hashDouble(v, hash);
+        }
+        else if(RGBAInstance *p = dynamic_cast<RGBAInstance*>(param)) {
+          double r = 0., g = 0., b = 0., a = 0.;
+          stat = p->get(time, r, g, b, a);
+          hash = hashDouble(a, hashDouble(b, hashDouble(g, hashDouble(r, hash))));
+        }
+        else if(RGBInstance *p = dynamic_cast<RGBInstance*>(param)) {
+          double r = 0., g = 0., b = 0.;
+          stat = p->get(time, r, g, b);
+          hash = hashDouble(b, hashDouble(g, hashDouble(r, hash)));
+        }
+        else if(Double2DInstance *p = dynamic_cast<Double2DInstance*>(param)) {
+          double x = 0., y = 0.;
+          stat = p->get(time, x, y);
+          hash = hashDouble(y, hashDouble(x, hash));
+        }
+        else if(Integer2DInstance *p = dynamic_cast<Integer2DInstance*>(param)) {
+          int x = 0, y = 0;
+          stat = p->get(time, x, y);
+          hash = hashInt(y, hashInt(x, hash));
+        }
+        else if(Double3DInstance *p = dynamic_cast<Double3DInstance*>(param)) {
+          double x = 0., y = 0., z = 0.;
+          stat = p->get(time, x, y, z);
+          hash = hashDouble(z, hashDouble(y, hashDouble(x, hash)));
+        }
+        else if(Integer3DInstance *p = dynamic_cast<Integer3DInstance*>(param)) {
+          int x = 0, y = 0, z = 0;
+          stat = p->get(time, x, y, z);
+          hash = hashInt(z, hashInt(y, hashInt(x, hash)));
+        }
+        else if(StringInstance *p = dynamic_cast<StringInstance*>(param)) {
+          std::string v;
+          stat = p->get(time, v);
+          hash = HashBytes(v.data(), v.size(), hash);
+        }
+
+        if(stat != kOfxStatOK) {
+          // fall back on the change count, which doesn't vary with time
+          timeVarying = false;
+          return false;
+        }
+        return true;
+      }
+
+      SetInstance::ParamHash &SetInstance::getParamHashEntry(Instance *param, OfxTime time)
+      {
+        ParamHash &entry = _paramHashes[param];
+        if(!entry.valid) {
+          if(!computeParamHash(param, time, entry.hash, entry.timeVarying))
+            entry.hash = hashInt(int(entry.serial), kHashSeed);
+          entry.valid = true;
+        }
+        return entry;
+      }
+
+      void SetInstance::paramValueChanged(Instance *param)
+      {
+        MultiThread::ScopedLock lock(_hashLock);
+        ParamHash &entry = _paramHashes[param];
+        entry.valid = false;
+        ++entry.serial;
+        _hashValid = false;
+      }
+
+      unsigned long long SetInstance::getParamHash(Instance *param, OfxTime time)
+      {
+        MultiThread::ScopedLock lock(_hashLock);
+        ParamHash &entry = getParamHashEntry(param, time);
+        if(!entry.timeVarying)
+          return entry.hash;
+
+        unsigned long long hash;
+        bool timeVarying;
+        computeParamHash(param, time, hash, timeVarying);
+        return hash;
+      }
+
+      unsigned long long SetInstance::getHash(OfxTime time)
+      {
+        MultiThread::ScopedLock lock(_hashLock);
+
+        if(!_hashValid) {
+          _staticHash = kHashSeed;
+          _timeVaryingParams.clear();
+          for(std::list<Instance *>::iterator it = _paramList.begin(); it != _paramList.end(); ++it) {
+            ParamHash &entry = getParamHashEntry(*it, time);
+            if(entry.timeVarying)
+              _timeVaryingParams.push_back(*it);
+            else
+              _staticHash = HashBytes(&entry.hash, sizeof(entry.hash), _staticHash);
+          }
+          _hashValid = true;
+        }
+
+        unsigned long long hash = _staticHash;
+        for(std::vector<Instance *>::iterator it = _timeVaryingParams.begin(); it != _timeVaryingParams.end(); ++it) {
+          unsigned long long paramHash;
+          bool timeVarying;
+          computeParamHash(*it, time, paramHash, timeVarying);
+          hash = HashBytes(&paramHash, sizeof(paramHash), hash);
+        }
+        return hash;
+      }
+
       ////////////////////////////////////////////////////////////////////////////////
       // Suite functions below
 
@@ -2364,7 +2647,8 @@ namespace OFX {
 
         va_end(ap);
 
-        if (stat == kOfxStatOK) {
+        if (stat == kOfxStatOK && paramInstance->getParamSetInstance()) {
+          paramInstance->getParamSetInstance()->paramValueChanged(paramInstance);
           paramInstance->getParamSetInstance()->paramChangedByPlugin(paramInstance);
         }
 
@@ -2405,7 +2689,8 @@ namespace OFX {
 
         va_end(ap);
 
-        if (stat == kOfxStatOK) {
+        if (stat == kOfxStatOK && paramInstance->getParamSetInstance()) {
+          paramInstance->getParamSetInstance()->paramValueChanged(paramInstance);
           paramInstance->getParamSetInstance()->paramChangedByPlugin(paramInstance);
         }
 
@@ -2537,6 +2822,9 @@ namespace OFX {
           return kOfxStatErrBadHandle;
         }
         OfxStatus stat = paramInstance->deleteKey(time);
+        if (stat == kOfxStatOK && pInstance->getParamSetInstance()) {
+          pInstance->getParamSetInstance()->paramValueChanged(pInstance);
+        }
 #       ifdef OFX_DEBUG_PARAMETERS
         std::cout << ' ' << StatStr(stat) << std::endl;
 #       endif
@@ -2565,6 +2853,9 @@ namespace OFX {
           return kOfxStatErrBadHandle;
         }
         OfxStatus stat = paramInstance->deleteAllKeys();
+        if (stat == kOfxStatOK && pInstance->getParamSetInstance()) {
+          pInstance->getParamSetInstance()->paramValueChanged(pInstance);
+        }
 #       ifdef OFX_DEBUG_PARAMETERS
         std::cout << ' ' << StatStr(stat) << std::endl;
 #       endif
@@ -2590,6 +2881,9 @@ namespace OFX {
         }
 
         OfxStatus stat = paramInstanceTo->copyFrom(*paramInstanceFrom,dstOffset,frameRange);
+        if (stat == kOfxStatOK && paramInstanceTo->getParamSetInstance()) {
+          paramInstanceTo->getParamSetInstance()->paramValueChanged(paramInstanceTo);
+        }
 #       ifdef OFX_DEBUG_PARAMETERS
         std::cout << ' ' << StatStr(stat) << std::endl;
 #       endif
@@ -2662,6 +2956,52 @@ namespace OFX {
         return NULL;
       }
 
+      /// get the values of many parameters at the same time in one call, see ofxParameterBatch.h
+      static OfxStatus paramGetValueBatchAtTime(OfxTime time,
+                                                OfxParameterBatchEntry *entries,
+                                                int count)
+      {
+        if ( OFX::IsNaN(time) ) {
+          return kOfxStatErrValue;
+        }
+#       ifdef OFX_DEBUG_PARAMETERS
+        std::cout << "OFX: paramGetValueBatchAtTime - " << time << ' ' << count << " ...";
+#       endif
+        OfxStatus stat = kOfxStatOK;
+        for (int i = 0; i < count; ++i) {
+          OfxParameterBatchEntry &entry = entries[i];
+          Instance *paramInstance = reinterpret_cast<Instance*>(entry.param);
+          if(!paramInstance || !paramInstance->verifyMagic()) {
+            entry.status = kOfxStatErrBadHandle;
+          } else if (!entry.values) {
+            entry.status = kOfxStatErrValue;
+          } else {
+            entry.status = kOfxStatErrUnsupported;
+            try {
+              entry.status = paramInstance->getValuesAtTime(time, entry.values, entry.count);
+            }
+            catch(...) {}
+          }
+          if (entry.status != kOfxStatOK) {
+            stat = kOfxStatFailed;
+          }
+        }
+#       ifdef OFX_DEBUG_PARAMETERS
+        std::cout << ' ' << StatStr(stat) << std::endl;
+#       endif
+        return stat;
+      }
+
+      static const OfxParameterBatchSuiteV1 gParamBatchSuiteV1 = {
+        paramGetValueBatchAtTime
+      };
+
+      const void *GetBatchSuite(int version) {
+        if(version ==1)
+          return &gParamBatchSuiteV1;
+        return NULL;
+      }
+
     } // Param
 
   } // Host
@@ -29,6 +29,7 @@
 
 #include <assert.h>
 
+#include <algorithm>
 #include <map>
 #include <string>
 #include <iostream>
@@ -47,8 +48,10 @@
 
 // ofx host
 #include "ofxhBinary.h"
+#include "ofxhBinaryCache.h"
 #include "ofxhPropertySuite.h"
 #include "ofxhMemory.h"
+#include "ofxhMultiThread.h"
 #include "ofxhPluginAPICache.h"
 #include "ofxhPluginCache.h"
 #include "ofxhHost.h"
@@ -60,6 +63,11 @@
 #define DIRLIST_SEP_CHARS ":;"
 #define DIRSEP "/"
 #include <dirent.h>
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <fcntl.h>
+#endif
 
 static const char *getArchStr() 
 {
@@ -104,6 +112,17 @@ static const char *getArchStr()
 #include "shlobj.h"
 #endif
 
+#if defined(UNIX)
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/wait.h>
+
+extern char **environ;
+#endif
+
 
 bool OFX::Host::PluginCache::_useStdOFXPluginsLocation = true;
 OFX::Host::PluginCache* OFX::Host::PluginCache::gPluginCachePtr = 0;
@@ -120,6 +139,8 @@ void PluginBinary::loadPluginInfo(PluginCache *cache) {
     return;
   }
 
+  double start = OFX::GetTimeInSeconds();
+
   if (_binary) {
     _fileModificationTime = _binary->getTime();
     _fileSize = _binary->getSize();
@@ -129,6 +150,12 @@ void PluginBinary::loadPluginInfo(PluginCache *cache) {
     // This avoid lots of useless calls to dlopen()/dlclose().
     if (!_binary->isLoaded()) {
       _binary->ref();
+      _holdsBinary = true;
+      cache->recordLoadTiming(_bundlePath, "", "binaryLoad", _binary->getLoadTime());
+    }
+
+    if (cache->getContentHashing() && !Binary::getFileContentHash(_filePath, _contentHash)) {
+      _contentHash.clear();
     }
   }
 
@@ -158,6 +185,8 @@ void PluginBinary::loadPluginInfo(PluginCache *cache) {
       _plugins.push_back(api->newPlugin(this, i, plug));
     }
   }
+
+  cache->recordLoadTiming(_bundlePath, "", "loadPluginInfo", OFX::GetTimeInSeconds() - start);
 }
 
 PluginBinary::~PluginBinary() {
@@ -170,14 +199,44 @@ PluginBinary::~PluginBinary() {
   }
   // release the last reference to the binary, which should unload it
   // if this reference was taken by loadPluginInfo().
+  releaseBinary();
   if (_binary) {
-    if (_binary->isLoaded()) {
-      _binary->unref();
-    }
     assert(!_binary->isLoaded());
   }
 }
 
+void PluginBinary::releaseBinary() {
+  if (_binary && _holdsBinary) {
+    _binary->unref();
+  }
+  _holdsBinary = false;
+}
+
+bool PluginBinary::checkForChanges(bool useContentHash) {
+  if (!_binary) {
+    // statically linked plugins go with the host application, they are checked when it starts
+    return _binaryChanged;
+  }
+
+  time_t mtime;
+  off_t size;
+  if (!Binary::getFileModTimeAndSize(_filePath, mtime, size)) {
+    _binaryChanged = true;
+  } else if (mtime == _fileModificationTime && size == _fileSize) {
+    _binaryChanged = false;
+  } else {
+    _binaryChanged = true;
+    std::string hash;
+    if (useContentHash && !_contentHash.empty() && size == _fileSize &&
+        Binary::getFileContentHash(_filePath, hash) && hash == _contentHash) {
+      // only touched, eg by a deployment copying over it
+      _fileModificationTime = mtime;
+      _binaryChanged = false;
+    }
+  }
+  return _binaryChanged;
+}
+
 PluginHandle::PluginHandle(Plugin *p, OFX::Host::Host *host)
 {
   _b = p->getBinary();
@@ -262,10 +321,19 @@ void PluginCache::clearPluginCache()
 
 PluginCache::~PluginCache()
 {
+  stopWatching();
   for(std::list<PluginBinary *>::iterator it=_binaries.begin(); it != _binaries.end(); ++it) {
     delete (*it);
   }
   _binaries.clear();
+  for(std::list<PluginBinary *>::iterator it=_retiredBinaries.begin(); it != _retiredBinaries.end(); ++it) {
+    delete (*it);
+  }
+  _retiredBinaries.clear();
+  for(std::list<BinaryCache::Reader *>::iterator it=_binaryCaches.begin(); it != _binaryCaches.end(); ++it) {
+    delete (*it);
+  }
+  _binaryCaches.clear();
 }
 
 PluginCache::PluginCache()
@@ -275,6 +343,11 @@ PluginCache::PluginCache()
 #endif
 , _xmlCurrentBinary(NULL)
 , _xmlCurrentPlugin(NULL)
+, _discoveryThreads(1)
+, _describeWorkers(0)
+, _scanTime(0)
+, _contentHashing(false)
+, _watchHandle(-1)
 {
   _cacheVersion = "";
   _ignoreCache = false;
@@ -337,7 +410,7 @@ void PluginCache::setPluginHostPath(const std::string &hostId) {
 #endif
 }
 
-void PluginCache::scanDirectory(std::set<std::string> &foundBinFiles, const std::string &dir, bool recurse)
+void PluginCache::scanDirectory(std::vector<FoundBundle> &bundles, std::list<std::string> &dirs, const std::string &dir, bool recurse) const
 {
 #ifdef CACHE_DEBUG
   printf("looking in %s for plugins\n", dir.c_str());
@@ -353,7 +426,7 @@ void PluginCache::scanDirectory(std::set<std::string> &foundBinFiles, const std:
   }
 #endif
   
-  _pluginDirs.push_back(dir.c_str());
+  dirs.push_back(dir.c_str());
   
 #if defined (UNIX)
   while (dirent *de = readdir(d))
@@ -382,12 +455,9 @@ void PluginCache::scanDirectory(std::set<std::string> &foundBinFiles, const std:
 #endif
       if (name.find(".ofx.bundle") != std::string::npos) {
         std::string barename = name.substr(0, name.length() - strlen(".bundle"));
-        std::string bundlename = dir + DIRSEP + name;
-        std::string binpath = dir + DIRSEP + name + DIRSEP "Contents" DIRSEP + ARCHSTR + DIRSEP + barename;
-          
-        // don't insert binpath yet, do it later because of Mac OS X Universal stuff
-        //foundBinFiles.insert(binpath);
-
+        FoundBundle bundle;
+        bundle.bundlePath = dir + DIRSEP + name;
+        bundle.binPath = dir + DIRSEP + name + DIRSEP "Contents" DIRSEP + ARCHSTR + DIRSEP + barename;
 #if defined(__APPLE__) && (defined(__x86_64) || defined(__x86_64__))
         /* From the OpenFX specification:
            
@@ -397,54 +467,12 @@ void PluginCache::scanDirectory(std::set<std::string> &foundBinFiles, const std:
            exist or is empty, fall back to "MacOS" looking for a
            universal binary.
         */
-          
-        std::string binpath_universal = dir + DIRSEP + name + DIRSEP "Contents" DIRSEP + "MacOS" + DIRSEP + barename;
-        if (_knownBinFiles.find(binpath_universal) != _knownBinFiles.end()) {
-          binpath = binpath_universal;
-        }
-#endif
-
-        if (_knownBinFiles.find(binpath) == _knownBinFiles.end()) {
-#ifdef CACHE_DEBUG
-          printf("found non-cached binary %s\n", binpath.c_str());
-#endif
-          _dirty = true;
-
-          // the binary was not in the cache
-          
-          PluginBinary *pb = 0;
-#if defined(__x86_64) || defined(__x86_64__)
-          pb = new PluginBinary(binpath, bundlename, this);
-#  if defined(__APPLE__)
-          if (pb->isInvalid()) {
-            // fallback to "MacOS"
-            delete pb;
-            binpath = binpath_universal;
-            pb = new PluginBinary(binpath, bundlename, this);
-          }
-#  endif
-#else
-          pb = new PluginBinary(binpath, bundlename, this);
+        bundle.universalBinPath = dir + DIRSEP + name + DIRSEP "Contents" DIRSEP + "MacOS" + DIRSEP + barename;
 #endif
-          _binaries.push_back(pb);
-          _knownBinFiles.insert(binpath);
-          foundBinFiles.insert(binpath);
-
-          for (int j=0;j<pb->getNPlugins();j++) {
-            Plugin *plug = &pb->getPlugin(j);
-            const APICache::PluginAPICacheI &api = plug->getApiHandler();
-            api.loadFromPlugin(plug);
-          }
-        } else {
-#ifdef CACHE_DEBUG
-          printf("found cached binary %s\n", binpath.c_str());
-#endif
-        }
-        // insert final path (universal or not) in the list of found files
-        foundBinFiles.insert(binpath);
+        bundles.push_back(bundle);
       } else {
         if (isdir && (recurse && !name.empty() && name[0] != '@' && name[name.size() - 1] != '.')) {
-          scanDirectory(foundBinFiles, dir + DIRSEP + name, recurse);
+          scanDirectory(bundles, dirs, dir + DIRSEP + name, recurse);
         }
       }
 #if defined(WINDOWS)
@@ -463,6 +491,420 @@ void PluginCache::scanDirectory(std::set<std::string> &foundBinFiles, const std:
 #endif
 }
 
+/// what the discovery threads in scanPluginFiles() share, each item is
+/// handed to exactly one thread
+struct DiscoveryWork {
+  PluginCache              *cache;
+  size_t                    nItems;
+  size_t                    nextItem;
+  MultiThread::Mutex        lock;
+
+  DiscoveryWork(PluginCache *c, size_t n) : cache(c), nItems(n), nextItem(0) {}
+
+  /// claim the next item, false if there are none left
+  bool next(size_t &item)
+  {
+    MultiThread::ScopedLock guard(lock);
+    if (nextItem >= nItems) {
+      return false;
+    }
+    item = nextItem++;
+    return true;
+  }
+};
+
+/// a directory on the plugin path, and what was found in it
+struct DiscoveryRoot {
+  std::string                           path;
+  bool                                  recurse;
+  std::vector<PluginCache::FoundBundle> bundles;
+  std::list<std::string>                dirs;
+};
+
+struct ScanDirectoryWork : public DiscoveryWork {
+  std::vector<DiscoveryRoot> &roots;
+  ScanDirectoryWork(PluginCache *c, std::vector<DiscoveryRoot> &r) : DiscoveryWork(c, r.size()), roots(r) {}
+};
+
+void PluginCache::scanDirectoryThread(unsigned int /*threadIndex*/, unsigned int /*threadMax*/, void *arg)
+{
+  ScanDirectoryWork *work = static_cast<ScanDirectoryWork *>(arg);
+  size_t i;
+  while (work->next(i)) {
+    DiscoveryRoot &root = work->roots[i];
+    work->cache->scanDirectory(root.bundles, root.dirs, root.path, root.recurse);
+  }
+}
+
+/// a binary to load and describe the plugins of
+struct DiscoveryBinary {
+  PluginBinary *binary;           ///< the binary to reload, or NULL to make a new one from the paths
+  std::string   binPath;
+  std::string   universalBinPath;
+  std::string   bundlePath;
+  std::string   described;        ///< the binary cache a describe worker sent back, empty if it failed
+
+  DiscoveryBinary() : binary(0) {}
+};
+
+struct LoadBinaryWork : public DiscoveryWork {
+  std::vector<DiscoveryBinary> &binaries;
+  LoadBinaryWork(PluginCache *c, std::vector<DiscoveryBinary> &b) : DiscoveryWork(c, b.size()), binaries(b) {}
+};
+
+void PluginCache::loadBinaryThread(unsigned int /*threadIndex*/, unsigned int /*threadMax*/, void *arg)
+{
+  LoadBinaryWork *work = static_cast<LoadBinaryWork *>(arg);
+  size_t i;
+  while (work->next(i)) {
+    DiscoveryBinary &job = work->binaries[i];
+    try {
+      if (job.binary) {
+        job.binary->loadPluginInfo(work->cache);
+      }
+      else {
+        job.binary = new PluginBinary(job.binPath, job.bundlePath, work->cache);
+#if defined(__APPLE__) && (defined(__x86_64) || defined(__x86_64__))
+        if (job.binary->isInvalid()) {
+          // fallback to "MacOS"
+          delete job.binary;
+          job.binary = 0;
+          job.binPath = job.universalBinPath;
+          job.binary = new PluginBinary(job.binPath, job.bundlePath, work->cache);
+        }
+#endif
+      }
+
+      for (int j=0;j<job.binary->getNPlugins();j++) {
+        Plugin *plug = &job.binary->getPlugin(j);
+        const APICache::PluginAPICacheI &api = plug->getApiHandler();
+        api.loadFromPlugin(plug);
+      }
+    }
+    catch (...) {
+      std::cerr << "exception while loading plugin binary " << job.binPath << std::endl;
+    }
+  }
+}
+
+#if defined(UNIX)
+/// what starts the command line of a describe worker, see PluginCache::runDescribeWorker()
+static const char *kDescribeWorkerArg = "--ofx-describe-worker";
+
+/// the descriptor a describe worker sends the binary cache back down
+static const int kDescribeWorkerFd = 3;
+
+/// what a describe worker process does, load and describe a binary, and return it in the binary cache format
+static std::string describeBinary(PluginCache *cache, const DiscoveryBinary &job, const std::string &cacheVersion)
+{
+  // not deleted, the worker exits as soon as this has been sent back
+  PluginBinary *pb = new PluginBinary(job.binPath, job.bundlePath, cache);
+#if defined(__APPLE__) && (defined(__x86_64) || defined(__x86_64__))
+  if (pb->isInvalid() && !job.universalBinPath.empty()) {
+    // fallback to "MacOS"
+    pb = new PluginBinary(job.universalBinPath, job.bundlePath, cache);
+  }
+#endif
+
+  BinaryCache::Writer writer(cacheVersion);
+  writer.addBinary(pb->getFilePath(), pb->getBundlePath(), pb->getFileModificationTime(), pb->getFileSize(),
+                   false, pb->getContentHash());
+  for (int j=0;j<pb->getNPlugins();j++) {
+    Plugin *plug = &pb->getPlugin(j);
+    const APICache::PluginAPICacheI &api = plug->getApiHandler();
+    api.loadFromPlugin(plug);
+    writer.addPlugin(plug->getRawIdentifier(), plug->getPluginApi(), plug->getIndex(),
+                     plug->getApiVersion(), plug->getVersionMajor(), plug->getVersionMinor());
+    api.saveBinary(plug, writer);
+  }
+
+  std::ostringstream os;
+  writer.write(os);
+  return os.str();
+}
+
+/// write all of data to fd, false if that couldn't be done
+static bool writeAll(int fd, const std::string &data)
+{
+  const char *bytes = data.data();
+  size_t left = data.size();
+  while (left > 0) {
+    ssize_t n = write(fd, bytes, left);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    bytes += n;
+    left -= size_t(n);
+  }
+  return true;
+}
+
+/// what a describe worker sends back before the binary cache, the load timings it took
+static std::string writeWorkerTimings(const std::vector<PluginCache::LoadTiming> &timings)
+{
+  std::ostringstream os;
+  os.precision(17);
+  os << timings.size() << '\n';
+  for (std::vector<PluginCache::LoadTiming>::const_iterator it = timings.begin(); it != timings.end(); ++it) {
+    os << it->seconds << ' ' << it->pluginId.size() << ' ' << it->pluginId << ' '
+       << it->step.size() << ' ' << it->step << '\n';
+  }
+  return os.str();
+}
+
+/// read a string of the given length, as writeWorkerTimings() puts them
+static bool readCountedString(std::istream &is, std::string &str)
+{
+  size_t size;
+  if (!(is >> size) || is.get() != ' ' || size > 4096) {
+    return false;
+  }
+  str.resize(size);
+  return size == 0 || is.read(&str[0], std::streamsize(size));
+}
+
+/// Take the load timings off the front of what a describe worker sent back and record them
+/// against bundlePath, leaving the binary cache in data. False if it is garbled.
+static bool readWorkerTimings(PluginCache *cache, const std::string &bundlePath, std::string &data)
+{
+  std::istringstream is(data);
+  size_t nTimings;
+  if (!(is >> nTimings) || is.get() != '\n') {
+    return false;
+  }
+  std::vector<PluginCache::LoadTiming> timings;
+  for (size_t i = 0; i < nTimings; ++i) {
+    PluginCache::LoadTiming timing;
+    if (!(is >> timing.seconds) || is.get() != ' ' ||
+        !readCountedString(is, timing.pluginId) || is.get() != ' ' ||
+        !readCountedString(is, timing.step) || is.get() != '\n') {
+      return false;
+    }
+    timings.push_back(timing);
+  }
+
+  for (size_t i = 0; i < timings.size(); ++i) {
+    cache->recordLoadTiming(bundlePath, timings[i].pluginId, timings[i].step, timings[i].seconds);
+  }
+  data.erase(0, size_t(is.tellg()));
+  return true;
+}
+
+/// Start executable as a describe worker for job, returning its pid and setting readFd to
+/// the end of the pipe it sends the cache down, or returning -1 if it couldn't be started.
+static pid_t spawnDescribeWorker(const std::string &executable, const DiscoveryBinary &job, int &readFd)
+{
+  int fds[2];
+  if (pipe(fds) != 0) {
+    return -1;
+  }
+  // so that neither end leaks into this or any other process we start
+  fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+  fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+  if (fds[1] == kDescribeWorkerFd) {
+    // dup'ing it onto itself in the worker would leave it to be closed on exec
+    int moved = fcntl(fds[1], F_DUPFD_CLOEXEC, kDescribeWorkerFd + 1);
+    close(fds[1]);
+    if (moved < 0) {
+      close(fds[0]);
+      return -1;
+    }
+    fds[1] = moved;
+  }
+
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions, fds[1], kDescribeWorkerFd);
+
+  std::vector<char *> args;
+  args.push_back(const_cast<char *>(executable.c_str()));
+  args.push_back(const_cast<char *>(kDescribeWorkerArg));
+  args.push_back(const_cast<char *>(job.binPath.c_str()));
+  args.push_back(const_cast<char *>(job.bundlePath.c_str()));
+  args.push_back(const_cast<char *>(job.universalBinPath.c_str()));
+  args.push_back(0);
+
+  pid_t pid = -1;
+  int err = posix_spawn(&pid, executable.c_str(), &actions, 0, &args[0], environ);
+  posix_spawn_file_actions_destroy(&actions);
+  close(fds[1]);
+  if (err != 0) {
+    close(fds[0]);
+    return -1;
+  }
+  readFd = fds[0];
+  return pid;
+}
+
+/// the executable to start describe workers with, empty if there isn't one
+static std::string describeWorkerExecutable(const std::string &executable)
+{
+  if (!executable.empty()) {
+    return executable;
+  }
+#if defined(__linux__)
+  char path[4096];
+  ssize_t n = readlink("/proc/self/exe", path, sizeof(path) - 1);
+  if (n > 0) {
+    return std::string(path, size_t(n));
+  }
+#endif
+  return std::string();
+}
+
+/// a describe worker process we are waiting on
+struct DescribeWorker {
+  pid_t  pid;
+  int    fd;          ///< the read end of the pipe it sends the cache down
+  size_t job;
+  double start;
+};
+
+/// Describe each binary in jobs in its own process, up to nWorkers at a time, putting what
+/// they send back in DiscoveryBinary::described. The workers are spawned from executable,
+/// or this process's own binary if that is empty. Returns false if that can't be done here,
+/// in which case they should all be described in this process.
+static bool describeInWorkers(PluginCache *cache, std::vector<DiscoveryBinary> &jobs, unsigned int nWorkers, const std::string &executable)
+{
+  if (nWorkers == 0 || jobs.empty()) {
+    return false;
+  }
+  std::string workerExecutable = describeWorkerExecutable(executable);
+  if (workerExecutable.empty()) {
+    return false;
+  }
+
+  std::vector<DescribeWorker> running;
+  size_t next = 0;
+  while (next < jobs.size() || !running.empty()) {
+    while (next < jobs.size() && running.size() < nWorkers) {
+      int fd = -1;
+      double start = OFX::GetTimeInSeconds();
+      pid_t pid = spawnDescribeWorker(workerExecutable, jobs[next], fd);
+      if (pid < 0) {
+        if (running.empty() && next == 0) {
+          // can't start any at all, have this process describe them all instead
+          return false;
+        }
+        if (running.empty()) {
+          // nothing to wait for, so give up on this one
+          std::cerr << "could not start a worker to describe plugin binary " << jobs[next].binPath << ", ignoring it" << std::endl;
+          ++next;
+          continue;
+        }
+        // try again when one of those running is done
+        break;
+      }
+
+      DescribeWorker worker;
+      worker.pid = pid;
+      worker.fd = fd;
+      worker.job = next++;
+      worker.start = start;
+      running.push_back(worker);
+    }
+    if (running.empty()) {
+      continue;
+    }
+
+    // read whatever the workers have sent, so none of them blocks on a full pipe
+    std::vector<struct pollfd> fds(running.size());
+    for (size_t w = 0; w < running.size(); ++w) {
+      fds[w].fd = running[w].fd;
+      fds[w].events = POLLIN;
+      fds[w].revents = 0;
+    }
+    if (poll(&fds[0], fds.size(), -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      // shouldn't happen, but don't spin, wait for each in turn instead
+      for (size_t w = 0; w < fds.size(); ++w) {
+        fds[w].revents = POLLIN;
+      }
+    }
+
+    for (size_t w = running.size(); w-- > 0;) {
+      if (!fds[w].revents) {
+        continue;
+      }
+      DescribeWorker &worker = running[w];
+      DiscoveryBinary &job = jobs[worker.job];
+      char buffer[65536];
+      ssize_t n = read(worker.fd, buffer, sizeof(buffer));
+      if (n > 0) {
+        job.described.append(buffer, size_t(n));
+        continue;
+      }
+      if (n < 0 && (errno == EINTR || errno == EAGAIN)) {
+        continue;
+      }
+
+      // it has finished, one way or another
+      close(worker.fd);
+      int status = 0;
+      while (waitpid(worker.pid, &status, 0) < 0 && errno == EINTR) {
+      }
+      if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        if (WIFSIGNALED(status)) {
+          std::cerr << "plugin binary " << job.binPath << " crashed with signal " << WTERMSIG(status) << " while being described, ignoring it" << std::endl;
+        } else {
+          std::cerr << "describing plugin binary " << job.binPath << " failed, ignoring it" << std::endl;
+        }
+        job.described.clear();
+      }
+      else if (!readWorkerTimings(cache, job.bundlePath, job.described)) {
+        std::cerr << "describing plugin binary " << job.binPath << " sent back garbage, ignoring it" << std::endl;
+        job.described.clear();
+      }
+      cache->recordLoadTiming(job.bundlePath, "", "describeWorker", OFX::GetTimeInSeconds() - worker.start);
+      running.erase(running.begin() + w);
+    }
+  }
+  return true;
+}
+#else
+static bool describeInWorkers(PluginCache *, std::vector<DiscoveryBinary> &, unsigned int, const std::string &)
+{
+  return false;
+}
+#endif
+
+bool PluginCache::runDescribeWorker(int argc, char **argv, int &exitStatus)
+{
+#if defined(UNIX)
+  if (argc != 5 || strcmp(argv[1], kDescribeWorkerArg) != 0) {
+    return false;
+  }
+  DiscoveryBinary job;
+  job.binPath = argv[2];
+  job.bundlePath = argv[3];
+  job.universalBinPath = argv[4];
+
+  exitStatus = 1;
+  try {
+    // the timings of each step go back too, ahead of the binary cache
+    clearLoadTimings();
+    std::string described = describeBinary(this, job, _cacheVersion);
+    if (writeAll(kDescribeWorkerFd, writeWorkerTimings(getLoadTimings()) + described)) {
+      exitStatus = 0;
+    }
+  }
+  catch (...) {
+  }
+  close(kDescribeWorkerFd);
+  return true;
+#else
+  (void)argc;
+  (void)argv;
+  (void)exitStatus;
+  return false;
+#endif
+}
+
 std::string PluginCache::seekPluginFile(const std::string &baseName) const {
   // Exit early if disabled
   if (!_enablePluginSeek)
@@ -481,14 +923,118 @@ std::string PluginCache::seekPluginFile(const std::string &baseName) const {
   return "";
 }
 
-void PluginCache::scanPluginFiles()
+void PluginCache::scanPluginPath(MultiThread::ThreadPool &pool, std::vector<FoundBundle> &bundles, std::list<std::string> &dirs)
 {
-  std::set<std::string> foundBinFiles;
-  
+  // walk the directories on the plugin path at the same time, then put what was
+  // found back together in the order of the path
+  std::vector<DiscoveryRoot> roots(_pluginPath.size());
+  size_t r = 0;
   for (std::list<std::string>::iterator paths= _pluginPath.begin();
        paths != _pluginPath.end();
-       paths++) {
-    scanDirectory(foundBinFiles, *paths, _nonrecursePath.find(*paths) == _nonrecursePath.end());
+       paths++, r++) {
+    roots[r].path = *paths;
+    roots[r].recurse = _nonrecursePath.find(*paths) == _nonrecursePath.end();
+  }
+  {
+    ScanDirectoryWork work(this, roots);
+    pool.run(scanDirectoryThread, 0, &work);
+  }
+
+  for (r = 0; r < roots.size(); ++r) {
+    dirs.splice(dirs.end(), roots[r].dirs);
+    bundles.insert(bundles.end(), roots[r].bundles.begin(), roots[r].bundles.end());
+  }
+}
+
+void PluginCache::scanPluginFiles()
+{
+  double start = OFX::GetTimeInSeconds();
+  std::set<std::string> foundBinFiles;
+  MultiThread::ThreadPool pool(_discoveryThreads);
+
+  std::vector<FoundBundle> bundles;
+  scanPluginPath(pool, bundles, _pluginDirs);
+
+  // the binaries we need to load and describe, new ones first, in the order they were found
+  std::vector<DiscoveryBinary> toLoad;
+  for (size_t b = 0; b < bundles.size(); ++b) {
+    const FoundBundle &bundle = bundles[b];
+    std::string binpath = bundle.binPath;
+#if defined(__APPLE__) && (defined(__x86_64) || defined(__x86_64__))
+    if (_knownBinFiles.find(bundle.universalBinPath) != _knownBinFiles.end()) {
+      binpath = bundle.universalBinPath;
+    }
+#endif
+
+    if (_knownBinFiles.find(binpath) == _knownBinFiles.end()) {
+#ifdef CACHE_DEBUG
+      printf("found non-cached binary %s\n", binpath.c_str());
+#endif
+      _dirty = true;
+
+      // the binary was not in the cache
+      DiscoveryBinary job;
+      job.binary = 0;
+      job.binPath = binpath;
+      job.universalBinPath = bundle.universalBinPath;
+      job.bundlePath = bundle.bundlePath;
+      toLoad.push_back(job);
+      _knownBinFiles.insert(binpath);
+    } else {
+#ifdef CACHE_DEBUG
+      printf("found cached binary %s\n", binpath.c_str());
+#endif
+      // insert final path (universal or not) in the list of found files
+      foundBinFiles.insert(binpath);
+    }
+  }
+  size_t nNewBinaries = toLoad.size();
+
+  // the binaries in the cache which are still on the path but have changed need reloading
+  for (std::list<PluginBinary *>::iterator i=_binaries.begin(); i != _binaries.end(); ++i) {
+    PluginBinary *pb = *i;
+    if (!pb->isStaticallyLinkedPlugin() && pb->hasBinaryChanged() &&
+        foundBinFiles.find(pb->getFilePath()) != foundBinFiles.end()) {
+      DiscoveryBinary job;
+      job.binary = pb;
+      job.binPath = pb->getFilePath();
+      job.bundlePath = pb->getBundlePath();
+      toLoad.push_back(job);
+    }
+  }
+
+  // dlopen and describe them all, each binary in its own process or on one thread
+  if (describeInWorkers(this, toLoad, _describeWorkers, _describeWorkerExecutable)) {
+    for (size_t b = 0; b < toLoad.size(); ++b) {
+      PluginBinary *described = readDescribedBinary(toLoad[b].described);
+      if (b < nNewBinaries) {
+        toLoad[b].binary = described;
+      } else {
+        // a changed binary from the cache, put the new one in its place, or drop it if it couldn't be described
+        PluginBinary *old = toLoad[b].binary;
+        std::list<PluginBinary *>::iterator found = std::find(_binaries.begin(), _binaries.end(), old);
+        if (described) {
+          *found = described;
+        } else {
+          _binaries.erase(found);
+          _knownBinFiles.erase(old->getFilePath());
+          _dirty = true;
+        }
+        delete old;
+      }
+    }
+  } else {
+    LoadBinaryWork work(this, toLoad);
+    pool.run(loadBinaryThread, 0, &work);
+  }
+
+  for (size_t b = 0; b < nNewBinaries; ++b) {
+    if (!toLoad[b].binary) {
+      continue;
+    }
+    _binaries.push_back(toLoad[b].binary);
+    _knownBinFiles.insert(toLoad[b].binPath);
+    foundBinFiles.insert(toLoad[b].binPath);
   }
 
 #ifdef OFX_USE_STATIC_PLUGINS
@@ -530,12 +1076,9 @@ void PluginCache::scanPluginFiles()
       
       bool binChanged = pb->hasBinaryChanged();
       
-      // the binary was in the cache, but the binary has changed and thus we need to reload
+      // the binary was in the cache, but the binary has changed, it was reloaded above
+      // unless it is the static one, which already had loadPluginInfo called anyway
       if (binChanged) {
-        // The static PluginBinary already had loadPluginInfo called anyway at this point
-        if (!pb->isStaticallyLinkedPlugin()) {
-          pb->loadPluginInfo(this);
-        }
         _dirty = true;
       }
       
@@ -543,7 +1086,7 @@ void PluginCache::scanPluginFiles()
         Plugin *plug = &pb->getPlugin(j);
         APICache::PluginAPICacheI &api = plug->getApiHandler();
         
-        if (binChanged) {
+        if (binChanged && pb->isStaticallyLinkedPlugin()) {
           api.loadFromPlugin(plug);
         }
         
@@ -561,6 +1104,291 @@ void PluginCache::scanPluginFiles()
       i++;
     }
   }
+
+  MultiThread::ScopedLock guard(_loadTimingsLock);
+  _scanTime = OFX::GetTimeInSeconds() - start;
+}
+
+void PluginCache::retireBinary(PluginBinary *pb)
+{
+  for (int j=0;j<pb->getNPlugins();j++) {
+    Plugin *plug = &pb->getPlugin(j);
+    std::list<Plugin *>::iterator found = std::find(_plugins.begin(), _plugins.end(), plug);
+    if (found != _plugins.end()) {
+      _plugins.erase(found);
+      plug->getApiHandler().forgetPlugin(plug, _pluginPath);
+    }
+  }
+  pb->releaseBinary();
+  _binaries.remove(pb);
+  _retiredBinaries.push_back(pb);
+  _dirty = true;
+}
+
+bool PluginCache::updatePluginFiles()
+{
+  if (_watchHandle >= 0) {
+#if defined(__linux__)
+    // all we want to know is whether anything happened, so just drain the events
+    bool changed = false;
+    char events[4096];
+    ssize_t n;
+    while ((n = read(_watchHandle, events, sizeof(events))) > 0) {
+      changed = true;
+    }
+    if (!changed) {
+      return false;
+    }
+#endif
+  }
+
+  MultiThread::ThreadPool pool(_discoveryThreads);
+  std::vector<FoundBundle> bundles;
+  std::list<std::string> dirs;
+  scanPluginPath(pool, bundles, dirs);
+  _pluginDirs.swap(dirs);
+
+  std::vector<DiscoveryBinary> toLoad;
+  std::set<std::string> foundBinFiles;
+  for (size_t b = 0; b < bundles.size(); ++b) {
+    const FoundBundle &bundle = bundles[b];
+    std::string binpath = bundle.binPath;
+#if defined(__APPLE__) && (defined(__x86_64) || defined(__x86_64__))
+    if (_knownBinFiles.find(bundle.universalBinPath) != _knownBinFiles.end()) {
+      binpath = bundle.universalBinPath;
+    }
+#endif
+    foundBinFiles.insert(binpath);
+    if (_knownBinFiles.find(binpath) == _knownBinFiles.end()) {
+      DiscoveryBinary job;
+      job.binary = 0;
+      job.binPath = binpath;
+      job.universalBinPath = bundle.universalBinPath;
+      job.bundlePath = bundle.bundlePath;
+      toLoad.push_back(job);
+    }
+  }
+
+  // binaries that have gone or changed are retired, the changed ones loaded again as new ones
+  bool pluginsChanged = false;
+  std::list<PluginBinary *> binaries = _binaries;
+  for (std::list<PluginBinary *>::iterator i = binaries.begin(); i != binaries.end(); ++i) {
+    PluginBinary *pb = *i;
+    if (pb->isStaticallyLinkedPlugin()) {
+      continue;
+    }
+    if (foundBinFiles.find(pb->getFilePath()) == foundBinFiles.end()) {
+      _knownBinFiles.erase(pb->getFilePath());
+      retireBinary(pb);
+      pluginsChanged = true;
+    } else {
+      bool wasChanged = pb->hasBinaryChanged();
+      if (pb->checkForChanges(_contentHashing)) {
+        DiscoveryBinary job;
+        job.binary = 0;
+        job.binPath = pb->getFilePath();
+        job.bundlePath = pb->getBundlePath();
+        toLoad.push_back(job);
+        retireBinary(pb);
+        pluginsChanged = true;
+      } else if (wasChanged) {
+        // only touched, the new time stamp wants saving
+        _dirty = true;
+      }
+    }
+  }
+
+  if (describeInWorkers(this, toLoad, _describeWorkers, _describeWorkerExecutable)) {
+    for (size_t b = 0; b < toLoad.size(); ++b) {
+      toLoad[b].binary = readDescribedBinary(toLoad[b].described);
+    }
+  } else {
+    LoadBinaryWork work(this, toLoad);
+    pool.run(loadBinaryThread, 0, &work);
+  }
+
+  for (size_t b = 0; b < toLoad.size(); ++b) {
+    PluginBinary *pb = toLoad[b].binary;
+    if (!pb) {
+      continue;
+    }
+    _binaries.push_back(pb);
+    _knownBinFiles.insert(toLoad[b].binPath);
+    _dirty = true;
+    pluginsChanged = true;
+
+    for (int j=0;j<pb->getNPlugins();j++) {
+      Plugin *plug = &pb->getPlugin(j);
+      APICache::PluginAPICacheI &api = plug->getApiHandler();
+      std::string reason;
+      if (api.pluginSupported(plug, reason)) {
+        _plugins.push_back(plug);
+        api.confirmPlugin(plug, _pluginPath);
+      } else {
+        std::cerr << "ignoring plugin " << plug->getIdentifier() <<
+          " as unsupported (" << reason << ")" << std::endl;
+      }
+    }
+  }
+
+  // watch whatever directories have appeared
+  watchPluginPath();
+
+  return pluginsChanged;
+}
+
+void PluginCache::watchPluginPath()
+{
+#if defined(__linux__)
+  if (_watchHandle < 0) {
+    return;
+  }
+
+  // the roots, which may not exist yet, the directories under them, and the directories the
+  // binaries are in, as replacing a binary doesn't touch the directories above it
+  std::list<std::string> dirs(_pluginPath.begin(), _pluginPath.end());
+  dirs.insert(dirs.end(), _pluginDirs.begin(), _pluginDirs.end());
+  for (std::list<PluginBinary *>::const_iterator b = _binaries.begin(); b != _binaries.end(); ++b) {
+    if (!(*b)->isStaticallyLinkedPlugin()) {
+      const std::string &path = (*b)->getFilePath();
+      dirs.push_back(path.substr(0, path.rfind(DIRSEP)));
+    }
+  }
+
+  for (std::list<std::string>::const_iterator d = dirs.begin(); d != dirs.end(); ++d) {
+    if (_watchedDirs.find(*d) == _watchedDirs.end() &&
+        inotify_add_watch(_watchHandle, d->c_str(),
+                          IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_CLOSE_WRITE | IN_ATTRIB | IN_DELETE_SELF) >= 0) {
+      _watchedDirs.insert(*d);
+    }
+  }
+#endif
+}
+
+bool PluginCache::startWatching()
+{
+#if defined(__linux__)
+  if (_watchHandle >= 0) {
+    return true;
+  }
+  _watchHandle = inotify_init();
+  if (_watchHandle < 0) {
+    return false;
+  }
+  fcntl(_watchHandle, F_SETFL, fcntl(_watchHandle, F_GETFL) | O_NONBLOCK);
+  fcntl(_watchHandle, F_SETFD, FD_CLOEXEC);
+
+  watchPluginPath();
+  if (_watchedDirs.empty()) {
+    stopWatching();
+    return false;
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+void PluginCache::stopWatching()
+{
+#if defined(__linux__)
+  if (_watchHandle >= 0) {
+    close(_watchHandle);
+  }
+#endif
+  _watchHandle = -1;
+  _watchedDirs.clear();
+}
+
+void PluginCache::recordLoadTiming(const std::string &bundlePath, const std::string &pluginId, const std::string &step, double seconds)
+{
+  LoadTiming timing;
+  timing.bundlePath = bundlePath;
+  timing.pluginId = pluginId;
+  timing.step = step;
+  timing.seconds = seconds;
+
+  MultiThread::ScopedLock guard(_loadTimingsLock);
+  _loadTimings.push_back(timing);
+}
+
+std::vector<PluginCache::LoadTiming> PluginCache::getLoadTimings() const
+{
+  MultiThread::ScopedLock guard(_loadTimingsLock);
+  return _loadTimings;
+}
+
+/// Whether a step is added up in a bundle's total. loadPluginInfo includes the binary load,
+/// and a describe worker's run all the steps it sent back, so don't count those twice.
+static bool countsTowardsTotal(const std::string &step)
+{
+  return step != "binaryLoad" && step != "describeWorker";
+}
+
+double PluginCache::getBundleLoadTime(const std::string &bundlePath) const
+{
+  MultiThread::ScopedLock guard(_loadTimingsLock);
+  double seconds = 0;
+  for (std::vector<LoadTiming>::const_iterator it = _loadTimings.begin(); it != _loadTimings.end(); ++it) {
+    if (it->bundlePath == bundlePath && countsTowardsTotal(it->step)) {
+      seconds += it->seconds;
+    }
+  }
+  return seconds;
+}
+
+double PluginCache::getScanTime() const
+{
+  MultiThread::ScopedLock guard(_loadTimingsLock);
+  return _scanTime;
+}
+
+void PluginCache::clearLoadTimings()
+{
+  MultiThread::ScopedLock guard(_loadTimingsLock);
+  _loadTimings.clear();
+}
+
+/// sorts bundles slowest first, then by name
+static bool slowerBundle(const std::pair<double, std::string> &a, const std::pair<double, std::string> &b)
+{
+  if (a.first != b.first) {
+    return a.first > b.first;
+  }
+  return a.second < b.second;
+}
+
+void PluginCache::dumpLoadTimings(std::ostream &os) const
+{
+  std::vector<LoadTiming> timings = getLoadTimings();
+
+  std::map<std::string, double> totals;
+  for (std::vector<LoadTiming>::const_iterator it = timings.begin(); it != timings.end(); ++it) {
+    // a bundle whose worker crashed only has the worker's run, but still wants listing
+    double &total = totals[it->bundlePath];
+    if (countsTowardsTotal(it->step)) {
+      total += it->seconds;
+    }
+  }
+  std::vector<std::pair<double, std::string> > bundles;
+  for (std::map<std::string, double>::const_iterator it = totals.begin(); it != totals.end(); ++it) {
+    bundles.push_back(std::make_pair(it->second, it->first));
+  }
+  std::sort(bundles.begin(), bundles.end(), slowerBundle);
+
+  os << "plugin scan took " << getScanTime() * 1000. << " ms" << std::endl;
+  for (std::vector<std::pair<double, std::string> >::const_iterator b = bundles.begin(); b != bundles.end(); ++b) {
+    os << b->first * 1000. << " ms " << b->second << std::endl;
+    for (std::vector<LoadTiming>::const_iterator it = timings.begin(); it != timings.end(); ++it) {
+      if (it->bundlePath == b->second) {
+        os << "    " << it->seconds * 1000. << " ms ";
+        if (!it->pluginId.empty()) {
+          os << it->pluginId << " ";
+        }
+        os << it->step << std::endl;
+      }
+    }
+  }
 }
 
 
@@ -647,6 +1475,11 @@ void PluginCache::elementBeginCallback(void */*userData*/, const XML_Char *name,
 #endif
     {
       pb = new PluginBinary(fname, bname, mtime, size);
+      pb->setContentHash(attmap["hash"]);
+      if (_contentHashing && pb->hasBinaryChanged() && !pb->checkForChanges(true)) {
+        // only touched since it was cached, the new time stamp wants saving
+        _dirty = true;
+      }
     }
     _xmlCurrentBinary = pb;
     _binaries.push_back(_xmlCurrentBinary);
@@ -774,6 +1607,110 @@ void PluginCache::readCache(std::istream &ifs) {
   XML_ParserFree(xP);
 }
 
+bool PluginCache::readBinaryCache(const std::string &fileName) {
+  BinaryCache::Reader *reader = new BinaryCache::Reader;
+  std::string why;
+  if (!reader->open(fileName, _cacheVersion, why)) {
+#ifdef CACHE_DEBUG
+    printf("ignoring binary cache %s: %s\n", fileName.c_str(), why.c_str());
+#endif
+    delete reader;
+    return false;
+  }
+  _binaryCaches.push_back(reader);
+
+  for (BinaryCache::UInt32 b = 0; b < reader->getNBinaries(); ++b) {
+    const BinaryCache::BinaryRecord &binRecord = reader->getBinary(b);
+    std::string fname = reader->getString(binRecord.path);
+    std::string bname = reader->getString(binRecord.bundlePath);
+    time_t mtime = time_t(binRecord.mtime);
+    off_t size = off_t(binRecord.size);
+
+    PluginBinary* pb;
+#ifdef OFX_USE_STATIC_PLUGINS
+    if (binRecord.isStatic) {
+      // only 1 static binary allowed!
+      if (_staticBinary) {
+        continue;
+      }
+      // We need to provide the 2 function pointers for the static binary
+      pb = new PluginBinary(_hostAppBinFilePath, &OfxGetNumberOfPlugins,&OfxGetPlugin, this, &fname, &mtime, &size);
+      _staticBinary = pb;
+    } else
+#endif
+    {
+      pb = new PluginBinary(fname, bname, mtime, size);
+      pb->setContentHash(reader->getString(binRecord.hash));
+      if (_contentHashing && pb->hasBinaryChanged() && !pb->checkForChanges(true)) {
+        // only touched since it was cached, the new time stamp wants saving
+        _dirty = true;
+      }
+    }
+    _binaries.push_back(pb);
+    _knownBinFiles.insert(fname);
+
+    if (!pb->hasBinaryChanged()) {
+      readCachedPlugins(pb, *reader, binRecord);
+    }
+  }
+  return true;
+}
+
+void PluginCache::readCachedPlugins(PluginBinary *pb, const BinaryCache::Reader &reader, const BinaryCache::BinaryRecord &record) {
+  for (BinaryCache::UInt32 p = 0; p < record.nPlugins; ++p) {
+    const BinaryCache::PluginRecord &plugRecord = reader.getPlugin(record.firstPlugin + p);
+    std::string api = reader.getString(plugRecord.api);
+    std::string rawIdentifier = reader.getString(plugRecord.identifier);
+
+    APICache::PluginAPICacheI *apiCache = findApiHandler(api, plugRecord.apiVersion);
+    if (apiCache) {
+      Plugin *pe = apiCache->newPlugin(pb, plugRecord.index, api, plugRecord.apiVersion, rawIdentifier, rawIdentifier,
+                                       plugRecord.versionMajor, plugRecord.versionMinor);
+      pb->addPlugin(pe);
+      apiCache->loadBinary(pe, reader, plugRecord.firstSet, plugRecord.nSets);
+    }
+  }
+}
+
+PluginBinary *PluginCache::readDescribedBinary(const std::string &cache) {
+  if (cache.empty()) {
+    return NULL;
+  }
+  BinaryCache::Reader *reader = new BinaryCache::Reader;
+  std::string why;
+  if (!reader->read(cache, _cacheVersion, why) || reader->getNBinaries() != 1) {
+    std::cerr << "ignoring what a describe worker sent back: " << why << std::endl;
+    delete reader;
+    return NULL;
+  }
+  // the plugins may decode from it later
+  _binaryCaches.push_back(reader);
+
+  const BinaryCache::BinaryRecord &binRecord = reader->getBinary(0);
+  PluginBinary *pb = new PluginBinary(reader->getString(binRecord.path), reader->getString(binRecord.bundlePath),
+                                      time_t(binRecord.mtime), off_t(binRecord.size));
+  pb->setContentHash(reader->getString(binRecord.hash));
+  readCachedPlugins(pb, *reader, binRecord);
+  return pb;
+}
+
+void PluginCache::writeBinaryCache(std::ostream &os) const {
+  BinaryCache::Writer writer(_cacheVersion);
+  for (std::list<PluginBinary *>::const_iterator i=_binaries.begin();i!=_binaries.end();i++) {
+    PluginBinary *b = *i;
+    writer.addBinary(b->getFilePath(), b->getBundlePath(), b->getFileModificationTime(), b->getFileSize(),
+                     b->isStaticallyLinkedPlugin(), b->getContentHash());
+
+    for (int j=0;j<b->getNPlugins();j++) {
+      Plugin *p = &b->getPlugin(j);
+      writer.addPlugin(p->getRawIdentifier(), p->getPluginApi(), p->getIndex(),
+                       p->getApiVersion(), p->getVersionMajor(), p->getVersionMinor());
+      p->getApiHandler().saveBinary(p, writer);
+    }
+  }
+  writer.write(os);
+}
+
 void PluginCache::writePluginCache(std::ostream &os) const {
 #ifdef CACHE_DEBUG
   printf("writing pluginCache with version = %s\n", _cacheVersion.c_str());
@@ -794,7 +1731,11 @@ void PluginCache::writePluginCache(std::ostream &os) const {
        << XML::attribute("bundle_path", b->getBundlePath())
        << XML::attribute("path", b->getFilePath())
        << XML::attribute("mtime", int(b->getFileModificationTime()))
-       << XML::attribute("size", int(b->getFileSize())) << "/>\n";
+       << XML::attribute("size", int(b->getFileSize()));
+    if (!b->getContentHash().empty()) {
+      os << XML::attribute("hash", b->getContentHash());
+    }
+    os << "/>\n";
     
     for (int j=0;j<(int)plugins.size();j++) {
       Plugin *p = plugins[j];
@@ -0,0 +1,276 @@
+
+/*
+Software License :
+
+Copyright (c) 2007-2009, The Open Effects Association Ltd. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+* Neither the name The Open Effects Association Ltd, nor the names of its 
+contributors may be used to endorse or promote products derived from this
+software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdlib.h>
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <ostream>
+
+#include "ofxCore.h"
+#include "ofxhUtilities.h"
+#include "ofxhMultiThread.h"
+#include "ofxhPropertyProfiler.h"
+
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1900)
+#define OFX_PROFILER_THREAD_LOCAL thread_local
+#else
+// no thread local storage, actions on different threads will be muddled
+#define OFX_PROFILER_THREAD_LOCAL
+#endif
+
+namespace OFX {
+
+  namespace Host {
+
+    namespace Property {
+
+      namespace Profiler {
+
+#     ifdef OFX_PROFILER_HAS_ATOMIC
+        std::atomic<bool> gEnabled(getenv("OFX_PROPERTY_PROFILE") != NULL);
+#     else
+        volatile bool gEnabled = getenv("OFX_PROPERTY_PROFILE") != NULL;
+#     endif
+
+        /// what the counts are kept by, all pointers are compared by address
+        struct Key {
+          Atom        name;
+          const char *kind;
+          Atom        action;
+
+          bool operator<(const Key &other) const
+          {
+            if(name != other.name) return name < other.name;
+            if(kind != other.kind) return kind < other.kind;
+            return action < other.action;
+          }
+        };
+
+        struct Counts {
+          unsigned long long calls;
+          double             seconds;
+        };
+
+        /// the counts are split over several maps, each with its own lock, so threads
+        /// rendering at the same time rarely wait on each other
+        struct Shard {
+          MultiThread::Mutex    lock;
+          std::map<Key, Counts> counts;
+        };
+
+        static const size_t kNShards = 16;
+        static Shard gShards[kNShards];
+
+        static OFX_PROFILER_THREAD_LOCAL Atom gCurrentAction = 0;
+
+        void setEnabled(bool enabled)
+        {
+#       ifdef OFX_PROFILER_HAS_ATOMIC
+          gEnabled.store(enabled, std::memory_order_relaxed);
+#       else
+          gEnabled = enabled;
+#       endif
+        }
+
+        void reset()
+        {
+          for(size_t i = 0; i < kNShards; ++i) {
+            MultiThread::ScopedLock lock(gShards[i].lock);
+            gShards[i].counts.clear();
+          }
+        }
+
+        void record(Atom name, const char *kind, Atom action, double seconds)
+        {
+          Key key = { name, kind, action };
+          Shard &shard = gShards[(HashBytes(&name, sizeof(name)) ^ HashBytes(&action, sizeof(action))) % kNShards];
+
+          MultiThread::ScopedLock lock(shard.lock);
+          std::map<Key, Counts>::iterator i = shard.counts.find(key);
+          if(i == shard.counts.end()) {
+            Counts counts = { 0, 0.0 };
+            i = shard.counts.insert(std::make_pair(key, counts)).first;
+          }
+          ++i->second.calls;
+          i->second.seconds += seconds;
+        }
+
+        /// slowest first, then by name
+        static bool slowerThan(const Entry &a, const Entry &b)
+        {
+          if(a.seconds != b.seconds) return a.seconds > b.seconds;
+          if(a.name != b.name) return a.name < b.name;
+          if(a.kind != b.kind) return a.kind < b.kind;
+          return a.action < b.action;
+        }
+
+        void getEntries(std::vector<Entry> &entries)
+        {
+          // the same kind can be at different addresses if it is a literal in several files,
+          // so merge by value
+          typedef std::pair<std::string, std::pair<std::string, std::string> > Names;
+          std::map<Names, Counts> merged;
+
+          for(size_t i = 0; i < kNShards; ++i) {
+            MultiThread::ScopedLock lock(gShards[i].lock);
+            for(std::map<Key, Counts>::const_iterator j = gShards[i].counts.begin(); j != gShards[i].counts.end(); ++j) {
+              Names names(j->first.name ? *j->first.name : std::string(),
+                          std::make_pair(std::string(j->first.kind),
+                                         j->first.action ? *j->first.action : std::string()));
+              std::map<Names, Counts>::iterator m = merged.find(names);
+              if(m == merged.end()) {
+                merged.insert(std::make_pair(names, j->second));
+              }
+              else {
+                m->second.calls += j->second.calls;
+                m->second.seconds += j->second.seconds;
+              }
+            }
+          }
+
+          entries.clear();
+          entries.reserve(merged.size());
+          for(std::map<Names, Counts>::const_iterator m = merged.begin(); m != merged.end(); ++m) {
+            Entry entry;
+            entry.name = m->first.first;
+            entry.kind = m->first.second.first;
+            entry.action = m->first.second.second;
+            entry.calls = m->second.calls;
+            entry.seconds = m->second.seconds;
+            entries.push_back(entry);
+          }
+          std::sort(entries.begin(), entries.end(), slowerThan);
+        }
+
+        /// write a string as a JSON string
+        static void writeJSONString(std::ostream &os, const std::string &s)
+        {
+          os << '"';
+          for(std::string::const_iterator i = s.begin(); i != s.end(); ++i) {
+            unsigned char c = (unsigned char)*i;
+            if(c == '"' || c == '\\') {
+              os << '\\' << *i;
+            }
+            else if(c < 0x20) {
+              static const char hexDigits[] = "0123456789abcdef";
+              os << "\\u00" << hexDigits[c >> 4] << hexDigits[c & 15];
+            }
+            else {
+              os << *i;
+            }
+          }
+          os << '"';
+        }
+
+        void dump(std::ostream &os, Format format)
+        {
+          std::vector<Entry> entries;
+          getEntries(entries);
+
+          // the caller's stream is handed back as it was given
+          std::streamsize precision = os.precision();
+          if(format == eJSON) {
+            os << "[";
+            for(size_t i = 0; i < entries.size(); ++i) {
+              os << (i ? ",\n " : "\n ") << "{\"name\": ";
+              writeJSONString(os, entries[i].name);
+              os << ", \"kind\": ";
+              writeJSONString(os, entries[i].kind);
+              os << ", \"action\": ";
+              writeJSONString(os, entries[i].action);
+              os << ", \"calls\": " << entries[i].calls
+                 << ", \"seconds\": " << std::setprecision(9) << entries[i].seconds << "}";
+            }
+            os << "\n]\n";
+            os.precision(precision);
+            return;
+          }
+
+          size_t nameWidth = 8, kindWidth = 4, actionWidth = 6;
+          unsigned long long totalCalls = 0;
+          double totalSeconds = 0;
+          for(size_t i = 0; i < entries.size(); ++i) {
+            nameWidth = Maximum(nameWidth, entries[i].name.size());
+            kindWidth = Maximum(kindWidth, entries[i].kind.size());
+            actionWidth = Maximum(actionWidth, entries[i].action.size());
+            totalCalls += entries[i].calls;
+            totalSeconds += entries[i].seconds;
+          }
+
+          std::ios::fmtflags flags = os.flags();
+          os << std::left
+             << std::setw(int(nameWidth)) << "property" << "  "
+             << std::setw(int(kindWidth)) << "kind" << "  "
+             << std::setw(int(actionWidth)) << "action" << "  "
+             << std::right << std::setw(12) << "calls" << "  "
+             << std::setw(12) << "total us" << "  "
+             << std::setw(10) << "us/call" << "\n";
+          os << std::fixed << std::setprecision(3);
+          for(size_t i = 0; i < entries.size(); ++i) {
+            const Entry &entry = entries[i];
+            os << std::left
+               << std::setw(int(nameWidth)) << entry.name << "  "
+               << std::setw(int(kindWidth)) << entry.kind << "  "
+               << std::setw(int(actionWidth)) << entry.action << "  "
+               << std::right << std::setw(12) << entry.calls << "  "
+               << std::setw(12) << entry.seconds * 1e6 << "  "
+               << std::setw(10) << entry.seconds * 1e6 / double(entry.calls) << "\n";
+          }
+          os << std::left << std::setw(int(nameWidth + kindWidth + actionWidth + 4)) << "total" << "  "
+             << std::right << std::setw(12) << totalCalls << "  "
+             << std::setw(12) << totalSeconds * 1e6 << "\n";
+          os.flags(flags);
+          os.precision(precision);
+        }
+
+        Atom getCurrentAction()
+        {
+          return gCurrentAction;
+        }
+
+        ActionScope::ActionScope(const char *action)
+          : _previous(gCurrentAction)
+        {
+          gCurrentAction = (isEnabled() && action) ? internName(action) : 0;
+        }
+
+        ActionScope::~ActionScope()
+        {
+          gCurrentAction = _previous;
+        }
+
+      }
+
+    }
+
+  }
+
+}
@@ -30,10 +30,13 @@
 // ofx
 #include "ofxCore.h"
 #include "ofxImageEffect.h"
+#include "ofxPropertyBatch.h"
 
 // ofx host
 #include "ofxhBinary.h"
 #include "ofxhPropertySuite.h"
+#include "ofxhPropertyProfiler.h"
+#include "ofxhMultiThread.h"
 #include "ofxhUtilities.h"
 
 #include <iostream>
@@ -223,6 +226,26 @@ namespace OFX {
       inline double castToAPIType(double d) { return d; }
       inline const char *castToAPIType(const std::string &s) { return s.c_str(); }
 
+      /// copy values out to the API, a memcpy for all but strings
+      inline void copyToAPI(int *dst, const int *src, size_t n) { memcpy(dst, src, n * sizeof(int)); }
+      inline void copyToAPI(double *dst, const double *src, size_t n) { memcpy(dst, src, n * sizeof(double)); }
+      inline void copyToAPI(void **dst, void *const *src, size_t n) { memcpy(dst, src, n * sizeof(void *)); }
+      inline void copyToAPI(const char **dst, const std::string *src, size_t n)
+      {
+        for(size_t i = 0; i < n; ++i)
+          dst[i] = src[i].c_str();
+      }
+
+      /// copy values in from the API, a memcpy for all but strings
+      inline void copyFromAPI(int *dst, const int *src, size_t n) { memcpy(dst, src, n * sizeof(int)); }
+      inline void copyFromAPI(double *dst, const double *src, size_t n) { memcpy(dst, src, n * sizeof(double)); }
+      inline void copyFromAPI(void **dst, void *const *src, size_t n) { memcpy(dst, src, n * sizeof(void *)); }
+      inline void copyFromAPI(std::string *dst, const char *const *src, size_t n)
+      {
+        for(size_t i = 0; i < n; ++i)
+          dst[i] = src[i];
+      }
+
       template<class T> PropertyTemplate<T>::PropertyTemplate(const std::string &name,					    
         int dimension,													    
         bool /*pluginReadOnly*/,
@@ -302,8 +325,8 @@ namespace OFX {
           size = _value.size();
         }
 
-        for (size_t i=0;i<size;i++) {
-          value[i] = castToAPIType(_value[i]);
+        if (size) {
+          copyToAPI(value, &_value[0], size);
         }
       }
 
@@ -331,8 +354,8 @@ namespace OFX {
         if (_value.size() != (size_t)count) {
           _value.resize(count);
         }
-        for (int i=0;i<count;i++) {
-          _value[i] = value[i];
+        if (count > 0) {
+          copyFromAPI(&_value[0], value, count);
         }
         
         notify(false, count);
@@ -408,29 +431,242 @@ namespace OFX {
         }
       }
 
-      Property *Set::fetchProperty(const std::string&name, bool followChain) const
+      ////////////////////////////////////////////////////////////////////////////////
+      // interned property names
+
+      namespace {
+
+        /// hash a name, as used to index the intern table and the thread caches
+        inline size_t hashName(const char *name)
+        {
+          return (size_t) HashBytes(name, strlen(name));
+        }
+
+        /// hash an atom or a name pointer by its address
+        inline size_t hashAddress(const void *p)
+        {
+          size_t v = (size_t) p;
+          return (v >> 4) ^ (v >> 12);
+        }
+
+        /// The process wide table of interned names. Atoms are never freed, so they can be
+        /// held anywhere, including the per thread caches below.
+        class InternTable {
+          struct Slot {
+            size_t hash;
+            Atom   atom;
+          };
+
+          MultiThread::Mutex _lock;
+          std::vector<Slot>  _slots;  ///< open addressed, linear probing, the size is a power of two
+          size_t             _count;
+
+          /// find the slot for a name, which is empty if it is not interned
+          Slot &findSlot(const char *name, size_t hash)
+          {
+            size_t mask = _slots.size() - 1;
+            for(size_t i = hash & mask; ; i = (i + 1) & mask) {
+              Slot &slot = _slots[i];
+              if(!slot.atom || (slot.hash == hash && *slot.atom == name))
+                return slot;
+            }
+          }
+
+          void grow()
+          {
+            std::vector<Slot> old;
+            old.swap(_slots);
+            Slot empty = { 0, 0 };
+            _slots.assign(old.size() * 2, empty);
+            size_t mask = _slots.size() - 1;
+            for(size_t i = 0; i < old.size(); ++i) {
+              if(old[i].atom) {
+                size_t j = old[i].hash & mask;
+                while(_slots[j].atom)
+                  j = (j + 1) & mask;
+                _slots[j] = old[i];
+              }
+            }
+          }
+
+        public :
+          InternTable()
+            : _count(0)
+          {
+            Slot empty = { 0, 0 };
+            _slots.assign(1024, empty);
+          }
+
+          /// look up a name, interning it if asked, NULL if not found and not interning
+          Atom lookup(const char *name, size_t hash, bool intern)
+          {
+            MultiThread::ScopedLock lock(_lock);
+            Slot *slot = &findSlot(name, hash);
+            if(slot->atom || !intern)
+              return slot->atom;
+
+            if((_count + 1) * 2 > _slots.size()) {
+              grow();
+              slot = &findSlot(name, hash);
+            }
+            slot->hash = hash;
+            slot->atom = new std::string(name);
+            ++_count;
+            return slot->atom;
+          }
+        };
+
+        /// the intern table, never destroyed so atoms stay valid during static destruction
+        InternTable &getInternTable()
+        {
+          static InternTable *table = new InternTable;
+          return *table;
+        }
+
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1900)
+        /// A small direct mapped cache of atoms per thread, so the common lookups take no
+        /// lock. It is keyed both by the address of the name, which catches plugins passing
+        /// the same kOfx constants over and over, and by the hash of the name. Entries are
+        /// always checked against the name, as a name's storage may be reused for another.
+        struct ThreadNameCache {
+          enum { kSize = 256 };
+
+          struct ByAddress {
+            const char *name;
+            Atom        atom;
+          };
+
+          struct ByHash {
+            size_t hash;
+            Atom   atom;
+          };
+
+          ByAddress byAddress[kSize];
+          ByHash    byHash[kSize];
+        };
+
+        thread_local ThreadNameCache gThreadNameCache = {};
+#endif
+
+        Atom lookupName(const char *name, bool intern)
+        {
+          // a plugin may pass a NULL name, which no property has
+          if(!name)
+            return 0;
+
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1900)
+          ThreadNameCache &cache = gThreadNameCache;
+          ThreadNameCache::ByAddress &byAddress = cache.byAddress[hashAddress(name) % ThreadNameCache::kSize];
+          if(byAddress.atom && byAddress.name == name && *byAddress.atom == name)
+            return byAddress.atom;
+
+          size_t hash = hashName(name);
+          ThreadNameCache::ByHash &byHash = cache.byHash[hash % ThreadNameCache::kSize];
+          Atom atom = (byHash.atom && byHash.hash == hash && *byHash.atom == name) ? byHash.atom : 0;
+          if(!atom) {
+            atom = getInternTable().lookup(name, hash, intern);
+            if(!atom)
+              return 0;
+            byHash.hash = hash;
+            byHash.atom = atom;
+          }
+          byAddress.name = name;
+          byAddress.atom = atom;
+          return atom;
+#else
+          return getInternTable().lookup(name, hashName(name), intern);
+#endif
+        }
+
+      }
+
+      Atom internName(const char *name)
       {
-        PropertyMap::const_iterator i = _props.find(name);
-        if (i == _props.end()) {
-          if(followChain && _chainedSet) {
-            return _chainedSet->fetchProperty(name, true);
+        return lookupName(name, true);
+      }
+
+      Atom findName(const char *name)
+      {
+        return lookupName(name, false);
+      }
+
+      ////////////////////////////////////////////////////////////////////////////////
+      // property lookup
+
+      void Set::indexProperty(Property *prop)
+      {
+        Atom atom = internName(prop->getName().c_str());
+
+        if((_indexCount + 1) * 2 > _index.size()) {
+          std::vector<IndexEntry> old;
+          old.swap(_index);
+          IndexEntry empty = { 0, 0, eInt };
+          _index.assign(old.empty() ? 16 : old.size() * 2, empty);
+          _indexCount = 0;
+          for(size_t i = 0; i < old.size(); ++i) {
+            if(old[i].atom)
+              indexProperty(old[i].property);
+          }
+        }
+
+        size_t mask = _index.size() - 1;
+        size_t i = hashAddress(atom) & mask;
+        while(_index[i].atom && _index[i].atom != atom)
+          i = (i + 1) & mask;
+
+        if(!_index[i].atom)
+          ++_indexCount;
+        _index[i].atom = atom;
+        _index[i].property = prop;
+        _index[i].type = prop->getType();
+      }
+
+      const Set::IndexEntry *Set::findIndexEntry(Atom atom, bool followChain) const
+      {
+        for(const Set *set = this; set; set = followChain ? set->_chainedSet : 0) {
+          if(set->_index.empty())
+            continue;
+          size_t mask = set->_index.size() - 1;
+          for(size_t i = hashAddress(atom) & mask; set->_index[i].atom; i = (i + 1) & mask) {
+            if(set->_index[i].atom == atom)
+              return &set->_index[i];
           }
-          return NULL;
         }
-        return i->second;
+        return NULL;
+      }
+
+      Property *Set::fetchProperty(const std::string&name, bool followChain) const
+      {
+        return fetchProperty(name.c_str(), followChain);
+      }
+
+      Property *Set::fetchProperty(const char *name, bool followChain) const
+      {
+        Atom atom = findName(name);
+        if(!atom)
+          return NULL; // never interned, so no set has it
+
+        const IndexEntry *entry = findIndexEntry(atom, followChain);
+        return entry ? entry->property : NULL;
       }
 
       template<class T> bool Set::fetchTypedProperty(const std::string&name, T *&prop, bool followChain) const
       {
-        Property *myprop = fetchProperty(name, followChain);
+        return fetchTypedProperty(name.c_str(), prop, followChain);
+      }
 
-        if(!myprop)
+      template<class T> bool Set::fetchTypedProperty(const char *name, T *&prop, bool followChain) const
+      {
+        Atom atom = findName(name);
+        if(!atom)
           return false;
 
-        prop = dynamic_cast<T *>(myprop);
-        if (prop == 0) {
+        const IndexEntry *entry = findIndexEntry(atom, followChain);
+        if(!entry || entry->type != T::kTypeCode)
           return false;
-        }
+
+        // only PropertyTemplate derives from Property, so the type says what it is
+        prop = static_cast<T *>(entry->property);
         return true;
       }
 
@@ -476,22 +712,28 @@ namespace OFX {
           return;
         }
 
+        Property *prop = 0;
         switch (spec.type) {
         case eInt: 
-          _props[spec.name] = new Int(spec.name, spec.dimension, spec.readonly, spec.defaultValue?atoi(spec.defaultValue):0);
+          prop = new Int(spec.name, spec.dimension, spec.readonly, spec.defaultValue?atoi(spec.defaultValue):0);
           break;
         case eDouble: 
-          _props[spec.name] = new Double(spec.name, spec.dimension, spec.readonly, spec.defaultValue?atof(spec.defaultValue):0);
+          prop = new Double(spec.name, spec.dimension, spec.readonly, spec.defaultValue?atof(spec.defaultValue):0);
           break;
         case eString: 
-          _props[spec.name] = new String(spec.name, spec.dimension, spec.readonly, spec.defaultValue?spec.defaultValue:"");
+          prop = new String(spec.name, spec.dimension, spec.readonly, spec.defaultValue?spec.defaultValue:"");
           break;
         case ePointer: 
-          _props[spec.name] = new Pointer(spec.name, spec.dimension, spec.readonly, (void*)spec.defaultValue);
+          prop = new Pointer(spec.name, spec.dimension, spec.readonly, (void*)spec.defaultValue);
           break;
         default: // XXX  error - unrecognised type
           break;
         }
+
+        if(prop) {
+          _props[spec.name] = prop;
+          indexProperty(prop);
+        }
       }
 
       void Set::addProperties(const PropSpec spec[]) 
@@ -509,25 +751,32 @@ namespace OFX {
         if(t != _props.end())
            delete t->second;
         _props[prop->getName()] = prop;
+        indexProperty(prop);
       }
 
       /// empty ctor
       Set::Set()
         : _magic(kMagic)
+        , _indexCount(0)
         , _chainedSet(NULL) 
+        , _kind("")
       {
       }
 
       Set::Set(const PropSpec spec[])
         : _magic(kMagic)
+        , _indexCount(0)
         , _chainedSet(NULL) 
+        , _kind("")
       {
         addProperties(spec);
       }
 
       Set::Set(const Set &other) 
         : _magic(kMagic)
+        , _indexCount(0)
         , _chainedSet(NULL) 
+        , _kind(other._kind)
       {
         bool failed = false;
 
@@ -541,6 +790,7 @@ namespace OFX {
               break;
             }
             _props[i->first] = copyProp;
+            indexProperty(copyProp);
           }
         
         if (failed) {
@@ -550,6 +800,8 @@ namespace OFX {
             delete j->second;
           }
           _props.clear();
+          _index.clear();
+          _indexCount = 0;
         }
       }
 
@@ -562,6 +814,52 @@ namespace OFX {
         }
       }
 
+      /// reset all our properties to their defaults
+      void Set::reset()
+      {
+        for(PropertyMap::iterator i = _props.begin(); i != _props.end(); ++i) {
+          i->second->reset();
+        }
+      }
+
+      SetPool::SetPool(const PropSpec *spec)
+        : _prototype(spec)
+      {
+      }
+
+      SetPool::SetPool(const Set &prototype)
+        : _prototype(prototype)
+      {
+      }
+
+      SetPool::~SetPool()
+      {
+        for(size_t i = 0; i < _free.size(); ++i)
+          delete _free[i];
+      }
+
+      Set *SetPool::acquire()
+      {
+        {
+          MultiThread::ScopedLock lock(_lock);
+          if(!_free.empty()) {
+            Set *set = _free.back();
+            _free.pop_back();
+            return set;
+          }
+        }
+        return new Set(_prototype);
+      }
+
+      void SetPool::release(Set *set)
+      {
+        if(!set)
+          return;
+        set->reset();
+        MultiThread::ScopedLock lock(_lock);
+        _free.push_back(set);
+      }
+
       /// set a particular property
       template<class T> void Set::setProperty(const std::string &property, int index, const typename T::Type &value) 
       {
@@ -766,8 +1064,8 @@ namespace OFX {
       /// get the dimension of a particular property
       int Set::getDimension(const std::string &property) const
       {
-        Property *prop = 0;
-        if(fetchTypedProperty(property, prop, true)) {
+        Property *prop = fetchProperty(property, true);
+        if(prop) {
           return  prop->getDimension();
         }
         return 0;
@@ -790,11 +1088,47 @@ namespace OFX {
         return -1;
       }
       
+      /// times a suite call for the profiler, does nothing if the profiler is off
+      class ProfileScope {
+        const char *_name;
+        const char *_kind;
+        double      _start;
+
+        ProfileScope(const ProfileScope &);
+        ProfileScope &operator=(const ProfileScope &);
+      public :
+        ProfileScope(OfxPropertySetHandle properties, const char *name)
+          : _name(0)
+          , _kind(0)
+          , _start(0)
+        {
+          if(!Profiler::isEnabled())
+            return;
+          Set *thisSet = reinterpret_cast<Set*>(properties);
+          _kind = (thisSet && thisSet->verifyMagic()) ? thisSet->getKind() : "(bad handle)";
+          _name = name ? name : "(null)";
+          _start = GetTimeInSeconds();
+        }
+
+        ~ProfileScope()
+        {
+          if(!_name)
+            return;
+          double seconds = GetTimeInSeconds() - _start;
+          try {
+            Profiler::record(internName(_name), _kind, Profiler::getCurrentAction(), seconds);
+          }
+          catch(...) {
+          }
+        }
+      };
+
       /// static functions for the suite
       template<class T> static OfxStatus propSet(OfxPropertySetHandle properties,
                                                  const char *property,
                                                  int index,
                                                  typename T::APIType value) {          
+        ProfileScope profile(properties, property);
 #       ifdef OFX_DEBUG_PROPERTIES
         std::cout << "OFX: propSet - " << properties << ' ' << property << "[" << index << "] = " << value << " ...";
 #       endif
@@ -836,6 +1170,7 @@ namespace OFX {
                                                 const char *property,
                                                 int count,
                                                 const typename T::APIType *values) {
+        ProfileScope profile(properties, property);
 #       ifdef OFX_DEBUG_PROPERTIES
         std::cout << "OFX: propSetN - " << properties << ' ' << property << "[0.." << count-1 << "] = ";
         for (int i = 0; i < count; ++i) {
@@ -883,6 +1218,7 @@ namespace OFX {
                                                const char *property,
                                                int index,
                                                typename T::APIType *value) {
+        ProfileScope profile(properties, property);
 #       ifdef OFX_DEBUG_PROPERTIES
         std::cout << "OFX: propGet - " << properties << ' ' << property << "[" << index << "] = ...";
 #       endif
@@ -925,6 +1261,7 @@ namespace OFX {
                                             const char *property,
                                             int count,
                                             typename T::APIType *values) {
+        ProfileScope profile(properties, property);
 #       ifdef OFX_DEBUG_PROPERTIES
         std::cout << "OFX: propGetN - " << properties << ' ' << property << "[0.." << count-1 << "] = ...";
 #       endif
@@ -969,6 +1306,7 @@ namespace OFX {
       
       /// static functions for the suite
       static OfxStatus propReset(OfxPropertySetHandle properties, const char *property) {
+        ProfileScope profile(properties, property);
 #       ifdef OFX_DEBUG_PROPERTIES
         std::cout << "OFX: propReset - " << properties << ' ' << property << " ...";
 #       endif
@@ -1007,6 +1345,7 @@ namespace OFX {
       
       /// static functions for the suite
       static OfxStatus propGetDimension(OfxPropertySetHandle properties, const char *property, int *count) {
+        ProfileScope profile(properties, property);
 #       ifdef OFX_DEBUG_PROPERTIES
         std::cout << "OFX: propGetDimension - " << properties << ' ' << property << " ...";
 #       endif
@@ -1073,6 +1412,54 @@ namespace OFX {
         return NULL;
       }
 
+      /// get many properties in one call, each as the propGetN of its type would
+      static OfxStatus propGetBatch(OfxPropertySetHandle properties, OfxPropertyBatchEntry *entries, int count)
+      {
+        Set *thisSet = reinterpret_cast<Set*>(properties);
+        if(!thisSet || !thisSet->verifyMagic()) {
+          return kOfxStatErrBadHandle;
+        }
+
+        OfxStatus stat = kOfxStatOK;
+        for(int i = 0; i < count; ++i) {
+          OfxPropertyBatchEntry &entry = entries[i];
+          switch(entry.type) {
+          case kOfxPropertyBatchTypeInt:
+            entry.status = propGetN<IntValue>(properties, entry.name, entry.count, (int *)entry.values);
+            break;
+          case kOfxPropertyBatchTypeDouble:
+            entry.status = propGetN<DoubleValue>(properties, entry.name, entry.count, (double *)entry.values);
+            break;
+          case kOfxPropertyBatchTypeString:
+            entry.status = propGetN<StringValue>(properties, entry.name, entry.count, (const char **)entry.values);
+            break;
+          case kOfxPropertyBatchTypePointer:
+            entry.status = propGetN<PointerValue>(properties, entry.name, entry.count, (void **)entry.values);
+            break;
+          default:
+            entry.status = kOfxStatErrValue;
+            break;
+          }
+          if(entry.status != kOfxStatOK) {
+            stat = kOfxStatFailed;
+          }
+        }
+        return stat;
+      }
+
+      /// the suite that gets many properties in one call
+      struct OfxPropertyBatchSuiteV1 gBatchSuite = {
+        propGetBatch
+      };
+
+      /// return the OFX function suite that gets many properties in one call
+      const void *GetBatchSuite(int version)
+      {
+        if(version == 1)
+          return (void *)(&gBatchSuite);
+        return NULL;
+      }
+
     }
   }
 }
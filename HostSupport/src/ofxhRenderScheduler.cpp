@@ -0,0 +1,363 @@
+
+/*
+Software License :
+
+Copyright (c) 2007-2009, The Open Effects Association Ltd. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+* Neither the name The Open Effects Association Ltd, nor the names of its 
+contributors may be used to endorse or promote products derived from this
+software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <math.h>
+#include <map>
+
+// ofx
+#include "ofxCore.h"
+#include "ofxImageEffect.h"
+#ifdef OFX_EXTENSIONS_NUKE
+#include "nuke/fnOfxExtensions.h"
+#endif
+
+// ofx host
+#include "ofxhBinary.h"
+#include "ofxhPropertySuite.h"
+#include "ofxhClip.h"
+#include "ofxhImageEffect.h"
+#include "ofxhPluginAPICache.h"
+#include "ofxhPluginCache.h"
+#include "ofxhImageEffectAPI.h"
+#include "ofxhRenderScheduler.h"
+
+namespace OFX {
+
+  namespace Host {
+
+    namespace ImageEffect {
+
+      ////////////////////////////////////////////////////////////////////////////////
+      // render args
+
+      RenderArgs::RenderArgs()
+        : startFrame(0)
+        , endFrame(0)
+        , step(1)
+        , field(kOfxImageFieldNone)
+        , interactive(false)
+        , interactiveRender(false)
+        , draftRender(false)
+#     ifdef OFX_SUPPORTS_OPENGLRENDER
+        , openGLRender(false)
+#      ifdef OFX_EXTENSIONS_NATRON
+        , contextData(NULL)
+#      endif
+#     endif
+#     if defined(OFX_EXTENSIONS_VEGAS) || defined(OFX_EXTENSIONS_NUKE)
+        , view(0)
+#     endif
+#     ifdef OFX_EXTENSIONS_VEGAS
+        , nViews(1)
+#     endif
+      {
+        renderWindow.x1 = renderWindow.y1 = renderWindow.x2 = renderWindow.y2 = 0;
+        renderScale.x = renderScale.y = 1.;
+#     ifdef OFX_EXTENSIONS_NUKE
+        planes.push_back(kFnOfxImagePlaneColour);
+#     endif
+      }
+
+      int RenderArgs::getNFrames() const
+      {
+        if(endFrame < startFrame || step <= 0)
+          return 0;
+        // allow for rounding errors in fractional steps
+        return int(floor((endFrame - startFrame) / step + 1e-6)) + 1;
+      }
+
+      ////////////////////////////////////////////////////////////////////////////////
+      // unsafe plugin locks
+
+      /// the lock that stops two instances of an unsafe plugin rendering at once
+      static MultiThread::Mutex &getUnsafeRenderLock(ImageEffectPlugin *plugin)
+      {
+        static MultiThread::Mutex mapLock;
+        static std::map<ImageEffectPlugin *, MultiThread::Mutex *> locks;
+
+        mapLock.lock();
+        MultiThread::Mutex *&lock = locks[plugin];
+        if(!lock)
+          lock = new MultiThread::Mutex;
+        mapLock.unlock();
+        return *lock;
+      }
+
+      /// did the action succeed
+      static bool statusOK(OfxStatus stat)
+      {
+        return stat == kOfxStatOK || stat == kOfxStatReplyDefault;
+      }
+
+      ////////////////////////////////////////////////////////////////////////////////
+      // render scheduler
+
+      /// what the render threads share
+      struct RenderScheduler::RenderState {
+        RenderScheduler    *scheduler;
+        const RenderArgs   *args;
+        ThreadingEnum       threading;
+        int                 nFrames;
+        MultiThread::Mutex  lock;      ///< guards everything below
+        int                 nextFrame; ///< next frame to be claimed by a thread
+        OfxStatus           status;    ///< first failure
+
+        /// claim the next frame to render, returns false if there are none left or we have stopped
+        bool claimFrame(int &frame)
+        {
+          lock.lock();
+          bool ok = statusOK(status) && nextFrame < nFrames;
+          if(ok)
+            frame = nextFrame++;
+          lock.unlock();
+          return ok;
+        }
+
+        /// record a status, we keep the first failure
+        void setStatus(OfxStatus stat)
+        {
+          if(statusOK(stat))
+            return;
+          lock.lock();
+          if(statusOK(status))
+            status = stat;
+          lock.unlock();
+        }
+      };
+
+      RenderScheduler::RenderScheduler(Instance &instance, MultiThread::ThreadPool &pool)
+        : _instance(instance)
+        , _pool(pool)
+      {
+      }
+
+      RenderScheduler::~RenderScheduler()
+      {
+        clearRenderInstances();
+      }
+
+      void RenderScheduler::clearRenderInstances()
+      {
+        for(size_t i = 0; i < _renderInstances.size(); ++i) {
+          _renderInstances[i]->destroyInstanceAction();
+          delete _renderInstances[i];
+        }
+        _renderInstances.clear();
+      }
+
+      Instance *RenderScheduler::newRenderInstance()
+      {
+        return 0;
+      }
+
+      RenderScheduler::ThreadingEnum RenderScheduler::getThreading() const
+      {
+        if(_instance.requiresSequentialRender())
+          return eThreadingSerial;
+
+        const std::string &safety = _instance.getRenderThreadSafety();
+        if(safety == kOfxImageEffectRenderFullySafe)
+          return eThreadingSharedInstance;
+        if(safety == kOfxImageEffectRenderInstanceSafe)
+          return eThreadingInstancePerThread;
+        return eThreadingSerial;
+      }
+
+      OfxStatus RenderScheduler::beginRenderAction(Instance &instance, const RenderArgs &args, bool sequentialRender)
+      {
+        return instance.beginRenderAction(args.startFrame, args.endFrame, args.step,
+                                          args.interactive, args.renderScale, sequentialRender, args.interactiveRender,
+#                                         ifdef OFX_SUPPORTS_OPENGLRENDER
+                                          args.openGLRender,
+#                                          ifdef OFX_EXTENSIONS_NATRON
+                                          args.contextData,
+#                                          endif
+#                                         endif
+                                          args.draftRender
+#                                         ifdef OFX_EXTENSIONS_NUKE
+                                          , args.view
+#                                         endif
+                                          );
+      }
+
+      OfxStatus RenderScheduler::endRenderAction(Instance &instance, const RenderArgs &args, bool sequentialRender)
+      {
+        return instance.endRenderAction(args.startFrame, args.endFrame, args.step,
+                                        args.interactive, args.renderScale, sequentialRender, args.interactiveRender,
+#                                       ifdef OFX_SUPPORTS_OPENGLRENDER
+                                        args.openGLRender,
+#                                        ifdef OFX_EXTENSIONS_NATRON
+                                        args.contextData,
+#                                        endif
+#                                       endif
+                                        args.draftRender
+#                                       ifdef OFX_EXTENSIONS_NUKE
+                                        , args.view
+#                                       endif
+                                        );
+      }
+
+      OfxStatus RenderScheduler::renderAction(Instance &instance, OfxTime time, const OfxRectI &renderWindow,
+                                              const RenderArgs &args, bool sequentialRender)
+      {
+        return instance.renderAction(time, args.field, renderWindow, args.renderScale,
+                                     sequentialRender, args.interactiveRender,
+#                                    ifdef OFX_SUPPORTS_OPENGLRENDER
+                                     args.openGLRender,
+#                                     ifdef OFX_EXTENSIONS_NATRON
+                                     args.contextData,
+#                                     endif
+#                                    endif
+                                     args.draftRender
+#                                    if defined(OFX_EXTENSIONS_VEGAS) || defined(OFX_EXTENSIONS_NUKE)
+                                     , args.view
+#                                    endif
+#                                    ifdef OFX_EXTENSIONS_VEGAS
+                                     , args.nViews
+#                                    endif
+#                                    ifdef OFX_EXTENSIONS_NUKE
+                                     , args.planes
+#                                    endif
+                                     );
+      }
+
+      OfxStatus RenderScheduler::renderFrame(Instance &instance, OfxTime time, const RenderArgs &args, bool sequentialRender)
+      {
+        return renderAction(instance, time, args.renderWindow, args, sequentialRender);
+      }
+
+      OfxStatus RenderScheduler::renderSerially(const RenderArgs &args)
+      {
+        // unsafe plugins may only render one instance at a time, anywhere
+        bool unsafe = _instance.getRenderThreadSafety() == kOfxImageEffectRenderUnsafe;
+        MultiThread::ScopedLock lock(unsafe ? &getUnsafeRenderLock(_instance.getPlugin()) : 0);
+
+        OfxStatus st = beginRenderAction(_instance, args, true);
+        if(!statusOK(st))
+          return st;
+
+        int nFrames = args.getNFrames();
+        for(int i = 0; i < nFrames && statusOK(st) && !_instance.abort(); ++i) {
+          try {
+            st = renderFrame(_instance, args.getFrame(i), args, true);
+          }
+          catch(...) {
+            st = kOfxStatFailed;
+          }
+        }
+
+        OfxStatus endSt = endRenderAction(_instance, args, true);
+        return statusOK(st) ? endSt : st;
+      }
+
+      void RenderScheduler::renderThreadFunction(unsigned int threadIndex, unsigned int /*threadMax*/, void *customArg)
+      {
+        RenderState &state = *static_cast<RenderState *>(customArg);
+        RenderScheduler &me = *state.scheduler;
+        const RenderArgs &args = *state.args;
+
+        // thread 0 always uses the main instance
+        bool ownInstance = state.threading == eThreadingInstancePerThread;
+        Instance &instance = (ownInstance && threadIndex > 0) ? *me._renderInstances[threadIndex - 1] : me._instance;
+
+        if(ownInstance) {
+          OfxStatus st = beginRenderAction(instance, args, false);
+          state.setStatus(st);
+          if(!statusOK(st))
+            return;
+        }
+
+        int frame;
+        while(!me._instance.abort() && state.claimFrame(frame)) {
+          try {
+            state.setStatus(me.renderFrame(instance, args.getFrame(frame), args, false));
+          }
+          catch(...) {
+            state.setStatus(kOfxStatFailed);
+          }
+        }
+
+        if(ownInstance)
+          state.setStatus(endRenderAction(instance, args, false));
+      }
+
+      OfxStatus RenderScheduler::render(const RenderArgs &args)
+      {
+        int nFrames = args.getNFrames();
+        if(nFrames <= 0)
+          return kOfxStatOK;
+
+        ThreadingEnum threading = getThreading();
+        unsigned int nThreads = _pool.getNumThreads();
+        if(nThreads > (unsigned int) nFrames)
+          nThreads = (unsigned int) nFrames;
+
+        if(threading == eThreadingInstancePerThread) {
+          // make sure there are enough instances to go round, made here as creation need not be thread safe
+          while(_renderInstances.size() + 1 < nThreads) {
+            Instance *instance = newRenderInstance();
+            if(!instance)
+              break;
+            _renderInstances.push_back(instance);
+          }
+          if(nThreads > _renderInstances.size() + 1)
+            nThreads = (unsigned int) _renderInstances.size() + 1;
+        }
+
+        if(threading == eThreadingSerial || nThreads <= 1)
+          return renderSerially(args);
+
+        RenderState state;
+        state.scheduler = this;
+        state.args = &args;
+        state.threading = threading;
+        state.nFrames = nFrames;
+        state.nextFrame = 0;
+        state.status = kOfxStatOK;
+
+        if(threading == eThreadingSharedInstance) {
+          OfxStatus st = beginRenderAction(_instance, args, false);
+          if(!statusOK(st))
+            return st;
+        }
+
+        state.setStatus(_pool.run(renderThreadFunction, nThreads, &state));
+
+        if(threading == eThreadingSharedInstance)
+          state.setStatus(endRenderAction(_instance, args, false));
+
+        return state.status;
+      }
+
+    } // namespace ImageEffect
+
+  } // namespace Host
+
+} // namespace OFX
@@ -0,0 +1,355 @@
+
+/*
+Software License :
+
+Copyright (c) 2007-2009, The Open Effects Association Ltd. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+* Neither the name The Open Effects Association Ltd, nor the names of its 
+contributors may be used to endorse or promote products derived from this
+software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <math.h>
+
+// ofx
+#include "ofxCore.h"
+#include "ofxImageEffect.h"
+
+// ofx host
+#include "ofxhBinary.h"
+#include "ofxhPropertySuite.h"
+#include "ofxhClip.h"
+#include "ofxhImageEffect.h"
+#include "ofxhRenderScheduler.h"
+#include "ofxhTileRenderer.h"
+
+namespace OFX {
+
+  namespace Host {
+
+    namespace ImageEffect {
+
+      /// did the action succeed
+      static bool statusOK(OfxStatus stat)
+      {
+        return stat == kOfxStatOK || stat == kOfxStatReplyDefault;
+      }
+
+      /// bytes in a pixel of the given depth and components, guessing at custom ones
+      static int bytesPerPixel(const std::string &depth, const std::string &components)
+      {
+        int bytesPerComponent = 4;
+        if(depth == kOfxBitDepthByte)
+          bytesPerComponent = 1;
+        else if(depth == kOfxBitDepthShort || depth == kOfxBitDepthHalf)
+          bytesPerComponent = 2;
+
+        int nComponents = 4;
+        if(components == kOfxImageComponentAlpha)
+          nComponents = 1;
+        else if(components == kOfxImageComponentRGB)
+          nComponents = 3;
+
+        return bytesPerComponent * nComponents;
+      }
+
+      /// what the tile threads share
+      struct TileRenderer::TileState {
+        TileRenderer                  *renderer;
+        Instance                      *instance;
+        OfxTime                        time;
+        const RenderArgs              *args;
+        bool                           sequentialRender;
+        const std::vector<RenderTile> *tiles;
+        MultiThread::Mutex             lock;      ///< guards everything below
+        size_t                         nextTile;  ///< next tile to be claimed by a thread
+        OfxStatus                      status;    ///< first failure
+
+        /// claim the next tile to render, returns false if there are none left or we have stopped
+        bool claimTile(size_t &tile)
+        {
+          lock.lock();
+          bool ok = statusOK(status) && nextTile < tiles->size();
+          if(ok)
+            tile = nextTile++;
+          lock.unlock();
+          return ok;
+        }
+
+        /// record a status, we keep the first failure
+        void setStatus(OfxStatus stat)
+        {
+          if(statusOK(stat))
+            return;
+          lock.lock();
+          if(statusOK(status))
+            status = stat;
+          lock.unlock();
+        }
+      };
+
+      /// the input images fetched for the tile a thread is rendering
+      struct TilePrefetch {
+        OfxTime                            time;
+        const RenderTile                  *tile;
+        std::map<ClipInstance *, Image *>  images;
+        TilePrefetch                      *previous; ///< a nested render may pick up a tile while rendering another
+      };
+
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1900)
+      static thread_local TilePrefetch *gTilePrefetch = 0;
+#else
+      // without C++11 the thread pool runs everything on the calling thread
+      static TilePrefetch *gTilePrefetch = 0;
+#endif
+
+      /// is b inside a
+      static bool contains(const OfxRectD &a, const OfxRectD &b)
+      {
+        return b.x1 >= a.x1 && b.x2 <= a.x2 && b.y1 >= a.y1 && b.y2 <= a.y2;
+      }
+
+      TileRenderer::TileRenderer(MultiThread::ThreadPool &pool)
+        : _pool(pool)
+        , _tileBytes(512 * 1024)
+        , _tileWidth(0)
+        , _tileHeight(0)
+        , _prefetchInputs(true)
+      {
+      }
+
+      TileRenderer::~TileRenderer()
+      {
+        for(std::map<Instance *, MultiThread::Mutex *>::iterator i = _roiLocks.begin(); i != _roiLocks.end(); ++i)
+          delete i->second;
+      }
+
+      MultiThread::Mutex &TileRenderer::getRoILock(Instance &instance)
+      {
+        MultiThread::ScopedLock lock(_roiLocksLock);
+        MultiThread::Mutex *&roiLock = _roiLocks[&instance];
+        if(!roiLock)
+          roiLock = new MultiThread::Mutex;
+        return *roiLock;
+      }
+
+      Image *TileRenderer::getPrefetchedImage(ClipInstance *clip, OfxTime time, const OfxRectD *bounds)
+      {
+        TilePrefetch *prefetch = gTilePrefetch;
+        if(!prefetch || prefetch->time != time)
+          return 0;
+        std::map<ClipInstance *, Image *>::const_iterator found = prefetch->images.find(clip);
+        if(found == prefetch->images.end())
+          return 0;
+        if(bounds) {
+          std::map<ClipInstance *, OfxRectD>::const_iterator roi = prefetch->tile->rois.find(clip);
+          if(roi == prefetch->tile->rois.end() || !contains(roi->second, *bounds))
+            return 0;
+        }
+        found->second->addReference();
+        return found->second;
+      }
+
+      bool TileRenderer::canTile(const Instance &instance)
+      {
+        if(!instance.supportsTiles())
+          return false;
+        ClipInstance *output = instance.getClip(kOfxImageEffectOutputClipName);
+        return output && output->supportsTiles();
+      }
+
+      void TileRenderer::getTileSize(Instance &instance, int &width, int &height) const
+      {
+        if(_tileWidth > 0 && _tileHeight > 0) {
+          width = _tileWidth;
+          height = _tileHeight;
+          return;
+        }
+
+        // square tiles holding about _tileBytes of output, a multiple of 16 pixels on a side
+        int pixelBytes = 16;
+        ClipInstance *output = instance.getClip(kOfxImageEffectOutputClipName);
+        if(output)
+          pixelBytes = bytesPerPixel(output->getPixelDepth(), output->getComponents());
+        int side = int(sqrt(double(_tileBytes) / pixelBytes)) & ~15;
+        width = height = side > 16 ? side : 16;
+      }
+
+      void TileRenderer::splitIntoTiles(const OfxRectI &window, int tileWidth, int tileHeight, std::vector<OfxRectI> &tiles)
+      {
+        tiles.clear();
+        if(tileWidth <= 0 || tileHeight <= 0)
+          return;
+        for(int y = window.y1; y < window.y2; y += tileHeight) {
+          for(int x = window.x1; x < window.x2; x += tileWidth) {
+            OfxRectI tile;
+            tile.x1 = x;
+            tile.y1 = y;
+            tile.x2 = x + tileWidth < window.x2 ? x + tileWidth : window.x2;
+            tile.y2 = y + tileHeight < window.y2 ? y + tileHeight : window.y2;
+            tiles.push_back(tile);
+          }
+        }
+      }
+
+      OfxStatus TileRenderer::prepareTile(Instance &/*instance*/, OfxTime /*time*/, const RenderTile &/*tile*/)
+      {
+        return kOfxStatOK;
+      }
+
+      void TileRenderer::tileRendered(Instance &/*instance*/, OfxTime /*time*/, const RenderTile &/*tile*/, OfxStatus /*stat*/)
+      {
+      }
+
+      OfxStatus TileRenderer::renderTile(Instance &instance, OfxTime time, const RenderTile &tile, const RenderArgs &args, bool sequentialRender)
+      {
+        OfxStatus st = prepareTile(instance, time, tile);
+        if(!statusOK(st)) {
+          tileRendered(instance, time, tile, st);
+          return st;
+        }
+
+        // fetch just the regions of the inputs the tile needs, an input that can't be fetched is
+        // left for the plugin to fetch itself
+        TilePrefetch prefetch;
+        prefetch.time = time;
+        prefetch.tile = &tile;
+        prefetch.previous = gTilePrefetch;
+        if(_prefetchInputs) {
+          for(std::map<ClipInstance *, OfxRectD>::const_iterator i = tile.rois.begin(); i != tile.rois.end(); ++i) {
+            ClipInstance *clip = i->first;
+            if(!clip || clip->isOutput() || !clip->getConnected())
+              continue;
+            try {
+              Image *image = clip->getImage(time, &i->second);
+              if(image)
+                prefetch.images[clip] = image;
+            }
+            catch(...) {}
+          }
+        }
+
+        gTilePrefetch = &prefetch;
+        try {
+          st = RenderScheduler::renderAction(instance, time, tile.window, args, sequentialRender);
+        }
+        catch(...) {
+          st = kOfxStatFailed;
+        }
+        gTilePrefetch = prefetch.previous;
+
+        for(std::map<ClipInstance *, Image *>::iterator i = prefetch.images.begin(); i != prefetch.images.end(); ++i)
+          i->second->releaseReference();
+
+        tileRendered(instance, time, tile, st);
+        return st;
+      }
+
+      void TileRenderer::tileThreadFunction(unsigned int /*threadIndex*/, unsigned int /*threadMax*/, void *customArg)
+      {
+        TileState &state = *static_cast<TileState *>(customArg);
+
+        size_t tile;
+        while(!state.instance->abort() && state.claimTile(tile)) {
+          try {
+            state.setStatus(state.renderer->renderTile(*state.instance, state.time, (*state.tiles)[tile],
+                                                       *state.args, state.sequentialRender));
+          }
+          catch(...) {
+            state.setStatus(kOfxStatFailed);
+          }
+        }
+      }
+
+      OfxStatus TileRenderer::renderFrame(Instance &instance, OfxTime time, const RenderArgs &args, bool sequentialRender)
+      {
+        if(!canTile(instance))
+          return RenderScheduler::renderAction(instance, time, args.renderWindow, args, sequentialRender);
+
+        int tileWidth, tileHeight;
+        getTileSize(instance, tileWidth, tileHeight);
+        std::vector<OfxRectI> windows;
+        splitIntoTiles(args.renderWindow, tileWidth, tileHeight, windows);
+
+        // pixel to canonical coordinates
+        ClipInstance *output = instance.getClip(kOfxImageEffectOutputClipName);
+        double par = output ? output->getAspectRatio() : 1.;
+        if(par <= 0.)
+          par = 1.;
+
+        // find the regions of interest up front on this thread. Only the render action is
+        // guaranteed to be callable concurrently, but a RenderScheduler may be rendering other
+        // frames of a fully safe effect on this instance, so hold the instance's lock
+        std::vector<RenderTile> tiles(windows.size());
+        {
+          MultiThread::ScopedLock roiLock(getRoILock(instance));
+          for(size_t i = 0; i < windows.size(); ++i) {
+            RenderTile &tile = tiles[i];
+            tile.window = windows[i];
+
+            OfxRectD roi;
+            roi.x1 = tile.window.x1 * par / args.renderScale.x;
+            roi.x2 = tile.window.x2 * par / args.renderScale.x;
+            roi.y1 = tile.window.y1 / args.renderScale.y;
+            roi.y2 = tile.window.y2 / args.renderScale.y;
+
+            OfxStatus st = instance.getRegionOfInterestAction(time, args.renderScale,
+#ifdef OFX_EXTENSIONS_NUKE
+                                                              args.view,
+#endif
+                                                              roi, tile.rois);
+            if(!statusOK(st))
+              return st;
+          }
+        }
+
+        // only fully safe effects can have several renders going on the one instance
+        unsigned int nThreads = 1;
+        if(instance.getRenderThreadSafety() == kOfxImageEffectRenderFullySafe) {
+          nThreads = _pool.getNumThreads();
+          if(nThreads > tiles.size())
+            nThreads = (unsigned int) tiles.size();
+        }
+
+        TileState state;
+        state.renderer = this;
+        state.instance = &instance;
+        state.time = time;
+        state.args = &args;
+        state.sequentialRender = sequentialRender;
+        state.tiles = &tiles;
+        state.nextTile = 0;
+        state.status = kOfxStatOK;
+
+        if(nThreads > 1)
+          state.setStatus(_pool.run(tileThreadFunction, nThreads, &state));
+        else
+          tileThreadFunction(0, 1, &state);
+
+        return state.status;
+      }
+
+    } // namespace ImageEffect
+
+  } // namespace Host
+
+} // namespace OFX
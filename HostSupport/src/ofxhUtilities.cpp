@@ -31,6 +31,9 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "ofxhUtilities.h"
 #ifdef WINDOWS
 #include <windows.h>
+#else
+#include <time.h>
+#include <sys/time.h>
 #endif
 
 namespace OFX {
@@ -64,6 +67,25 @@ namespace OFX {
     }
   }
 
+  /// seconds since some arbitrary point in the past
+  double GetTimeInSeconds()
+  {
+#if defined(WINDOWS)
+    LARGE_INTEGER frequency, count;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&count);
+    return double(count.QuadPart) / double(frequency.QuadPart);
+#elif defined(CLOCK_MONOTONIC)
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return double(now.tv_sec) + double(now.tv_nsec) * 1e-9;
+#else
+    struct timeval now;
+    gettimeofday(&now, 0);
+    return double(now.tv_sec) + double(now.tv_usec) * 1e-6;
+#endif
+  }
+
 # ifdef WINDOWS
   std::wstring utf8_to_utf16(const std::string& str)
   {
@@ -214,6 +214,31 @@ namespace OFX {
   typedef std::map<std::string, OfxPlugInfo> OfxPlugInfoMap;
   OfxPlugInfoMap plugInfoMap;
 
+  // The same entries, keyed by the address of the plugin UID string. FactoryMainEntryHelper::mainEntry always passes
+  // that pointer, so the per action lookup in mainEntryStr never has to compare strings.
+  typedef std::map<const char*, OfxPlugInfo*> OfxPlugInfoByUIDMap;
+  OfxPlugInfoByUIDMap plugInfoByUID;
+
+  static void addPlugInfo(OFX::PluginFactory* factory, const std::string& id, const OfxPlugInfo& info)
+  {
+    OfxPlugInfo& entry = plugInfoMap[id];
+    entry = info;
+    plugInfoByUID[factory->getUID().c_str()] = &entry;
+  }
+
+  static OfxPlugInfo* findPlugInfo(const char* uid)
+  {
+    OfxPlugInfoByUIDMap::const_iterator it = plugInfoByUID.find(uid);
+    if (it != plugInfoByUID.end()) {
+      return it->second;
+    }
+    OfxPlugInfoMap::iterator it2 = plugInfoMap.find(uid);
+    if (it2 != plugInfoMap.end()) {
+      return &it2->second;
+    }
+    return NULL;
+  }
+
   typedef std::vector<OfxPlugin*> OfxPluginArray;
   OfxPluginArray ofxPlugs;
 
@@ -268,8 +293,10 @@ namespace OFX {
     OfxHost               *gHost = 0;
     OfxImageEffectSuiteV1 *gEffectSuite = 0;
     OfxPropertySuiteV1    *gPropSuite = 0;
+    OfxPropertyBatchSuiteV1 *gPropBatchSuite = 0;
     OfxInteractSuiteV1    *gInteractSuite = 0;
     OfxParameterSuiteV1   *gParamSuite = 0;
+    OfxParameterBatchSuiteV1 *gParamBatchSuite = 0;
     OfxMemorySuiteV1      *gMemorySuite = 0;
     OfxMultiThreadSuiteV1 *gThreadSuite = 0;
     OfxMessageSuiteV1     *gMessageSuite = 0;
@@ -1571,11 +1598,26 @@ namespace OFX {
   {
     OFX::Validation::validateImageBaseProperties(props);
 
-    // and fetch all the properties
-    _rowBytes         = _imageProps.propGetInt(kOfxImagePropRowBytes);
-    _pixelAspectRatio = _imageProps.propGetDouble(kOfxImagePropPixelAspectRatio);;
-      
-    std::string str  = _imageProps.propGetString(kOfxImageEffectPropComponents);
+    // and fetch all the properties, in one go if the host lets us
+    _rowBytes = 0;
+    _pixelAspectRatio = 0.;
+    _regionOfDefinition.x1 = _regionOfDefinition.y1 = _regionOfDefinition.x2 = _regionOfDefinition.y2 = 0;
+    _bounds.x1 = _bounds.y1 = _bounds.x2 = _bounds.y2 = 0;
+    const char *components = 0, *depth = 0, *premult = 0, *field = 0, *uniqueID = 0;
+    OfxPropertyBatchEntry batch[] = {
+      { kOfxImagePropRowBytes,                kOfxPropertyBatchTypeInt,    1, &_rowBytes,              kOfxStatOK },
+      { kOfxImagePropPixelAspectRatio,        kOfxPropertyBatchTypeDouble, 1, &_pixelAspectRatio,      kOfxStatOK },
+      { kOfxImageEffectPropComponents,        kOfxPropertyBatchTypeString, 1, &components,             kOfxStatOK },
+      { kOfxImageEffectPropPixelDepth,        kOfxPropertyBatchTypeString, 1, &depth,                  kOfxStatOK },
+      { kOfxImageEffectPropPreMultiplication, kOfxPropertyBatchTypeString, 1, &premult,                kOfxStatOK },
+      { kOfxImagePropRegionOfDefinition,      kOfxPropertyBatchTypeInt,    4, &_regionOfDefinition.x1, kOfxStatOK },
+      { kOfxImagePropBounds,                  kOfxPropertyBatchTypeInt,    4, &_bounds.x1,             kOfxStatOK },
+      { kOfxImagePropField,                   kOfxPropertyBatchTypeString, 1, &field,                  kOfxStatOK },
+      { kOfxImagePropUniqueIdentifier,        kOfxPropertyBatchTypeString, 1, &uniqueID,               kOfxStatOK },
+    };
+    _imageProps.propGetBatch(batch, (int)(sizeof(batch) / sizeof(batch[0])));
+
+    std::string str  = components ? components : "";
     _pixelComponents = mapStrToPixelComponentEnum(str);
 
     switch (_pixelComponents) {
@@ -1618,7 +1660,7 @@ namespace OFX {
         break;
     }
 
-    str = _imageProps.propGetString(kOfxImageEffectPropPixelDepth);
+    str = depth ? depth : "";
     _pixelDepth = mapStrToBitDepthEnum(str);
 
     // compute bytes per pixel
@@ -1639,20 +1681,10 @@ namespace OFX {
     case eBitDepthCustom : _pixelBytes *= 0; break;
     }
 
-    str = _imageProps.propGetString(kOfxImageEffectPropPreMultiplication);
+    str = premult ? premult : "";
     _preMultiplication =  mapStrToPreMultiplicationEnum(str);
 
-    _regionOfDefinition.x1 = _imageProps.propGetInt(kOfxImagePropRegionOfDefinition, 0);
-    _regionOfDefinition.y1 = _imageProps.propGetInt(kOfxImagePropRegionOfDefinition, 1);
-    _regionOfDefinition.x2 = _imageProps.propGetInt(kOfxImagePropRegionOfDefinition, 2);
-    _regionOfDefinition.y2 = _imageProps.propGetInt(kOfxImagePropRegionOfDefinition, 3);
-
-    _bounds.x1 = _imageProps.propGetInt(kOfxImagePropBounds, 0);
-    _bounds.y1 = _imageProps.propGetInt(kOfxImagePropBounds, 1);
-    _bounds.x2 = _imageProps.propGetInt(kOfxImagePropBounds, 2);
-    _bounds.y2 = _imageProps.propGetInt(kOfxImagePropBounds, 3);
-
-    str = _imageProps.propGetString(kOfxImagePropField);
+    str = field ? field : "";
     if(str == kOfxImageFieldNone) {
       _field = eFieldNone;
     }
@@ -1670,7 +1702,7 @@ namespace OFX {
       _field = eFieldNone;
     }
 
-    _uniqueID = _imageProps.propGetString(kOfxImagePropUniqueIdentifier);
+    _uniqueID = uniqueID ? uniqueID : "";
 
     _renderScale.x = _renderScale.y = 1.;
     _imageProps.propGetDoubleN(kOfxImageEffectPropRenderScale, &_renderScale.x, 2, false);
@@ -1823,10 +1855,112 @@ namespace OFX {
 #ifdef OFX_EXTENSIONS_VEGAS
     , _pixelOrder(ePixelOrderRGBA)
 #endif
+    , _metaData(NULL)
+    , _metaDataSnapshots(NULL)
   {
     OFX::Validation::validateClipInstanceProperties(_clipProps);
   }
 
+  /** @brief dtor */
+  Clip::~Clip()
+  {
+    const MetaData *m = _metaDataSnapshots;
+    while(m) {
+      const MetaData *next = m->next;
+      delete m;
+      m = next;
+    }
+  }
+
+  /** @brief does it hold the same metadata as other */
+  bool Clip::MetaData::sameAs(const MetaData &other) const
+  {
+    return (pixelDepth == other.pixelDepth &&
+            pixelComponents == other.pixelComponents &&
+            pixelComponentCount == other.pixelComponentCount &&
+            unmappedPixelDepth == other.unmappedPixelDepth &&
+            unmappedPixelComponents == other.unmappedPixelComponents &&
+            preMultiplication == other.preMultiplication &&
+            fieldOrder == other.fieldOrder &&
+            connected == other.connected &&
+            continuousSamples == other.continuousSamples &&
+            pixelAspectRatio == other.pixelAspectRatio &&
+            frameRate == other.frameRate &&
+            frameRange.min == other.frameRange.min &&
+            frameRange.max == other.frameRange.max &&
+            unmappedFrameRate == other.unmappedFrameRate &&
+            unmappedFrameRange.min == other.unmappedFrameRange.min &&
+            unmappedFrameRange.max == other.unmappedFrameRange.max);
+  }
+
+  /** @brief drop the metadata snapshot */
+  void Clip::invalidateMetaData(void)
+  {
+#ifdef OFXS_CLIP_ATOMIC_METADATA
+    _metaData.store(NULL, std::memory_order_release);
+#else
+    _metaData = NULL;
+#endif
+  }
+
+  /** @brief fetch the clip metadata once */
+  void Clip::snapshotMetaData(void)
+  {
+    invalidateMetaData();
+    MetaData m;
+    try {
+      m.connected = isConnected();
+      m.pixelDepth = getPixelDepth();
+      m.pixelComponents = getPixelComponents();
+      m.pixelComponentCount = getPixelComponentCount();
+      m.unmappedPixelDepth = getUnmappedPixelDepth();
+      m.unmappedPixelComponents = getUnmappedPixelComponents();
+      m.preMultiplication = getPreMultiplication();
+      m.fieldOrder = getFieldOrder();
+      m.continuousSamples = hasContinuousSamples();
+      m.pixelAspectRatio = getPixelAspectRatio();
+      m.frameRate = getFrameRate();
+      m.frameRange = getFrameRange();
+      m.unmappedFrameRate = getUnmappedFrameRate();
+      m.unmappedFrameRange = getUnmappedFrameRange();
+    }
+    catch(...) {
+      // the host could not give us everything, keep going through the property suite
+      return;
+    }
+
+    // reuse a snapshot of the same metadata, otherwise add one, snapshots are pushed without a lock as
+    // another thread may be taking one too
+#ifdef OFXS_CLIP_ATOMIC_METADATA
+    const MetaData *head = _metaDataSnapshots.load(std::memory_order_acquire);
+#else
+    const MetaData *head = _metaDataSnapshots;
+#endif
+    const MetaData *snapshot = NULL;
+    for(const MetaData *i = head; i && !snapshot; i = i->next) {
+      if(i->sameAs(m)) {
+        snapshot = i;
+      }
+    }
+    if(!snapshot) {
+      MetaData *added = new MetaData(m);
+      added->next = head;
+#ifdef OFXS_CLIP_ATOMIC_METADATA
+      while(!_metaDataSnapshots.compare_exchange_weak(added->next, added, std::memory_order_release, std::memory_order_acquire)) {
+      }
+#else
+      _metaDataSnapshots = added;
+#endif
+      snapshot = added;
+    }
+
+#ifdef OFXS_CLIP_ATOMIC_METADATA
+    _metaData.store(snapshot, std::memory_order_release);
+#else
+    _metaData = snapshot;
+#endif
+  }
+
 #ifdef OFX_EXTENSIONS_NATRON
   /** @brief set the label property */
   void 
@@ -1890,6 +2024,9 @@ namespace OFX {
   /** @brief get the pixel depth */
   BitDepthEnum Clip::getPixelDepth(void) const
   {
+    if(const MetaData *m = getMetaData()) {
+      return m->pixelDepth;
+    }
     std::string str = _clipProps.propGetString(kOfxImageEffectPropPixelDepth);
     BitDepthEnum e;
     try {
@@ -1909,6 +2046,9 @@ namespace OFX {
   /** @brief get the components in the image */
   PixelComponentEnum Clip::getPixelComponents(void) const
   {
+    if(const MetaData *m = getMetaData()) {
+      return m->pixelComponents;
+    }
     std::string str = _clipProps.propGetString(kOfxImageEffectPropComponents);
     PixelComponentEnum e;
     try {
@@ -1928,6 +2068,9 @@ namespace OFX {
   /** @brief get the number of components in the image */
   int Clip::getPixelComponentCount(void) const
   {
+    if(const MetaData *m = getMetaData()) {
+      return m->pixelComponentCount;
+    }
     std::string str = _clipProps.propGetString(kOfxImageEffectPropComponents);
     PixelComponentEnum e;
     try {
@@ -1978,6 +2121,9 @@ namespace OFX {
   /** @brief what is the actual pixel depth of the clip */
   BitDepthEnum Clip::getUnmappedPixelDepth(void) const
   {
+    if(const MetaData *m = getMetaData()) {
+      return m->unmappedPixelDepth;
+    }
     std::string str = _clipProps.propGetString(kOfxImageClipPropUnmappedPixelDepth);
     BitDepthEnum e;
     try {
@@ -1997,6 +2143,9 @@ namespace OFX {
   /** @brief what is the component type of the clip */
   PixelComponentEnum Clip::getUnmappedPixelComponents(void) const
   {
+    if(const MetaData *m = getMetaData()) {
+      return m->unmappedPixelComponents;
+    }
     std::string str = _clipProps.propGetString(kOfxImageClipPropUnmappedComponents);
     PixelComponentEnum e;
     try {
@@ -2016,6 +2165,9 @@ namespace OFX {
   /** @brief get the components in the image */
   PreMultiplicationEnum Clip::getPreMultiplication(void) const
   {
+    if(const MetaData *m = getMetaData()) {
+      return m->preMultiplication;
+    }
     std::string str = _clipProps.propGetString(kOfxImageEffectPropPreMultiplication);
     PreMultiplicationEnum e;
     try {
@@ -2032,6 +2184,9 @@ namespace OFX {
   /** @brief which spatial field comes first temporally */
   FieldEnum Clip::getFieldOrder(void) const
   {
+    if(const MetaData *m = getMetaData()) {
+      return m->fieldOrder;
+    }
     std::string str = _clipProps.propGetString(kOfxImageClipPropFieldOrder);
     FieldEnum e;
     try {
@@ -2070,18 +2225,27 @@ namespace OFX {
   /** @brief is the clip connected */
   bool Clip::isConnected(void) const
   {
+    if(const MetaData *m = getMetaData()) {
+      return m->connected;
+    }
     return _clipProps.propGetInt(kOfxImageClipPropConnected) != 0;
   }
 
   /** @brief can the clip be continuously sampled */
   bool Clip::hasContinuousSamples(void) const
   {
+    if(const MetaData *m = getMetaData()) {
+      return m->continuousSamples;
+    }
     return _clipProps.propGetInt(kOfxImageClipPropContinuousSamples) != 0;
   }
 
   /** @brief get the scale factor that has been applied to this clip */
   double Clip::getPixelAspectRatio(void) const
   {
+    if(const MetaData *m = getMetaData()) {
+      return m->pixelAspectRatio;
+    }
     double par = _clipProps.propGetDouble(kOfxImagePropPixelAspectRatio, false);
     if (par != 0.) {
       return par;
@@ -2092,12 +2256,18 @@ namespace OFX {
   /** @brief get the frame rate, in frames per second on this clip, after any clip preferences have been applied */
   double Clip::getFrameRate(void) const
   {
+    if(const MetaData *m = getMetaData()) {
+      return m->frameRate;
+    }
     return _clipProps.propGetDouble(kOfxImageEffectPropFrameRate);
   }
 
   /** @brief return the range of frames over which this clip has images, after any clip preferences have been applied */
   OfxRangeD Clip::getFrameRange(void) const
   {
+    if(const MetaData *m = getMetaData()) {
+      return m->frameRange;
+    }
     OfxRangeD v = {0., 0.};
     _clipProps.propGetDoubleN(kOfxImageEffectPropFrameRange, &v.min, 2);
     return v;
@@ -2106,12 +2276,18 @@ namespace OFX {
   /** @brief get the frame rate, in frames per second on this clip, before any clip preferences have been applied */
   double Clip::getUnmappedFrameRate(void) const
   {
+    if(const MetaData *m = getMetaData()) {
+      return m->unmappedFrameRate;
+    }
     return _clipProps.propGetDouble(kOfxImageEffectPropUnmappedFrameRate);
   }
 
   /** @brief return the range of frames over which this clip has images, before any clip preferences have been applied */
   OfxRangeD Clip::getUnmappedFrameRange(void) const
   {
+    if(const MetaData *m = getMetaData()) {
+      return m->unmappedFrameRange;
+    }
     OfxRangeD v = {0., 0.};
     _clipProps.propGetDoubleN(kOfxImageEffectPropUnmappedFrameRange, &v.min, 2);
     return v;
@@ -2718,6 +2894,22 @@ namespace OFX {
     return newClip;
   }
 
+  /** @brief snapshot the metadata of every fetched clip */
+  void ImageEffect::snapshotClipMetaData(void)
+  {
+    for (std::map<std::string, Clip *>::const_iterator it = _fetchedClips.begin(); it != _fetchedClips.end(); ++it) {
+      it->second->snapshotMetaData();
+    }
+  }
+
+  /** @brief drop the metadata snapshots of every fetched clip */
+  void ImageEffect::invalidateClipMetaData(void)
+  {
+    for (std::map<std::string, Clip *>::const_iterator it = _fetchedClips.begin(); it != _fetchedClips.end(); ++it) {
+      it->second->invalidateMetaData();
+    }
+  }
+
 #ifdef OFX_EXTENSIONS_NUKE
   /** @brief Fetch the named camera from this instance */
   Camera* ImageEffect::fetchCamera(const std::string& name)
@@ -3905,7 +4097,9 @@ namespace OFX {
       if(gLoadCount == 1) {
         gEffectSuite    = (OfxImageEffectSuiteV1 *) fetchSuite(kOfxImageEffectSuite, 1);
         gPropSuite      = (OfxPropertySuiteV1 *)    fetchSuite(kOfxPropertySuite, 1);
+        gPropBatchSuite = (OfxPropertyBatchSuiteV1 *) fetchSuite(kOfxPropertyBatchSuite, 1, true);
         gParamSuite     = (OfxParameterSuiteV1 *)   fetchSuite(kOfxParameterSuite, 1);
+        gParamBatchSuite = (OfxParameterBatchSuiteV1 *) fetchSuite(kOfxParameterBatchSuite, 1, true);
         gMemorySuite    = (OfxMemorySuiteV1 *)      fetchSuite(kOfxMemorySuite, 1);
         gThreadSuite    = (OfxMultiThreadSuiteV1 *) fetchSuite(kOfxMultiThreadSuite, 1);
         gMessageSuite   = (OfxMessageSuiteV1 *)     fetchSuite(kOfxMessageSuite, 1);
@@ -3974,7 +4168,9 @@ namespace OFX {
         // force these to null
         gEffectSuite = 0;
         gPropSuite = 0;
+        gPropBatchSuite = 0;
         gParamSuite = 0;
+        gParamBatchSuite = 0;
         gMemorySuite = 0;
         gThreadSuite = 0;
         gMessageSuite = 0;
@@ -4012,6 +4208,7 @@ namespace OFX {
       { 
         OFX::OfxPlugInfoMap::iterator it = OFX::plugInfoMap.find(id);
         OfxPlugin* plug = it->second._plug;
+        OFX::plugInfoByUID.erase(it->second._factory->getUID().c_str());
         OFX::OfxPluginArray::iterator it2 = std::find(ofxPlugs.begin(), ofxPlugs.end(), plug);
         if (it2 != ofxPlugs.end()) {
           (*it2) = 0;
@@ -4051,24 +4248,24 @@ namespace OFX {
     /** @brief Checks the handles passed into the plugin's main entry point */
     static
     void
-      checkMainHandles(const std::string &action,  const void *handle, 
+      checkMainHandles(const char *action,  const void *handle, 
       OfxPropertySetHandle inArgsHandle,  OfxPropertySetHandle outArgsHandle,
       bool handleCanBeNull, bool inArgsCanBeNull, bool outArgsCanBeNull)
     {
       if(handleCanBeNull)
-        OFX::Log::warning(handle != 0, "Handle passed to '%s' is not null.", action.c_str());
+        OFX::Log::warning(handle != 0, "Handle passed to '%s' is not null.", action);
       else
-        OFX::Log::error(handle == 0, "'Handle passed to '%s' is null.", action.c_str());
+        OFX::Log::error(handle == 0, "'Handle passed to '%s' is null.", action);
 
       if(inArgsCanBeNull)
-        OFX::Log::warning(inArgsHandle != 0, "'inArgs' Handle passed to '%s' is not null.", action.c_str());
+        OFX::Log::warning(inArgsHandle != 0, "'inArgs' Handle passed to '%s' is not null.", action);
       else
-        OFX::Log::error(inArgsHandle == 0, "'inArgs' handle passed to '%s' is null.", action.c_str());
+        OFX::Log::error(inArgsHandle == 0, "'inArgs' handle passed to '%s' is null.", action);
 
       if(outArgsCanBeNull)
-        OFX::Log::warning(outArgsHandle != 0, "'outArgs' Handle passed to '%s' is not null.", action.c_str());
+        OFX::Log::warning(outArgsHandle != 0, "'outArgs' Handle passed to '%s' is not null.", action);
       else
-        OFX::Log::error(outArgsHandle == 0, "'outArgs' handle passed to '%s' is null.", action.c_str());
+        OFX::Log::error(outArgsHandle == 0, "'outArgs' handle passed to '%s' is null.", action);
 
       // validate the property sets on the arguments
       OFX::Validation::validateActionArgumentsProperties(action, inArgsHandle, outArgsHandle);
@@ -4221,6 +4418,9 @@ namespace OFX {
       args.view = inArgs.propGetInt(kFnOfxImageEffectPropView, 0, false);
 #endif
 
+      // clip metadata does not change until the sequence ends, so serve it from the clips during render
+      effectInstance->snapshotClipMetaData();
+
       // and call the plugin client render code
       effectInstance->beginSequenceRender(args);
     }
@@ -4260,6 +4460,8 @@ namespace OFX {
         
       // and call the plugin client render code
       effectInstance->endSequenceRender(args);
+
+      effectInstance->invalidateClipMetaData();
     }
 
 
@@ -4601,6 +4803,9 @@ namespace OFX {
       ImageEffectDescriptor* desc = gEffectDescriptors[key][effectInstance->getContext()];
       ClipPreferencesSetter prefs(outArgs, desc->getClipDepthPropNames(), desc->getClipComponentPropNames(), desc->getClipPARPropNames());
 
+      // the host is about to apply new preferences, so any metadata snapshot is stale
+      effectInstance->invalidateClipMetaData();
+
       // and call the plug-in client code
       effectInstance->getClipPreferences(prefs);
 
@@ -4649,6 +4854,9 @@ namespace OFX {
         effectInstance->changedParam(args, changedName);
       }
       else if(changedType == kOfxTypeClip) {
+        // connections and upstream changes may change any clip's metadata
+        effectInstance->invalidateClipMetaData();
+
         // and call the plugin client code
         effectInstance->changedClip(args, changedName);
       }
@@ -4905,6 +5113,153 @@ namespace OFX {
     }
 #endif
 
+    /** @brief Identifies an action once, so that mainEntryStr does not compare strings on every call */
+    enum ActionId {
+      eActionUnknown = 0,
+      eActionLoad,
+      eActionUnload,
+      eActionDescribe,
+      eActionDescribeInContext,
+      eActionCreateInstance,
+      eActionDestroyInstance,
+      eActionRender,
+      eActionBeginSequenceRender,
+      eActionEndSequenceRender,
+      eActionIsIdentity,
+      eActionGetRegionOfDefinition,
+      eActionGetRegionsOfInterest,
+      eActionGetFramesNeeded,
+      eActionGetClipPreferences,
+      eActionPurgeCaches,
+      eActionSyncPrivateData,
+      eActionGetTimeDomain,
+      eActionBeginInstanceChanged,
+      eActionInstanceChanged,
+      eActionEndInstanceChanged,
+      eActionBeginInstanceEdit,
+      eActionEndInstanceEdit,
+#ifdef OFX_SUPPORTS_OPENGLRENDER
+      eActionOpenGLContextAttached,
+      eActionOpenGLContextDetached,
+#endif
+#ifdef OFX_SUPPORTS_DIALOG
+      eActionDialog,
+#endif
+#ifdef OFX_EXTENSIONS_VEGAS
+      eActionVegasKeyframeUplift,
+      eActionInvokeHelp,
+      eActionInvokeAbout,
+#endif
+#ifdef OFX_EXTENSIONS_NUKE
+      eActionGetClipComponents,
+      eActionGetFrameViewsNeeded,
+      eActionGetTransform,
+#endif
+#ifdef OFX_EXTENSIONS_NATRON
+      eActionGetInverseDistortion,
+#endif
+    };
+
+    struct ActionName {
+      const char* name;
+      ActionId id;
+    };
+
+    static const ActionName gActionNames[] = {
+      { kOfxActionLoad, eActionLoad },
+      { kOfxActionUnload, eActionUnload },
+      { kOfxActionDescribe, eActionDescribe },
+      { kOfxImageEffectActionDescribeInContext, eActionDescribeInContext },
+      { kOfxActionCreateInstance, eActionCreateInstance },
+      { kOfxActionDestroyInstance, eActionDestroyInstance },
+      { kOfxImageEffectActionRender, eActionRender },
+      { kOfxImageEffectActionBeginSequenceRender, eActionBeginSequenceRender },
+      { kOfxImageEffectActionEndSequenceRender, eActionEndSequenceRender },
+      { kOfxImageEffectActionIsIdentity, eActionIsIdentity },
+      { kOfxImageEffectActionGetRegionOfDefinition, eActionGetRegionOfDefinition },
+      { kOfxImageEffectActionGetRegionsOfInterest, eActionGetRegionsOfInterest },
+      { kOfxImageEffectActionGetFramesNeeded, eActionGetFramesNeeded },
+      { kOfxImageEffectActionGetClipPreferences, eActionGetClipPreferences },
+      { kOfxActionPurgeCaches, eActionPurgeCaches },
+      { kOfxActionSyncPrivateData, eActionSyncPrivateData },
+      { kOfxImageEffectActionGetTimeDomain, eActionGetTimeDomain },
+      { kOfxActionBeginInstanceChanged, eActionBeginInstanceChanged },
+      { kOfxActionInstanceChanged, eActionInstanceChanged },
+      { kOfxActionEndInstanceChanged, eActionEndInstanceChanged },
+      { kOfxActionBeginInstanceEdit, eActionBeginInstanceEdit },
+      { kOfxActionEndInstanceEdit, eActionEndInstanceEdit },
+#ifdef OFX_SUPPORTS_OPENGLRENDER
+      { kOfxActionOpenGLContextAttached, eActionOpenGLContextAttached },
+      { kOfxActionOpenGLContextDetached, eActionOpenGLContextDetached },
+#endif
+#ifdef OFX_SUPPORTS_DIALOG
+      { kOfxActionDialog, eActionDialog },
+#endif
+#ifdef OFX_EXTENSIONS_VEGAS
+      { kOfxImageEffectActionVegasKeyframeUplift, eActionVegasKeyframeUplift },
+      { kOfxImageEffectActionInvokeHelp, eActionInvokeHelp },
+      { kOfxImageEffectActionInvokeAbout, eActionInvokeAbout },
+#endif
+#ifdef OFX_EXTENSIONS_NUKE
+      { kFnOfxImageEffectActionGetClipComponents, eActionGetClipComponents },
+      { kFnOfxImageEffectActionGetFrameViewsNeeded, eActionGetFrameViewsNeeded },
+      { kFnOfxImageEffectActionGetTransform, eActionGetTransform },
+#endif
+#ifdef OFX_EXTENSIONS_NATRON
+      { kOfxImageEffectActionGetInverseDistortion, eActionGetInverseDistortion },
+#endif
+    };
+
+    static const size_t gNumActionNames = sizeof(gActionNames) / sizeof(gActionNames[0]);
+
+    /** @brief open addressed hash table of gActionNames, filled once by initActionTable() */
+    static const size_t kActionTableSize = 64; // power of two, at least twice the number of actions
+    static const ActionName* gActionTable[kActionTableSize];
+    typedef char ActionTableIsLargeEnough[gNumActionNames * 2 <= kActionTableSize ? 1 : -1];
+
+    /** @brief FNV-1a hash of a nul terminated string */
+    static inline
+    unsigned int actionHash(const char* s)
+    {
+      unsigned int h = 2166136261u;
+      for (; *s; ++s) {
+        h ^= (unsigned char)*s;
+        h *= 16777619u;
+      }
+      return h;
+    }
+
+    void initActionTable()
+    {
+      for (size_t i = 0; i < gNumActionNames; ++i) {
+        size_t slot = actionHash(gActionNames[i].name) & (kActionTableSize - 1);
+        while (gActionTable[slot] && gActionTable[slot] != &gActionNames[i]) {
+          slot = (slot + 1) & (kActionTableSize - 1);
+        }
+        gActionTable[slot] = &gActionNames[i];
+      }
+    }
+
+    /** @brief map an action string onto its ActionId.
+
+    The pointer is first compared with the kOfx* constant itself, which succeeds whenever host and plugin share the literal,
+    and only then with the string contents.
+    */
+    static
+    ActionId lookupAction(const char* action)
+    {
+      if (!action) {
+        return eActionUnknown;
+      }
+      for (size_t slot = actionHash(action) & (kActionTableSize - 1); gActionTable[slot]; slot = (slot + 1) & (kActionTableSize - 1)) {
+        const ActionName* a = gActionTable[slot];
+        if (a->name == action || std::strcmp(a->name, action) == 0) {
+          return a->id;
+        }
+      }
+      return eActionUnknown;
+    }
+
     /** @brief The main entry point for the plugin
     */
     OfxStatus mainEntryStr(const char    *actionRaw,
@@ -4913,17 +5268,19 @@ namespace OFX {
       OfxPropertySetHandle   outArgsRaw,
       const char* plugname)
     {
-      OFX::Log::print("********************************************************************************");
-      OFX::Log::print("START mainEntry (%s)", actionRaw);
+      if(OFX::Log::isTracing()) {
+        OFX::Log::print("********************************************************************************");
+        OFX::Log::print("START mainEntry (%s)", actionRaw);
+      }
       OFX::Log::indent();
       OfxStatus stat = kOfxStatReplyDefault;
       try {
 
-        OfxPlugInfoMap::iterator it = plugInfoMap.find(plugname);
-        if(it==plugInfoMap.end())
+        OfxPlugInfo* info = findPlugInfo(plugname);
+        if(!info)
           throw;
 
-        OFX::PluginFactory* factory = it->second._factory;
+        OFX::PluginFactory* factory = info->_factory;
 
         // Cast the raw handle to be an image effect handle, because that is what it is
         OfxImageEffectHandle handle = (OfxImageEffectHandle) handleRaw;
@@ -4932,11 +5289,11 @@ namespace OFX {
         OFX::PropertySet inArgs(inArgsRaw);
         OFX::PropertySet outArgs(outArgsRaw);
 
-        // turn the action into a std::string
-        std::string action(actionRaw);
+        // turn the action into an ActionId
+        ActionId actionId = lookupAction(actionRaw);
 
         // figure the actions
-        if (action == kOfxActionLoad) {
+        if (actionId == eActionLoad) {
           // call the support load function, param-less
           OFX::Private::loadAction(); 
 
@@ -4948,20 +5305,20 @@ namespace OFX {
         }
 
         // figure the actions
-        else if (action == kOfxActionUnload) {
+        else if (actionId == eActionUnload) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, true, true, true);
 
           // call the plugin side unload action, param-less, should be called, eve if the stat above failed!
           factory->unload();
 
           // call the support unload function, param-less
-          OFX::Private::unloadAction(plugname, it->second._plug->pluginVersionMajor, it->second._plug->pluginVersionMinor);
+          OFX::Private::unloadAction(plugname, info->_plug->pluginVersionMajor, info->_plug->pluginVersionMinor);
 
           // got here, must be good
           stat = kOfxStatOK;
         }
 
-        else if(action == kOfxActionDescribe) {
+        else if(actionId == eActionDescribe) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, true);
 
           // make the plugin descriptor
@@ -4976,9 +5333,9 @@ namespace OFX {
 
           // add it to our map
           OFX::Private::VersionIDKey key;
-          key.id = it->first;
-          key.majorVersion = it->second._plug->pluginVersionMajor;
-          key.minorVersion = it->second._plug->pluginVersionMinor;
+          key.id = plugname;
+          key.majorVersion = info->_plug->pluginVersionMajor;
+          key.minorVersion = info->_plug->pluginVersionMinor;
           EffectDescriptorMap::iterator it = gEffectDescriptors.find(key);
           if (it != gEffectDescriptors.end()) {
             EffectContextMap& contextMap = it->second;
@@ -4992,7 +5349,7 @@ namespace OFX {
           // got here, must be good
           stat = kOfxStatOK;
         }
-        else if(action == kOfxImageEffectActionDescribeInContext) {
+        else if(actionId == eActionDescribeInContext) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, true);
 
           // make the plugin descriptor and pass it to the plugin to do something with it
@@ -5010,9 +5367,9 @@ namespace OFX {
 
           // add it to our map
           OFX::Private::VersionIDKey key;
-          key.id = it->first;
-          key.majorVersion = it->second._plug->pluginVersionMajor;
-          key.minorVersion = it->second._plug->pluginVersionMinor;
+          key.id = plugname;
+          key.majorVersion = info->_plug->pluginVersionMajor;
+          key.minorVersion = info->_plug->pluginVersionMinor;
           EffectDescriptorMap::iterator it = gEffectDescriptors.find(key);
           if (it != gEffectDescriptors.end()) {
             EffectContextMap& contextMap = it->second;
@@ -5026,7 +5383,7 @@ namespace OFX {
           // got here, must be good
           stat = kOfxStatOK;
         }
-        else if(action == kOfxActionCreateInstance) {
+        else if(actionId == eActionCreateInstance) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, true);
 
           // fetch the effect props to figure the context
@@ -5046,7 +5403,7 @@ namespace OFX {
           // got here, must be good
           stat = kOfxStatOK;
         }
-        else if(action == kOfxActionDestroyInstance) {
+        else if(actionId == eActionDestroyInstance) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, true);
 
           // fetch our pointer out of the props on the handle
@@ -5058,7 +5415,7 @@ namespace OFX {
           // got here, must be good
           stat = kOfxStatOK;
         }
-        else if(action == kOfxImageEffectActionRender) {
+        else if(actionId == eActionRender) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, true);
 
           // call the render action skin
@@ -5067,54 +5424,54 @@ namespace OFX {
           // got here, must be good
           stat = kOfxStatOK;
         }
-        else if(action == kOfxImageEffectActionBeginSequenceRender) {
+        else if(actionId == eActionBeginSequenceRender) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, true);
 
           // call the begin render action skin
           beginSequenceRenderAction(handle, inArgs);
         }
-        else if(action == kOfxImageEffectActionEndSequenceRender) {
+        else if(actionId == eActionEndSequenceRender) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, true);
 
           // call the begin render action skin
           endSequenceRenderAction(handle, inArgs);
         }
-        else if(action == kOfxImageEffectActionIsIdentity) {
+        else if(actionId == eActionIsIdentity) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, false);
 
           // call the identity action, if it is, return OK
           if(isIdentityAction(handle, inArgs, outArgs))
             stat = kOfxStatOK;
         }
-        else if(action == kOfxImageEffectActionGetRegionOfDefinition) {
+        else if(actionId == eActionGetRegionOfDefinition) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, false);
 
           // call the rod action, return OK if it does something
           if(regionOfDefinitionAction(handle, inArgs, outArgs))
             stat = kOfxStatOK;
         }
-        else if(action == kOfxImageEffectActionGetRegionsOfInterest) {
+        else if(actionId == eActionGetRegionsOfInterest) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, false);
 
           // call the RoI action, return OK if it does something
-          if(regionsOfInterestAction(handle, inArgs, outArgs, plugname, it->second._plug->pluginVersionMajor, it->second._plug->pluginVersionMinor))
+          if(regionsOfInterestAction(handle, inArgs, outArgs, plugname, info->_plug->pluginVersionMajor, info->_plug->pluginVersionMinor))
             stat = kOfxStatOK;
         }
-        else if(action == kOfxImageEffectActionGetFramesNeeded) {
+        else if(actionId == eActionGetFramesNeeded) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, false);
 
           // call the frames needed action, return OK if it does something
-          if(framesNeededAction(handle, inArgs, outArgs, plugname, it->second._plug->pluginVersionMajor, it->second._plug->pluginVersionMinor))
+          if(framesNeededAction(handle, inArgs, outArgs, plugname, info->_plug->pluginVersionMajor, info->_plug->pluginVersionMinor))
             stat = kOfxStatOK;
         }
-        else if(action == kOfxImageEffectActionGetClipPreferences) {
+        else if(actionId == eActionGetClipPreferences) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, false);
 
           // call the frames needed action, return OK if it does something
-          if(clipPreferencesAction(handle, outArgs, plugname, it->second._plug->pluginVersionMajor, it->second._plug->pluginVersionMinor))
+          if(clipPreferencesAction(handle, outArgs, plugname, info->_plug->pluginVersionMajor, info->_plug->pluginVersionMinor))
             stat = kOfxStatOK;
         }
-        else if(action == kOfxActionPurgeCaches) {
+        else if(actionId == eActionPurgeCaches) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, true);
 
           // fetch our pointer out of the props on the handle
@@ -5123,7 +5480,7 @@ namespace OFX {
           // purge 'em
           instance->purgeCaches();
         }
-        else if(action == kOfxActionSyncPrivateData) {
+        else if(actionId == eActionSyncPrivateData) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, true);
 
           // fetch our pointer out of the props on the handle
@@ -5132,32 +5489,32 @@ namespace OFX {
           // and sync it
           instance->syncPrivateData();
         }
-        else if(action == kOfxImageEffectActionGetTimeDomain) {
+        else if(actionId == eActionGetTimeDomain) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, false);
 
           // call the get time domain action
           if(getTimeDomainAction(handle, outArgs))
             stat = kOfxStatOK;
         }
-        else if(action == kOfxActionBeginInstanceChanged) {
+        else if(actionId == eActionBeginInstanceChanged) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, true);
 
           // call the begin instance changed action
           beginInstanceChangedAction(handle, inArgs);
         }
-        else if(action == kOfxActionInstanceChanged) {
+        else if(actionId == eActionInstanceChanged) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, true);
 
           // call the instance changed action
           instanceChangedAction(handle, inArgs);
         }
-        else if(action == kOfxActionEndInstanceChanged) {
+        else if(actionId == eActionEndInstanceChanged) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, true);
 
           // call the end instance changed action
           endInstanceChangedAction(handle, inArgs);
         }
-        else if(action == kOfxActionBeginInstanceEdit) {
+        else if(actionId == eActionBeginInstanceEdit) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, true);
 
           // fetch our pointer out of the props on the handle
@@ -5166,7 +5523,7 @@ namespace OFX {
           // call the begin edit function
           instance->beginEdit();
         }
-        else if(action == kOfxActionEndInstanceEdit) {
+        else if(actionId == eActionEndInstanceEdit) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, true);
 
           // fetch our pointer out of the props on the handle
@@ -5176,13 +5533,13 @@ namespace OFX {
           instance->endEdit();
         }
 #ifdef OFX_SUPPORTS_OPENGLRENDER
-        else if(action == kOfxActionOpenGLContextAttached) {
+        else if(actionId == eActionOpenGLContextAttached) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, true);
 
           // call the context attached action
           contextAttachedAction(handle, outArgs);
         }
-        else if(action == kOfxActionOpenGLContextDetached) {
+        else if(actionId == eActionOpenGLContextDetached) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, true);
 
           // call the context detached action
@@ -5190,7 +5547,7 @@ namespace OFX {
         }
 #endif
 #ifdef OFX_SUPPORTS_DIALOG
-        else if(action == kOfxActionDialog) {
+        else if(actionId == eActionDialog) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, true);
 
           // fetch our pointer out of the props on the handle
@@ -5207,20 +5564,20 @@ namespace OFX {
         }
 #endif
 #ifdef OFX_EXTENSIONS_VEGAS
-        else if(action == kOfxImageEffectActionVegasKeyframeUplift) {
+        else if(actionId == eActionVegasKeyframeUplift) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, true);
 
           // call the uplift vegas keyframes function
           upliftVegasKeyframeAction(handle, inArgs);
         }
-        else if(action == kOfxImageEffectActionInvokeHelp) {
+        else if(actionId == eActionInvokeHelp) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, true);
 
           // call the invoke help function
           if(invokeHelp(handle, plugname))
             stat = kOfxStatOK;
         }
-        else if(action == kOfxImageEffectActionInvokeAbout) {
+        else if(actionId == eActionInvokeAbout) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, true);
 
           // call the invoke help function
@@ -5229,23 +5586,23 @@ namespace OFX {
         }
 #endif
 #ifdef OFX_EXTENSIONS_NUKE
-        else if(action == kFnOfxImageEffectActionGetClipComponents) {
+        else if(actionId == eActionGetClipComponents) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, false);
 
           // call the clip components function, return OK if it does something
           // the spec is not clear as to whether it is allowed to do nothing but
           // this action should always be implemented for multi-planes effects.
-          stat = getClipComponentsAction(handle, inArgs, outArgs, plugname, it->second._plug->pluginVersionMajor, it->second._plug->pluginVersionMinor);
+          stat = getClipComponentsAction(handle, inArgs, outArgs, plugname, info->_plug->pluginVersionMajor, info->_plug->pluginVersionMinor);
         }
-        else if(action == kFnOfxImageEffectActionGetFrameViewsNeeded) {
+        else if(actionId == eActionGetFrameViewsNeeded) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, false);
 
           // call the frames views needed action, return OK if it does something
-          if (getFrameViewsNeededAction(handle, inArgs, outArgs, plugname, it->second._plug->pluginVersionMajor, it->second._plug->pluginVersionMinor)) {
+          if (getFrameViewsNeededAction(handle, inArgs, outArgs, plugname, info->_plug->pluginVersionMajor, info->_plug->pluginVersionMinor)) {
               stat = kOfxStatOK;
           }
         }
-        else if(action == kFnOfxImageEffectActionGetTransform) {
+        else if(actionId == eActionGetTransform) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, false);
 
           // call the get transform function
@@ -5254,7 +5611,7 @@ namespace OFX {
         }
 #endif
 #ifdef OFX_EXTENSIONS_NATRON
-        else if(action == kOfxImageEffectActionGetInverseDistortion) {
+        else if(actionId == eActionGetInverseDistortion) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, false);
 
           // call the get transform function
@@ -5501,12 +5858,14 @@ void init()
   if(OFX::ofxPlugs.empty())
     OFX::ofxPlugs.resize(plugIDs.size());
 
+  OFX::Private::initActionTable();
+
   int counter = 0;
   for (OFX::PluginFactoryArray::const_iterator it = plugIDs.begin(); it != plugIDs.end(); ++it, ++counter)
   {
     std::string newID;
     OFX::OfxPlugInfo info = generatePlugInfo(*it, newID);
-    OFX::plugInfoMap[newID] = info;
+    OFX::addPlugInfo(*it, newID, info);
     OFX::ofxPlugs[counter] = info._plug;
   }
   gHasInit = true;
@@ -5532,8 +5891,9 @@ EXPORT OfxPlugin* OfxGetPlugin(int nth)
   if(OFX::ofxPlugs[nth] == 0)
   {
     std::string newID;
-    OFX::OfxPlugInfo info = generatePlugInfo(OFX::PluginFactories::plugIDs()[nth], newID);
-    OFX::plugInfoMap[newID] = info;
+    OFX::PluginFactory* factory = OFX::PluginFactories::plugIDs()[nth];
+    OFX::OfxPlugInfo info = generatePlugInfo(factory, newID);
+    OFX::addPlugInfo(factory, newID, info);
     OFX::ofxPlugs[nth] = info._plug;
   }
   return OFX::ofxPlugs[nth];
@@ -61,6 +61,39 @@ The log file is written to using printf style functions, rather than via c++ ios
 namespace OFX {
   namespace Log {
 
+    /// environment variable for the log level
+#define kLogLevelEnvVar "OFX_PLUGIN_LOGLEVEL"
+
+    /** @brief the level logging starts at, taken from the environment if set */
+    static int initialLevel(void)
+    {
+      const char *value = getenv(kLogLevelEnvVar);
+      if(!value || !*value) {
+#ifdef DEBUG
+        return eLevelTrace;
+#else
+        return eLevelNone;
+#endif
+      }
+      int level = atoi(value);
+      if(level < eLevelNone) {
+        return eLevelNone;
+      }
+      if(level > eLevelTrace) {
+        return eLevelTrace;
+      }
+      return level;
+    }
+
+    namespace Private {
+      /** @brief the current log level */
+#ifdef OFXS_LOG_ATOMIC_LEVEL
+      std::atomic<int> gLevel(initialLevel());
+#else
+      volatile int gLevel = initialLevel();
+#endif
+    };
+
     /** @brief log file */
     static FILE *gLogFP = 0;
 
@@ -70,8 +103,36 @@ namespace OFX {
     /** @brief the global logfile name */
     static std::string gLogFileName(getenv(kLogFileEnvVar) ? getenv(kLogFileEnvVar) : "ofxTestLog.txt");
 
-    /** @brief global indent level, not MP sane */
-    static int gIndent = 0;
+#ifndef OFXS_NO_TRACE
+    /** @brief indent level, one per thread */
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1900)
+    static thread_local int gIndent = 0;
+#elif defined(_MSC_VER)
+    static __declspec(thread) int gIndent = 0;
+#else
+    static __thread int gIndent = 0;
+#endif
+#endif
+
+    /** @brief Sets the log level. */
+    void setLevel(LevelEnum level)
+    {
+#ifdef OFXS_LOG_ATOMIC_LEVEL
+      Private::gLevel.store(level, std::memory_order_relaxed);
+#else
+      Private::gLevel = level;
+#endif
+    }
+
+    /** @brief Returns the log level. */
+    LevelEnum getLevel(void)
+    {
+#ifdef OFXS_LOG_ATOMIC_LEVEL
+      return (LevelEnum)Private::gLevel.load(std::memory_order_relaxed);
+#else
+      return (LevelEnum)Private::gLevel;
+#endif
+    }
 
     /** @brief Sets the name of the log file. */
     void setFileName(const std::string &value)
@@ -82,18 +143,19 @@ namespace OFX {
     /** @brief Opens the log file, returns whether this was sucessful or not. */
     bool open(void)
     {
+      if(!gLogFP && isEnabled(eLevelError)) {
 #ifdef DEBUG
-      if(!gLogFP) {
         char buffer[2048];
         char *answer = getcwd(buffer, sizeof(buffer));
         std::cout << "INFO: OFX Log is \"" << gLogFileName << "\", working directory is \"" << answer << '\"' << std::endl;
+#endif
         gLogFP = fopen(gLogFileName.c_str(), "w");
+#ifdef DEBUG
         if (!gLogFP) {
           std::cout << "INFO: Failed to open OFX Log for writing" << std::endl;
         }
-        return gLogFP != 0;
-      }
 #endif
+      }
       return gLogFP != 0;
     }
 
@@ -106,32 +168,33 @@ namespace OFX {
       gLogFP = 0;
     }
 
-    /** @brief Indent it, not MP sane at the moment */
+    /** @brief do the indenting */
+    static void doIndent(void)
+    {
+#ifndef OFXS_NO_TRACE
+      for(int i = 0; i < gIndent; i++) {
+        fputs("    ", gLogFP);
+      }
+#endif
+    }
+
+#ifndef OFXS_NO_TRACE
+    /** @brief Indent it, the indent level is per thread */
     void indent(void)
     {
       ++gIndent;
     }
 
-    /** @brief Outdent it, not MP sane at the moment */
+    /** @brief Outdent it, the indent level is per thread */
     void outdent(void)
     {
       --gIndent;
     }
 
-    /** @brief do the indenting */
-    static void doIndent(void)
-    {
-      if(open()) {
-        for(int i = 0; i < gIndent; i++) {
-          fputs("    ", gLogFP);
-        }
-      }
-    }
-
     /** @brief Prints to the log file. */
     void print(const char *format, ...)
     {
-      if(open()) {
+      if(isEnabled(eLevelTrace) && open()) {
         doIndent();
         va_list args;
         va_start(args, format);
@@ -141,11 +204,12 @@ namespace OFX {
         va_end(args);
       }  
     }
+#endif
 
     /** @brief Prints to the log file only if the condition is true and prepends a warning notice. */
     void warning(bool condition, const char *format, ...)
     {
-      if(condition && open()) {
+      if(condition && isEnabled(eLevelWarning) && open()) {
         doIndent();
         fputs("WARNING : ", gLogFP);
 
@@ -162,7 +226,7 @@ namespace OFX {
     /** @brief Prints to the log file only if the condition is true and prepends an error notice. */
     void error(bool condition, const char *format, ...)
     {
-      if(condition && open()) {
+      if(condition && isEnabled(eLevelError) && open()) {
         doIndent();
         fputs("ERROR : ", gLogFP);
 
@@ -4246,4 +4246,148 @@ namespace OFX {
     throwSuiteStatusException(stat);
   }
 
+  ////////////////////////////////////////////////////////////////////////////////
+  // ParamSnapshot
+
+  /** @brief ctor */
+  ParamSnapshot::ParamSnapshot()
+    : _params()
+    , _offsets(1, 0)
+    , _values()
+    , _entries()
+    , _time(0.)
+  {
+  }
+
+  /** @brief add a numeric param */
+  int ParamSnapshot::add(Param *param)
+  {
+    if(!param) {
+      throw OFX::Exception::TypeRequest("Adding a null param to a ParamSnapshot");
+    }
+    int dim = 0;
+    switch(param->getType()) {
+    case eIntParam :
+    case eDoubleParam :
+    case eBooleanParam :
+    case eChoiceParam :
+      dim = 1;
+      break;
+    case eInt2DParam :
+    case eDouble2DParam :
+      dim = 2;
+      break;
+    case eInt3DParam :
+    case eDouble3DParam :
+    case eRGBParam :
+      dim = 3;
+      break;
+    case eRGBAParam :
+      dim = 4;
+      break;
+    default :
+      throw OFX::Exception::TypeRequest("Adding a non numeric param to a ParamSnapshot");
+    }
+    OfxParameterBatchEntry entry = { param->_paramHandle, dim, NULL, kOfxStatOK };
+    _params.push_back(param);
+    _offsets.push_back(_offsets.back() + dim);
+    _values.resize(_offsets.back(), 0.);
+    _entries.push_back(entry);
+    return (int)_params.size() - 1;
+  }
+
+  /** @brief get the values of all the params at the given time */
+  void ParamSnapshot::capture(double time)
+  {
+    if ( OFX::IsNaN(time) ) {
+      throwSuiteStatusException(kOfxStatErrValue);
+    }
+    _time = time;
+    int n = (int)_params.size();
+    if(n == 0) {
+      return;
+    }
+    if(OFX::Private::gParamBatchSuite) {
+      // the values pointers are fixed up here, as the vector may have been copied or grown since the last capture,
+      // and the statuses are reset so an entry the host does not fill in is got again below
+      for(int i = 0; i < n; ++i) {
+        _entries[i].values = &_values[_offsets[i]];
+        _entries[i].status = kOfxStatFailed;
+      }
+      OfxStatus stat = OFX::Private::gParamBatchSuite->paramGetValueBatchAtTime(time, &_entries[0], n);
+      if(stat == kOfxStatOK) {
+        return;
+      }
+      // get the ones the host could not one at a time, so errors are reported as usual
+      for(int i = 0; i < n; ++i) {
+        if(_entries[i].status != kOfxStatOK) {
+          captureParam(i);
+        }
+      }
+      return;
+    }
+    for(int i = 0; i < n; ++i) {
+      captureParam(i);
+    }
+  }
+
+  /** @brief get the values of one param through the param suite */
+  void ParamSnapshot::captureParam(int index)
+  {
+    Param *param = _params[index];
+    double *v = &_values[_offsets[index]];
+    switch(param->getType()) {
+    case eIntParam : {
+      int i;
+      static_cast<IntParam *>(param)->getValueAtTime(_time, i);
+      v[0] = i;
+      break;
+    }
+    case eChoiceParam : {
+      int i;
+      static_cast<ChoiceParam *>(param)->getValueAtTime(_time, i);
+      v[0] = i;
+      break;
+    }
+    case eBooleanParam : {
+      bool b;
+      static_cast<BooleanParam *>(param)->getValueAtTime(_time, b);
+      v[0] = b ? 1. : 0.;
+      break;
+    }
+    case eInt2DParam : {
+      int x, y;
+      static_cast<Int2DParam *>(param)->getValueAtTime(_time, x, y);
+      v[0] = x;
+      v[1] = y;
+      break;
+    }
+    case eInt3DParam : {
+      int x, y, z;
+      static_cast<Int3DParam *>(param)->getValueAtTime(_time, x, y, z);
+      v[0] = x;
+      v[1] = y;
+      v[2] = z;
+      break;
+    }
+    case eDoubleParam :
+      static_cast<DoubleParam *>(param)->getValueAtTime(_time, v[0]);
+      break;
+    case eDouble2DParam :
+      static_cast<Double2DParam *>(param)->getValueAtTime(_time, v[0], v[1]);
+      break;
+    case eDouble3DParam :
+      static_cast<Double3DParam *>(param)->getValueAtTime(_time, v[0], v[1], v[2]);
+      break;
+    case eRGBParam :
+      static_cast<RGBParam *>(param)->getValueAtTime(_time, v[0], v[1], v[2]);
+      break;
+    case eRGBAParam :
+      static_cast<RGBAParam *>(param)->getValueAtTime(_time, v[0], v[1], v[2], v[3]);
+      break;
+    default :
+      break;
+    }
+  }
+
 };
@@ -99,7 +99,7 @@ namespace OFX {
     if(throwOnFailure && stat != kOfxStatErrUnknown && stat != kOfxStatErrUnsupported)
       throwPropertyException(stat, property); 
 
-    if(_gPropLogging > 0) 
+    if(_gPropLogging > 0 && Log::isTracing()) 
       Log::print("Fetched dimension of property %s, returned status %s.",  property, mapStatusToString(stat));
 
     return stat == kOfxStatOK;
@@ -118,7 +118,7 @@ namespace OFX {
     if(throwOnFailure)
       throwPropertyException(stat, property); 
 
-    if(_gPropLogging > 0) 
+    if(_gPropLogging > 0 && Log::isTracing()) 
       Log::print("Fetched dimension of property %s, returned %d.",  property, dimension);
 
     return dimension;
@@ -135,7 +135,7 @@ namespace OFX {
     Log::error(stat != kOfxStatOK, "Failed on reseting property %s to its defaults, host returned status %s.", property, mapStatusToString(stat));
     throwPropertyException(stat, property); 
 
-    if(_gPropLogging > 0) Log::print("Reset property %s.",  property);
+    if(_gPropLogging > 0 && Log::isTracing()) Log::print("Reset property %s.",  property);
   }
 
   /** @brief, Set a single dimension pointer property */
@@ -151,7 +151,7 @@ namespace OFX {
     if(throwOnFailure)
       throwPropertyException(stat, property);  
 
-    if(_gPropLogging > 0) Log::print("Set pointer property %s[%d] to be %p.",  property, idx, value);
+    if(_gPropLogging > 0 && Log::isTracing()) Log::print("Set pointer property %s[%d] to be %p.",  property, idx, value);
   }
 
   /** @brief, Set a single dimension string property */
@@ -167,7 +167,7 @@ namespace OFX {
     if(throwOnFailure)
       throwPropertyException(stat, property); 
 
-    if(_gPropLogging > 0) Log::print("Set string property %s[%d] to be %s.",  property, idx, value.c_str());
+    if(_gPropLogging > 0 && Log::isTracing()) Log::print("Set string property %s[%d] to be %s.",  property, idx, value.c_str());
   }
 
   /** @brief, Set a single dimension double property */
@@ -183,7 +183,7 @@ namespace OFX {
     if(throwOnFailure)
       throwPropertyException(stat, property); 
 
-    if(_gPropLogging > 0) Log::print("Set double property %s[%d] to be %lf.",  property, idx, value);
+    if(_gPropLogging > 0 && Log::isTracing()) Log::print("Set double property %s[%d] to be %lf.",  property, idx, value);
   }
 
   /** @brief, Set a single dimension int property */
@@ -199,7 +199,7 @@ namespace OFX {
     if(throwOnFailure)
       throwPropertyException(stat, property); 
 
-    if(_gPropLogging > 0) Log::print("Set int property %s[%d] to be %d.",  property, idx, value);
+    if(_gPropLogging > 0 && Log::isTracing()) Log::print("Set int property %s[%d] to be %d.",  property, idx, value);
   }
 
   void PropertySet::propSetStringN(const char* property, const std::vector<std::string> &values, bool throwOnFailure) OFX_THROW4(std::bad_alloc,
@@ -218,7 +218,7 @@ namespace OFX {
     if(throwOnFailure)
       throwPropertyException(stat, property);
     
-    if(_gPropLogging > 0) Log::print("Set string property %s[0..%d].",  property, values.size()-1);
+    if(_gPropLogging > 0 && Log::isTracing()) Log::print("Set string property %s[0..%d].",  property, values.size()-1);
   }
 
   /** @brief, Set a multiple dimension double property */
@@ -243,7 +243,7 @@ namespace OFX {
     if(throwOnFailure)
       throwPropertyException(stat, property); 
 
-    if(_gPropLogging > 0) Log::print("Set double property %s[0..%d].",  property, count-1);
+    if(_gPropLogging > 0 && Log::isTracing()) Log::print("Set double property %s[0..%d].",  property, count-1);
   }
   
   void PropertySet::propSetIntN(const char* property, const std::vector<int> &values, bool throwOnFailure) OFX_THROW4(std::bad_alloc,
@@ -267,7 +267,7 @@ namespace OFX {
     if(throwOnFailure)
       throwPropertyException(stat, property);
 
-    if(_gPropLogging > 0) Log::print("Set int property %s[0..%d].",  property, count-1);
+    if(_gPropLogging > 0 && Log::isTracing()) Log::print("Set int property %s[0..%d].",  property, count-1);
 
   }
 
@@ -285,7 +285,7 @@ namespace OFX {
     if(throwOnFailure)
       throwPropertyException(stat, property); 
 
-    if(_gPropLogging > 0) Log::print("Retrieved pointer property %s[%d], was given %p.",  property, idx, value);
+    if(_gPropLogging > 0 && Log::isTracing()) Log::print("Retrieved pointer property %s[%d], was given %p.",  property, idx, value);
 
     return value;
   }
@@ -304,7 +304,7 @@ namespace OFX {
     if(throwOnFailure)
       throwPropertyException(stat, property);
 
-    if(_gPropLogging > 0) Log::print("Retrieved string property %s[%d], was given %s.",  property, idx, value);
+    if(_gPropLogging > 0 && Log::isTracing()) Log::print("Retrieved string property %s[%d], was given %s.",  property, idx, value);
     return value != NULL ?  std::string(value) : std::string();
   }
 
@@ -322,7 +322,7 @@ namespace OFX {
     if(throwOnFailure)
       throwPropertyException(stat, property); 
 
-    if(_gPropLogging > 0) Log::print("Retrieved double property %s[%d], was given %lf.",  property, idx, value);
+    if(_gPropLogging > 0 && Log::isTracing()) Log::print("Retrieved double property %s[%d], was given %lf.",  property, idx, value);
     return value;
   }
 
@@ -340,7 +340,7 @@ namespace OFX {
     if(throwOnFailure)
       throwPropertyException(stat, property); 
 
-    if(_gPropLogging > 0) Log::print("Retrieved int property %s[%d], was given %d.",  property, idx, value);
+    if(_gPropLogging > 0 && Log::isTracing()) Log::print("Retrieved int property %s[%d], was given %d.",  property, idx, value);
     return value;
   }
     
@@ -361,7 +361,7 @@ namespace OFX {
     if(throwOnFailure)
       throwPropertyException(stat, property);
       
-    if(_gPropLogging > 0) Log::print("Retrieved string property %s, was given %s.", property, &rawValue.front());
+    if(_gPropLogging > 0 && Log::isTracing()) Log::print("Retrieved string property %s, was given %s.", property, &rawValue.front());
     
     values->resize(dimension);
     for (int i = 0; i < dimension; ++i) {
@@ -400,7 +400,7 @@ namespace OFX {
     if(throwOnFailure)
       throwPropertyException(stat, property);
 
-    if(_gPropLogging > 0) {
+    if(_gPropLogging > 0 && Log::isTracing()) {
       switch (count) {
       case 1:
         Log::print("Retrieved doublex1 property %s, was given %g.", property, values[0]);
@@ -447,7 +447,7 @@ namespace OFX {
     if(throwOnFailure)
       throwPropertyException(stat, property);
 
-    if(_gPropLogging > 0) {
+    if(_gPropLogging > 0 && Log::isTracing()) {
       switch (count) {
       case 1:
         Log::print("Retrieved intx1 property %s, was given %d.", property, values[0]);
@@ -468,4 +468,55 @@ namespace OFX {
 
   }
 
+  void PropertySet::propGetBatch(OfxPropertyBatchEntry* entries, int count, bool throwOnFailure) const OFX_THROW4(std::bad_alloc,
+    OFX::Exception::PropertyUnknownToHost,
+    OFX::Exception::PropertyValueIllegalToHost,
+    OFX::Exception::Suite)
+  {
+    assert(_propHandle != 0);
+    if(gPropBatchSuite) {
+      OfxStatus stat = gPropBatchSuite->propGetBatch(_propHandle, entries, count);
+      if(stat != kOfxStatOK && stat != kOfxStatFailed) {
+        // the call failed as a whole, so the entries were not looked at
+        for(int i = 0; i < count; ++i) {
+          entries[i].status = stat;
+        }
+      }
+    }
+    else {
+      // the host can't batch, so get them one by one
+      for(int i = 0; i < count; ++i) {
+        OfxPropertyBatchEntry &entry = entries[i];
+        switch(entry.type) {
+        case kOfxPropertyBatchTypeInt :
+          entry.status = gPropSuite->propGetIntN(_propHandle, entry.name, entry.count, (int *)entry.values);
+          break;
+        case kOfxPropertyBatchTypeDouble :
+          entry.status = gPropSuite->propGetDoubleN(_propHandle, entry.name, entry.count, (double *)entry.values);
+          break;
+        case kOfxPropertyBatchTypeString :
+          entry.status = gPropSuite->propGetStringN(_propHandle, entry.name, entry.count, (const char **)entry.values);
+          break;
+        case kOfxPropertyBatchTypePointer :
+          entry.status = gPropSuite->propGetPointerN(_propHandle, entry.name, entry.count, (void **)entry.values);
+          break;
+        default :
+          entry.status = kOfxStatErrValue;
+          break;
+        }
+      }
+    }
+
+    for(int i = 0; i < count; ++i) {
+      const OfxPropertyBatchEntry &entry = entries[i];
+      OFX::Log::error(entry.status != kOfxStatOK, "Failed on getting property %s in a batch, host returned status %s;",
+                      entry.name, mapStatusToString(entry.status));
+      if(throwOnFailure)
+        throwPropertyException(entry.status, entry.name);
+
+      if(_gPropLogging > 0 && Log::isTracing()) Log::print("Retrieved %d values of property %s in a batch, returned status %s.",
+                                       entry.count, entry.name, mapStatusToString(entry.status));
+    }
+  }
+
 };
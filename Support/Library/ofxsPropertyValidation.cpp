@@ -42,6 +42,8 @@ This file contains headers for classes that are used to validate property sets a
 
 #include "ofxsSupportPrivate.h"
 #include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
 #ifdef OFX_SUPPORTS_OPENGLRENDER
 #include "ofxOpenGLRender.h"
 #endif
@@ -49,14 +51,13 @@ This file contains headers for classes that are used to validate property sets a
 /** @brief Null pointer definition */
 #define NULLPTR ((void *)(0))
 
-// #define  kOfxsDisableValidation
+// define kOfxsDisableValidation to compile validation out altogether, otherwise it is chosen at runtime, see OFX::Validation::setPolicy
+//#define kOfxsDisableValidation
 
-// disable validation if not a debug build
-#ifndef DEBUG
-#define  kOfxsDisableValidation
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1900)
+#include <atomic>
+#define OFXS_VALIDATION_ATOMIC
 #endif
-
-//#define kOfxsDisableValidation
 /** @brief OFX namespace
 */
 namespace OFX {
@@ -64,7 +65,97 @@ namespace OFX {
   /** @brief The validation code has its own namespace */
   namespace Validation {
 
+#ifdef OFXS_VALIDATION_ATOMIC
+    typedef std::atomic<int> Counter;
+#else
+    typedef volatile int Counter;
+#endif
+
+    /// environment variable for the validation policy
+#define kValidationEnvVar "OFX_PLUGIN_VALIDATION"
+
+    /** @brief the policy validation starts with, taken from the environment if set */
+    static int initialPolicy(void)
+    {
+      const char *value = getenv(kValidationEnvVar);
+      if(!value || !*value) {
+#ifdef DEBUG
+        return ePolicyAlways;
+#else
+        return ePolicyOff;
+#endif
+      }
+      if(strcmp(value, "always") == 0) {
+        return ePolicyAlways;
+      }
+      return atoi(value) > 0 ? ePolicyFirstCalls : ePolicyOff;
+    }
+
+    /** @brief the number of first calls validated, taken from the environment if set */
+    static int initialFirstCalls(void)
+    {
+      const char *value = getenv(kValidationEnvVar);
+      int n = value ? atoi(value) : 0;
+      return n > 0 ? n : 1;
+    }
+
+    static Counter gPolicy(initialPolicy());
+    static Counter gFirstCalls(initialFirstCalls());
+
+    /** @brief Enumerates the kinds of property sets, each has its own count for ePolicyFirstCalls */
+    enum CallKindEnum {
+      eHostCalls,
+      ePluginDescriptorCalls,
+      ePluginInstanceCalls,
+      eClipDescriptorCalls,
+      eClipInstanceCalls,
+      eCameraDescriptorCalls,
+      eCameraInstanceCalls,
+      eImageBaseCalls,
+      eImageCalls,
+      eTextureCalls,
+      eActionArgumentsCalls,
+      eParameterCalls,
+      eNumCallKinds
+    };
+
+    /** @brief how many property sets of each kind have been validated */
+    static Counter gCalls[eNumCallKinds];
+
+    /** @brief Sets the validation policy */
+    void setPolicy(PolicyEnum policy, int firstCalls)
+    {
+      for(int i = 0; i < eNumCallKinds; ++i) {
+        gCalls[i] = 0;
+      }
+      gFirstCalls = firstCalls > 0 ? firstCalls : 1;
+      gPolicy = policy;
+    }
+
+    /** @brief Returns the validation policy */
+    PolicyEnum getPolicy(void)
+    {
+#ifdef kOfxsDisableValidation
+      return ePolicyOff;
+#else
+      return (PolicyEnum)(int)gPolicy;
+#endif
+    }
+
 #ifndef kOfxsDisableValidation
+    /** @brief whether a property set of the given kind is to be validated, a single load when validation is off */
+    static inline bool shouldValidate(CallKindEnum kind)
+    {
+      int policy = gPolicy;
+      if(policy == ePolicyOff) {
+        return false;
+      }
+      if(policy == ePolicyAlways) {
+        return true;
+      }
+      return ++gCalls[kind] <= gFirstCalls;
+    }
+
     /** @brief Set the vector by getting dimension things specified by ilk from the argp list, used by PropertyDescription ctor */
     static void
       setVectorFromVarArgs(OFX::PropertyTypeEnum ilk,
@@ -1134,6 +1225,9 @@ namespace OFX {
 #ifdef kOfxsDisableValidation
     (void)host;
 #else
+      if(!shouldValidate(eHostCalls)) {
+        return;
+      }
       // make a description set
       PropertySet props(host->host);
       gHostPropSet.validate(props);
@@ -1147,6 +1241,9 @@ namespace OFX {
 #ifdef kOfxsDisableValidation
     (void)props;
 #else
+      if(!shouldValidate(ePluginDescriptorCalls)) {
+        return;
+      }
       gPluginDescriptorPropSet.validate(props);
 #endif
     }
@@ -1158,6 +1255,9 @@ namespace OFX {
 #ifdef kOfxsDisableValidation
     (void)props;
 #else
+      if(!shouldValidate(ePluginInstanceCalls)) {
+        return;
+      }
       gPluginInstancePropSet.validate(props);
 #endif
     }
@@ -1169,6 +1269,9 @@ namespace OFX {
 #ifdef kOfxsDisableValidation
     (void)props;
 #else
+      if(!shouldValidate(eClipDescriptorCalls)) {
+        return;
+      }
       gClipDescriptorPropSet.validate(props);
 #endif
     }
@@ -1180,6 +1283,9 @@ namespace OFX {
 #ifdef kOfxsDisableValidation
     (void)props;
 #else
+      if(!shouldValidate(eClipInstanceCalls)) {
+        return;
+      }
       gClipInstancePropSet.validate(props);
 #endif
     }
@@ -1192,6 +1298,9 @@ namespace OFX {
 #ifdef kOfxsDisableValidation
       (void)props;
 #else
+      if(!shouldValidate(eCameraDescriptorCalls)) {
+        return;
+      }
       gCameraDescriptorPropSet.validate(props);
 #endif
     }
@@ -1203,6 +1312,9 @@ namespace OFX {
 #ifdef kOfxsDisableValidation
       (void)props;
 #else
+      if(!shouldValidate(eCameraInstanceCalls)) {
+        return;
+      }
       gCameraInstancePropSet.validate(props);
 #endif
     }
@@ -1215,6 +1327,9 @@ namespace OFX {
 #ifdef kOfxsDisableValidation
     (void)props;
 #else
+      if(!shouldValidate(eImageBaseCalls)) {
+        return;
+      }
       gImageBaseInstancePropSet.validate(props);
 #endif
     }
@@ -1226,6 +1341,9 @@ namespace OFX {
 #ifdef kOfxsDisableValidation
     (void)props;
 #else
+      if(!shouldValidate(eImageCalls)) {
+        return;
+      }
       gImageInstancePropSet.validate(props);
 #endif
     }
@@ -1238,6 +1356,9 @@ namespace OFX {
 #ifdef kOfxsDisableValidation
     (void)props;
 #else
+      if(!shouldValidate(eTextureCalls)) {
+        return;
+      }
       gTextureInstancePropSet.validate(props);
 #endif
     }
@@ -1245,13 +1366,17 @@ namespace OFX {
 
     /** @brief Validates action in/out arguments */
     void
-      validateActionArgumentsProperties(const std::string &action, PropertySet inArgs, PropertySet outArgs)
+      validateActionArgumentsProperties(const char *actionRaw, PropertySet inArgs, PropertySet outArgs)
     {
 #ifdef kOfxsDisableValidation
-    (void)action;
+    (void)actionRaw;
     (void)inArgs;
     (void)outArgs;
 #else
+      if(!shouldValidate(eActionArgumentsCalls)) {
+        return;
+      }
+      const std::string action(actionRaw);
       if(action == kOfxActionInstanceChanged) {
         gInstanceChangedInArgPropSet.validate(inArgs);
       }
@@ -1307,6 +1432,9 @@ namespace OFX {
     (void)paramProps;
     (void)checkDefaults;
 #else
+      if(!shouldValidate(eParameterCalls)) {
+        return;
+      }
       // should use a map here
       switch(paramType) 
       {
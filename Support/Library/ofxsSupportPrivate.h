@@ -62,12 +62,18 @@ namespace OFX {
     /** @brief Pointer to the property suite */
     extern OfxPropertySuiteV1    *gPropSuite;
 
+    /** @brief Pointer to the property batch suite, may be null */
+    extern OfxPropertyBatchSuiteV1 *gPropBatchSuite;
+
     /** @brief Pointer to the  interact suite */
     extern OfxInteractSuiteV1    *gInteractSuite;
 
     /** @brief Pointer to the parameter suite */
     extern OfxParameterSuiteV1   *gParamSuite;
 
+    /** @brief Pointer to the parameter batch suite, may be null */
+    extern OfxParameterBatchSuiteV1 *gParamBatchSuite;
+
     /** @brief Pointer to the general memory suite */
     extern OfxMemorySuiteV1      *gMemorySuite;
 
@@ -303,7 +309,7 @@ namespace OFX {
 
     /** @brief Validates action in/out arguments */
     void
-      validateActionArgumentsProperties(const std::string &action, PropertySet inArgs, PropertySet outArgs);
+      validateActionArgumentsProperties(const char *action, PropertySet inArgs, PropertySet outArgs);
 
     /** @brief Validates parameter properties */
     void
@@ -229,6 +229,10 @@ protected :
   OFX::DoubleParam  *aScale_;
   OFX::BooleanParam *componentScalesEnabled_;
 
+  // the values render needs, got in one go at the start of each render
+  OFX::ParamSnapshot renderParams_;
+  enum {eRenderScale, eRenderScaleR, eRenderScaleG, eRenderScaleB, eRenderScaleA, eRenderScaleComponents};
+
 public :
   /** @brief ctor */
   BasicPlugin(OfxImageEffectHandle handle)
@@ -253,6 +257,14 @@ public :
     aScale_  = fetchDoubleParam("scaleA");
     componentScalesEnabled_ = fetchBooleanParam("scaleComponents");
 
+    // added in the same order as the enum above
+    renderParams_.add(scale_);
+    renderParams_.add(rScale_);
+    renderParams_.add(gScale_);
+    renderParams_.add(bScale_);
+    renderParams_.add(aScale_);
+    renderParams_.add(componentScalesEnabled_);
+
     // set the enabledness of our RGBA sliders
     setEnabledness();
   }
@@ -331,15 +343,17 @@ BasicPlugin::setupAndProcess(ImageScalerBase &processor, const OFX::RenderArgume
     processor.setMaskImg(mask.get());
   }
 
-  // get the scale parameter values...
-  double r, g, b, a = aScale_->getValueAtTime(args.time);
-  r = g = b = scale_->getValueAtTime(args.time);
+  // get the scale parameter values, on a copy of the snapshot as renders may run concurrently
+  OFX::ParamSnapshot params(renderParams_);
+  params.capture(args.time);
+  double r, g, b, a = params.getDouble(eRenderScaleA);
+  r = g = b = params.getDouble(eRenderScale);
 
   // see if the individual component scales are enabled
-  if(componentScalesEnabled_->getValueAtTime(args.time)) {
-    r *= rScale_->getValueAtTime(args.time);
-    g *= gScale_->getValueAtTime(args.time);
-    b *= bScale_->getValueAtTime(args.time);
+  if(params.getBool(eRenderScaleComponents)) {
+    r *= params.getDouble(eRenderScaleR);
+    g *= params.getDouble(eRenderScaleG);
+    b *= params.getDouble(eRenderScaleB);
   }
 
   // set the images
@@ -95,7 +95,9 @@ of the direct OFX objects and any library side only functions.
 #include "ofxMessage.h"
 #include "ofxMultiThread.h"
 #include "ofxParam.h"
+#include "ofxParameterBatch.h"
 #include "ofxProperty.h"
+#include "ofxPropertyBatch.h"
 #include "ofxPixels.h"
 #ifdef OFX_SUPPORTS_DIALOG
 #include "ofxDialog.h"
@@ -223,6 +225,28 @@ namespace OFX {
   /** @brief maps a status to a string for debugging purposes, note a c-str for printf */
   const char * mapStatusToString(OfxStatus stat);
 
+  /** @brief namespace for checking the property sets the host hands the plugin */
+  namespace Validation {
+
+    /** @brief Enumerates how often property sets are validated */
+    enum PolicyEnum {
+      ePolicyOff,        /**< @brief never validate */
+      ePolicyFirstCalls, /**< @brief validate only the first N property sets of each kind, eg: the first N images */
+      ePolicyAlways      /**< @brief validate every property set */
+    };
+
+    /** @brief Sets the validation policy, firstCalls is the N used by ePolicyFirstCalls.
+
+    Defaults to ePolicyAlways in DEBUG builds and to ePolicyOff otherwise, the OFX_PLUGIN_VALIDATION environment variable overrides
+    the default, it may be "off", "always" or the number of first calls to validate. Problems are reported through OFX::Log,
+    so its level must be at least eLevelWarning for them to show.
+    */
+    void setPolicy(PolicyEnum policy, int firstCalls = 1);
+
+    /** @brief Returns the validation policy */
+    PolicyEnum getPolicy(void);
+  };
+
   /** @brief namespace for OFX support lib exceptions, all derive from std::exception, calling it */
   namespace Exception {
 
@@ -535,6 +559,16 @@ namespace OFX {
       OFX::Exception::PropertyValueIllegalToHost,
       OFX::Exception::Suite);
 
+    /** @brief get many properties at once, in a single call if the host has the property batch suite.
+
+        The status of each entry is set. If throwOnFailure, throws on the first entry that failed.
+        Strings are owned by the host, as with the property suite.
+     */
+    void propGetBatch(OfxPropertyBatchEntry* entries, int count, bool throwOnFailure = true) const OFX_THROW4(std::bad_alloc,
+      OFX::Exception::PropertyUnknownToHost,
+      OFX::Exception::PropertyValueIllegalToHost,
+      OFX::Exception::Suite);
+
   };
 
   // forward decl of the image effect
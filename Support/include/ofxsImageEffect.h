@@ -46,6 +46,10 @@ of the direct OFX objects and any library side only functions.
 #include <string>
 #include <sstream> // stringstream
 #include <memory>
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1900)
+#include <atomic>
+#define OFXS_CLIP_ATOMIC_METADATA
+#endif
 #include "ofxsParam.h"
 #include "ofxsInteract.h"
 #ifdef OFX_EXTENSIONS_VEGAS
@@ -1115,7 +1119,50 @@ namespace OFX {
     PixelOrderEnum _pixelOrder;              /**< @brief the pixel order */
 #endif
 
+    /** @brief clip metadata that does not change during a render sequence, never modified once published */
+    struct MetaData {
+      BitDepthEnum pixelDepth;
+      PixelComponentEnum pixelComponents;
+      int pixelComponentCount;
+      BitDepthEnum unmappedPixelDepth;
+      PixelComponentEnum unmappedPixelComponents;
+      PreMultiplicationEnum preMultiplication;
+      FieldEnum fieldOrder;
+      bool connected;
+      bool continuousSamples;
+      double pixelAspectRatio;
+      double frameRate;
+      OfxRangeD frameRange;
+      double unmappedFrameRate;
+      OfxRangeD unmappedFrameRange;
+      const MetaData *next; ///< the snapshot taken before this one
+
+      /** @brief does it hold the same metadata as other */
+      bool sameAs(const MetaData &other) const;
+    };
+
+    /** @brief The current snapshot, NULL if none.
+
+    Render threads read it while other actions replace it, so a published snapshot is never written to or freed
+    until the clip is destroyed. Every snapshot taken is kept on _metaDataSnapshots and reused when the same
+    metadata comes round again, so there are only as many as there have been distinct states of the clip.
+    */
+#ifdef OFXS_CLIP_ATOMIC_METADATA
+    std::atomic<const MetaData *> _metaData;
+    std::atomic<const MetaData *> _metaDataSnapshots;
+
+    const MetaData *getMetaData(void) const {return _metaData.load(std::memory_order_acquire);}
+#else
+    const MetaData *volatile _metaData;
+    const MetaData *volatile _metaDataSnapshots;
+
+    const MetaData *getMetaData(void) const {return _metaData;}
+#endif
+
   public :
+    /** @brief dtor */
+    ~Clip();
+
     /// get the underlying property set on this clip
     const PropertySet &getPropertySet() const {return _clipProps;}
 
@@ -1208,6 +1255,16 @@ namespace OFX {
     /** @brief get the RoD for this clip in the cannonical coordinate system */
     OfxRectD getRegionOfDefinition(double t);
 
+    /** @brief Fetch the clip metadata once, so that the getters above serve it without going through the property suite.
+
+    The support library takes the snapshot before beginSequenceRender and drops it on getClipPreferences, on a clip change and after endSequenceRender.
+    If the host fails to return any of it, no snapshot is kept. Render threads may read the snapshot while this replaces it.
+    */
+    void snapshotMetaData(void);
+
+    /** @brief Drop the metadata snapshot, the getters go back to the property suite */
+    void invalidateMetaData(void);
+
 #ifdef OFX_EXTENSIONS_RESOLVE
     /** @brief is the clip for thumbnail */
     bool isForThumbnail(void) const;
@@ -1914,6 +1971,12 @@ namespace OFX {
     */
     Clip *fetchClip(const std::string &name);
 
+    /** @brief snapshot the metadata of every fetched clip, see Clip::snapshotMetaData */
+    void snapshotClipMetaData(void);
+
+    /** @brief drop the metadata snapshots of every fetched clip */
+    void invalidateClipMetaData(void);
+
 #ifdef OFX_EXTENSIONS_NUKE
     /** @brief Fetch the named camera from this instance
 
@@ -38,20 +38,86 @@ England
 */
 
 /** @file This file contains OFX logging header code
+
+Logging is level gated, see OFX::Log::setLevel, and the level is checked before anything is formatted.
+
+Defining OFXS_NO_TRACE when building the support library and the plugin compiles print, indent and outdent out
+altogether, errors and warnings are still logged when their level is enabled.
 */
 
+#include <string>
+
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1900)
+#include <atomic>
+#define OFXS_LOG_ATOMIC_LEVEL
+#endif
+
 /** @brief The core 'OFX Support' namespace, used by plugin implementations. All code for these are defined in the common support libraries.
 */
 namespace OFX {
 
   /** @brief this namespace wraps up logging functionality */
   namespace Log {
-    /** @brief Indent it, not MP sane at the moment */
+
+    /** @brief How much is written to the log file, each level includes the ones before it */
+    enum LevelEnum {
+      eLevelNone = 0, ///< nothing is logged
+      eLevelError,    ///< only errors
+      eLevelWarning,  ///< errors and warnings
+      eLevelTrace     ///< everything, including print
+    };
+
+    namespace Private {
+      /** @brief the current level, only read through isEnabled() */
+#ifdef OFXS_LOG_ATOMIC_LEVEL
+      extern std::atomic<int> gLevel;
+#else
+      extern volatile int gLevel;
+#endif
+    };
+
+    /** @brief Sets the log level.
+
+    Defaults to eLevelTrace in DEBUG builds and to eLevelNone otherwise, the OFX_PLUGIN_LOGLEVEL environment variable (0 to 3) overrides the default.
+    */
+    void setLevel(LevelEnum level);
+
+    /** @brief Returns the log level. */
+    LevelEnum getLevel(void);
+
+    /** @brief Whether messages at the given level are logged. */
+    inline bool isEnabled(LevelEnum level)
+    {
+#ifdef OFXS_LOG_ATOMIC_LEVEL
+      return (int)level <= Private::gLevel.load(std::memory_order_relaxed);
+#else
+      return (int)level <= Private::gLevel;
+#endif
+    }
+
+#ifdef OFXS_NO_TRACE
+    /** @brief Tracing was compiled out */
+    inline bool isTracing(void) { return false; }
+
+    inline void indent(void) {}
+
+    inline void outdent(void) {}
+
+    inline void print(const char * /*format*/, ...) {}
+#else
+    /** @brief Whether print() writes anything, use it to guard tracing that is costly to set up */
+    inline bool isTracing(void) { return isEnabled(eLevelTrace); }
+
+    /** @brief Indent it, the indent level is per thread */
     void indent(void);
 
-    /** @brief Outdent it, not MP sane at the moment */
+    /** @brief Outdent it, the indent level is per thread */
     void outdent(void);
 
+    /** @brief Prints to the log file. */
+    void print(const char *format, ...);
+#endif
+
     /** @brief Sets the name of the log file. */
     void setFileName(const std::string &value);
 
@@ -61,9 +127,6 @@ namespace OFX {
     /** @brief Closes the log file. */
     void close(void);
 
-    /** @brief Prints to the log file. */
-    void print(const char *format, ...);
-
     /** @brief Prints to the log file only if the condition is true and prepends a warning notice. */
     void warning(bool condition, const char *format, ...);
 
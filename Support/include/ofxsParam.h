@@ -1205,6 +1205,7 @@ namespace OFX {
         Param(const ParamSet *paramSet, const std::string &name, ParamTypeEnum type, OfxParamHandle handle);
 
         friend class ParamSet;
+        friend class ParamSnapshot;
     public :
         /** @brief dtor */
         virtual ~Param();
@@ -2357,6 +2358,61 @@ namespace OFX {
         /** @brief Fetch a parametric param */
         ParametricParam* fetchParametricParam(const std::string &name) const;
     };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /** @brief The values of a chosen set of numeric params at one time
+
+    Add the params a render needs once, typically in the effect's constructor. At the start of
+    render, copy the snapshot and call capture() on the copy, then hand the copy to the processors.
+    Worker threads only read plain doubles from it and never call into the host.
+
+    If the host has the parameter batch suite, capture() gets every value in one suite call,
+    otherwise it gets the params one at a time. Each copy holds its own values, so concurrent
+    renders do not share state.
+    */
+    class ParamSnapshot {
+    public :
+        /** @brief ctor, makes an empty snapshot */
+        ParamSnapshot();
+
+        /** @brief add a numeric param (int, double, boolean, choice, their 2D and 3D variants, RGB or RGBA),
+            returns the index to read its values with */
+        int add(Param *param);
+
+        /** @brief get the values of all the params at the given time */
+        void capture(double time);
+
+        /** @brief the time of the last capture */
+        double getTime(void) const {return _time;}
+
+        /** @brief the number of params in the snapshot */
+        int size(void) const {return (int)_params.size();}
+
+        /** @brief the number of values of the param at index */
+        int getDimension(int index) const {return _offsets[index + 1] - _offsets[index];}
+
+        /** @brief the captured values of the param at index */
+        const double *getValues(int index) const {return &_values[_offsets[index]];}
+
+        /** @brief a captured value of a double, RGB or RGBA param */
+        double getDouble(int index, int dim = 0) const {return _values[_offsets[index] + dim];}
+
+        /** @brief a captured value of an int or choice param */
+        int getInt(int index, int dim = 0) const {return (int)_values[_offsets[index] + dim];}
+
+        /** @brief the captured value of a boolean param */
+        bool getBool(int index) const {return _values[_offsets[index]] != 0.;}
+
+    private :
+        /** @brief get the values of the param at index one at a time through the param suite */
+        void captureParam(int index);
+
+        std::vector<Param *> _params;
+        std::vector<int> _offsets; ///< one more than the number of params, the last is the number of values
+        std::vector<double> _values;
+        std::vector<OfxParameterBatchEntry> _entries;
+        double _time;
+    };
 };
 
 // undeclare the protected assign and CC macro
@@ -0,0 +1,95 @@
+
+#ifndef _ofxParameterBatch_h_
+#define _ofxParameterBatch_h_
+
+/*
+Software License :
+
+Copyright (c) 2026, The Open Effects Association Ltd. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name The Foundry Visionmongers Ltd, nor the names of its
+      contributors may be used to endorse or promote products derived from this
+      software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ofxCore.h"
+#include "ofxParam.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @file ofxParameterBatch.h
+
+This file contains an optional suite which lets a plugin get the values of many parameters
+at one time in a single call, rather than calling OfxParameterSuiteV1::paramGetValueAtTime
+once per parameter.
+
+Only numeric parameters can be got this way, that is integer, double, boolean and choice
+parameters, their 2D and 3D variants, and RGB and RGBA parameters. All values are returned
+as doubles, integer, boolean and choice values are converted exactly.
+*/
+
+/** @brief The name of the parameter batch suite, used to fetch from a host via
+    OfxHost::fetchSuite
+ */
+#define kOfxParameterBatchSuite "OfxParameterBatchSuite"
+
+/** @brief One parameter to get in a batch */
+typedef struct OfxParameterBatchEntry
+{
+  OfxParamHandle param;  /**< handle of the parameter */
+  int            count;  /**< number of values, which must be the dimension of the parameter */
+  double        *values; /**< where to put the values, an array of count doubles */
+  OfxStatus      status; /**< set by the host to the status paramGetValueAtTime would have returned for this entry */
+} OfxParameterBatchEntry;
+
+/** @brief OFX suite that gets the values of many parameters in one call
+ */
+typedef struct OfxParameterBatchSuiteV1
+{
+  /** @brief Get the values of many parameters at a time
+
+      \arg time - the time to get the values at
+      \arg entries - the parameters to get
+      \arg count - the number of entries
+
+      Each entry is got as paramGetValueAtTime would get it, and its status is set to what that
+      would have returned. An entry whose parameter is not numeric gets ::kOfxStatErrUnsupported,
+      one whose count is not the parameter's dimension gets ::kOfxStatErrValue.
+
+  @returns
+    - ::kOfxStatOK - all the entries were got
+    - ::kOfxStatFailed - at least one of the entries failed, check their status
+    - ::kOfxStatErrValue - the time is not a number
+  */
+  OfxStatus (*paramGetValueBatchAtTime)(OfxTime time,
+                                        OfxParameterBatchEntry *entries,
+                                        int count);
+} OfxParameterBatchSuiteV1;
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif
@@ -0,0 +1,103 @@
+
+#ifndef _ofxPropertyBatch_h_
+#define _ofxPropertyBatch_h_
+
+/*
+Software License :
+
+Copyright (c) 2026, The Open Effects Association Ltd. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name The Foundry Visionmongers Ltd, nor the names of its
+      contributors may be used to endorse or promote products derived from this
+      software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ofxCore.h"
+#include "ofxProperty.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @file ofxPropertyBatch.h
+
+This file contains an optional suite which lets a plugin get many properties from a
+property set in a single call, rather than calling the property suite once per property.
+
+A plugin typically reads ten or so properties from every image it fetches, so a plugin
+that fetches many small images, eg: tiles, spends a lot of its time going back and forth
+across the API. Each property in a batch is read exactly as OfxPropertySuiteV1::propGetIntN
+and friends would read it.
+*/
+
+/** @brief The name of the property batch suite, used to fetch from a host via
+    OfxHost::fetchSuite
+ */
+#define kOfxPropertyBatchSuite "OfxPropertyBatchSuite"
+
+/** @brief Types of property in an ::OfxPropertyBatchEntry */
+#define kOfxPropertyBatchTypeInt     0 /**< int, values points to ints */
+#define kOfxPropertyBatchTypeDouble  1 /**< double, values points to doubles */
+#define kOfxPropertyBatchTypeString  2 /**< string, values points to char pointers */
+#define kOfxPropertyBatchTypePointer 3 /**< pointer, values points to void pointers */
+
+/** @brief One property to get in a batch */
+typedef struct OfxPropertyBatchEntry
+{
+  const char *name;   /**< name of the property */
+  int         type;   /**< one of the kOfxPropertyBatchType defines */
+  int         count;  /**< number of values to get, from index 0 */
+  void       *values; /**< where to put the values, an array of count values of the type */
+  OfxStatus   status; /**< set by the host to the status propGetN would have returned for this entry */
+} OfxPropertyBatchEntry;
+
+/** @brief OFX suite that gets many properties in one call
+ */
+typedef struct OfxPropertyBatchSuiteV1
+{
+  /** @brief Get the values of many properties
+
+      \arg properties - handle of the thing holding the properties
+      \arg entries - the properties to get
+      \arg count - the number of entries
+
+      Each entry is got as the property suite's propGetN function of its type would get it,
+      and its status is set to what that would have returned. Strings returned are owned by
+      the host, as with propGetString.
+
+  @returns
+    - ::kOfxStatOK - all the entries were got
+    - ::kOfxStatFailed - at least one of the entries failed, check their status
+    - ::kOfxStatErrBadHandle - bad handle
+  */
+  OfxStatus (*propGetBatch)(OfxPropertySetHandle properties,
+                            OfxPropertyBatchEntry *entries,
+                            int count);
+} OfxPropertyBatchSuiteV1;
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif